@@ -0,0 +1,380 @@
+/****************************************************************
+  bounded_cache.h
+
+  Memory-bounded block cache for coupling coefficients.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Add Stats.
+  10/16/26 (mac): Size evicted-label tables from cache and age them.
+
+****************************************************************/
+
+#ifndef BOUNDED_CACHE_H_
+#define BOUNDED_CACHE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "boost/functional/hash.hpp"
+
+#include "sp3rlib/coef_cache_stats.h"
+#include "sp3rlib/coef_payload.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // bounded coefficient cache
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  template <typename tLabels, typename tBlock, typename tHash = boost::hash<tLabels> >
+  class BoundedCoefCache
+  // Cache of coefficient blocks, keyed by labels, with a limit on
+  // memory use.
+  //
+  // Intended as a replacement for the unordered_map caches
+  // (UCoefCache, etc.) when the full set of blocks does not fit in
+  // memory.  When inserting a block would take the cache over its
+  // byte budget, blocks are evicted by the CLOCK algorithm: entries
+  // sit on a circular list, each with a reference bit set whenever
+  // the block is retrieved.  The clock hand sweeps the list, clearing
+  // set reference bits and evicting the first entry found with its
+  // bit clear.  Blocks which are in active use thus survive, at the
+  // cost of one bit per entry rather than maintaining an LRU order.
+  //
+  // Memory accounting: Each entry is charged for its coefficient
+  // payload, the block and label objects, and the hash table node,
+  // bucket, and clock slot (see EntryBytes).  This gives the heap
+  // footprint of the entry to within allocator overhead (but does not
+  // include the slack capacity of the slot vector, which is bounded
+  // by the peak number of entries).
+  //
+  // Counters of evictions and of recomputations (misses on labels
+  // which had previously been evicted) are provided for tuning the
+  // budget against the cost of recalculation.  Recomputations are
+  // detected through bit tables of hashes of evicted labels, with
+  // kEvictedBitsPerSlot bits per clock slot.  A table is retired once
+  // it has recorded one eviction per kEvictedBitsPerMark bits, and
+  // the current and previous tables are consulted, so at least the
+  // last kEvictedBitsPerSlot/kEvictedBitsPerMark (=4) cache-fulls of
+  // evictions are remembered (a recomputation of a block evicted
+  // longer ago goes uncounted), while the rate of false positives
+  // stays below about 1 in 8 however long the cache runs.  The tables
+  // (16 bytes per slot) are not charged against the byte budget.
+  //
+  // Not thread-safe.
+  //
+  // EX:
+  //   u3::BoundedUCoefCache cache(std::size_t(4)<<30);  // 4 GiB
+  //   double coef = u3::UCached(cache,x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+  //   std::cout << cache.evictions() << " " << cache.recomputes() << std::endl;
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    explicit BoundedCoefCache(std::size_t byte_budget)
+    // Construct empty cache.
+    //
+    // Arguments:
+    //   byte_budget (std::size_t): maximum memory to be used by
+    //     entries (a single block larger than the budget is still
+    //     cached, after evicting all others)
+      : byte_budget_(byte_budget), bytes_(0), hand_(0),
+        hits_(0), misses_(0), evictions_(0), recomputes_(0),
+        evicted_marks_(0)
+    {}
+
+    ////////////////////////////////////////////////////////////////
+    // retrieval
+    ////////////////////////////////////////////////////////////////
+
+    const tBlock& GetBlock(const tLabels& labels)
+    // Retrieve block for given labels, constructing it if not already
+    // cached.
+    //
+    // The returned reference remains valid only until the next call
+    // to GetBlock, which may evict the block.
+    {
+      auto it = index_.find(labels);
+      if (it!=index_.end())
+        {
+          ++hits_;
+          Slot& slot = slots_[it->second];
+          slot.referenced = true;
+          return slot.block;
+        }
+
+      // miss
+      ++misses_;
+      const std::size_t hash = tHash()(labels);
+      if (TestEvicted(hash))
+        ++recomputes_;
+      tBlock block(labels);
+      const std::size_t entry_bytes = EntryBytes(block);
+
+      // make room
+      while ((bytes_+entry_bytes>byte_budget_)&&!index_.empty())
+        Evict();
+
+      // insert
+      std::size_t position;
+      if (free_slots_.empty())
+        {
+          position = slots_.size();
+          slots_.emplace_back();
+        }
+      else
+        {
+          position = free_slots_.back();
+          free_slots_.pop_back();
+        }
+      Slot& slot = slots_[position];
+      slot.occupied = true;
+      slot.referenced = false;
+      slot.labels = &(index_.emplace(labels,position).first->first);
+      slot.block = std::move(block);
+      slot.bytes = entry_bytes;
+      bytes_ += entry_bytes;
+      return slot.block;
+    }
+
+    bool Contains(const tLabels& labels) const
+    // Check if block for given labels is currently cached.
+    {
+      return index_.count(labels)>0;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    std::size_t size() const
+    // Return number of cached blocks.
+    {
+      return index_.size();
+    }
+
+    std::size_t bytes() const
+    // Return memory charged to cached blocks.
+    {
+      return bytes_;
+    }
+
+    std::size_t byte_budget() const
+    {
+      return byte_budget_;
+    }
+
+    void set_byte_budget(std::size_t byte_budget)
+    // Change budget, evicting blocks as needed to meet it.
+    {
+      byte_budget_ = byte_budget;
+      while ((bytes_>byte_budget_)&&!index_.empty())
+        Evict();
+    }
+
+    long hits() const
+    {
+      return hits_;
+    }
+
+    long misses() const
+    {
+      return misses_;
+    }
+
+    long evictions() const
+    {
+      return evictions_;
+    }
+
+    long recomputes() const
+    {
+      return recomputes_;
+    }
+
+    static std::size_t EntryBytes(const tBlock& block)
+    // Return memory charged for entry holding given block.
+    //
+    // This is the coefficient payload, plus the clock slot (holding
+    // the block object), plus the hash table node (label object, slot
+    // position, next pointer, and cached hash code) and bucket
+    // pointer (at load factor 1).
+    {
+      return u3::CoefPayloadBytes(block.size())
+        + sizeof(Slot)
+        + sizeof(typename IndexType::value_type)+sizeof(void*)+sizeof(std::size_t)
+        + sizeof(void*);
+    }
+
+    u3::CoefCacheStats Stats() const
+    // Return snapshot of cache statistics.
+    {
+      u3::CoefCacheStats stats;
+      stats.hits = hits_;
+      stats.misses = misses_;
+      stats.evictions = evictions_;
+      stats.recomputes = recomputes_;
+      for (const Slot& slot : slots_)
+        if (slot.occupied)
+          stats.AddBlock(slot.block.size(),slot.bytes);
+      return stats;
+    }
+
+    void clear()
+    // Release all blocks and reset counters.
+    {
+      index_.clear();
+      slots_.clear();
+      free_slots_.clear();
+      bytes_ = 0;
+      hand_ = 0;
+      hits_ = misses_ = evictions_ = recomputes_ = 0;
+      evicted_.clear();
+      previous_evicted_.clear();
+      evicted_marks_ = 0;
+    }
+
+  private:
+
+    ////////////////////////////////////////////////////////////////
+    // internal data structures
+    ////////////////////////////////////////////////////////////////
+
+    struct Slot
+    // Clock slot.
+    {
+      Slot() : occupied(false), referenced(false), labels(nullptr), bytes(0) {}
+
+      bool occupied;
+      bool referenced;
+      const tLabels* labels;  // key in index (stable under rehashing)
+      tBlock block;
+      std::size_t bytes;
+    };
+
+    typedef std::unordered_map<tLabels,std::size_t,tHash> IndexType;
+
+    static const std::size_t kEvictedBitsPerSlot = 64;
+    static const std::size_t kEvictedBitsPerMark = 16;
+
+    ////////////////////////////////////////////////////////////////
+    // internal operations
+    ////////////////////////////////////////////////////////////////
+
+    void Evict()
+    // Advance clock hand to next unreferenced entry and evict it.
+    //
+    // Precondition: cache not empty
+    {
+      while (true)
+        {
+          if (hand_>=slots_.size())
+            hand_ = 0;
+          Slot& slot = slots_[hand_];
+          if (slot.occupied)
+            {
+              if (slot.referenced)
+                slot.referenced = false;
+              else
+                {
+                  MarkEvicted(tHash()(*slot.labels));
+                  index_.erase(index_.find(*slot.labels));
+                  bytes_ -= slot.bytes;
+                  slot.occupied = false;
+                  slot.block = tBlock();
+                  free_slots_.push_back(hand_);
+                  ++evictions_;
+                  ++hand_;
+                  return;
+                }
+            }
+          ++hand_;
+        }
+    }
+
+    void AgeEvicted()
+    // Retire current table of evicted labels to previous, discarding
+    // old previous table, and start new current table sized for
+    // present number of slots.
+    {
+      previous_evicted_.swap(evicted_);
+      std::size_t num_bits = 64;
+      while (num_bits<kEvictedBitsPerSlot*slots_.size())
+        num_bits <<= 1;
+      evicted_.assign(num_bits/64,0);
+      evicted_marks_ = 0;
+    }
+
+    void MarkEvicted(std::size_t hash)
+    {
+      if (evicted_marks_*kEvictedBitsPerMark>=evicted_.size()*64)
+        AgeEvicted();
+      SetBit(evicted_,hash);
+      ++evicted_marks_;
+    }
+
+    bool TestEvicted(std::size_t hash) const
+    {
+      return TestBit(evicted_,hash) || TestBit(previous_evicted_,hash);
+    }
+
+    static void SetBit(std::vector<std::uint64_t>& table, std::size_t hash)
+    // Set bit for hash in table (of power-of-two size).
+    {
+      const std::size_t bit = hash&(table.size()*64-1);
+      table[bit/64] |= (std::uint64_t(1)<<(bit%64));
+    }
+
+    static bool TestBit(const std::vector<std::uint64_t>& table, std::size_t hash)
+    // Test bit for hash in table (of power-of-two size), or return
+    // false if table is empty.
+    {
+      if (table.empty())
+        return false;
+      const std::size_t bit = hash&(table.size()*64-1);
+      return (table[bit/64]>>(bit%64))&1;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // data
+    ////////////////////////////////////////////////////////////////
+
+    // budget and usage
+    std::size_t byte_budget_, bytes_;
+
+    // entries
+    IndexType index_;
+    std::vector<Slot> slots_;
+    std::vector<std::size_t> free_slots_;
+    std::size_t hand_;
+
+    // statistics
+    long hits_, misses_, evictions_, recomputes_;
+
+    // bit tables of hashes of evicted labels (current and previous),
+    // and number of evictions recorded in current table
+    std::vector<std::uint64_t> evicted_, previous_evicted_;
+    std::size_t evicted_marks_;
+  };
+
+  template <typename tLabels, typename tBlock, typename tHash>
+    const std::size_t BoundedCoefCache<tLabels,tBlock,tHash>::kEvictedBitsPerSlot;
+  template <typename tLabels, typename tBlock, typename tHash>
+    const std::size_t BoundedCoefCache<tLabels,tBlock,tHash>::kEvictedBitsPerMark;
+
+}  // namespace
+
+#endif
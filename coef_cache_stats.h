@@ -0,0 +1,93 @@
+/****************************************************************
+  coef_cache_stats.h
+
+  Statistics for coupling coefficient caches.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Add recomputes.
+
+****************************************************************/
+
+#ifndef COEF_CACHE_STATS_H_
+#define COEF_CACHE_STATS_H_
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // cache statistics
+  ////////////////////////////////////////////////////////////////
+
+  struct CoefCacheStats
+  // Snapshot of usage statistics for a coefficient cache.
+  //
+  // Obtained from the Stats() member of the cache classes
+  // (CoefCache, ConcurrentCoefCache, BoundedCoefCache).  Hits and
+  // misses are accumulated as blocks are retrieved, while the
+  // remaining fields are tallied over the cached blocks when the
+  // snapshot is taken.
+  {
+    CoefCacheStats()
+      : hits(0), misses(0), evictions(0), recomputes(0), blocks(0), coefs(0), bytes(0)
+    {}
+
+    void AddBlock(std::size_t block_size, std::size_t entry_bytes)
+    // Tally cached block.
+    //
+    // Arguments:
+    //   block_size (std::size_t): number of coefficients in block
+    //   entry_bytes (std::size_t): memory used by cache entry
+    {
+      ++blocks;
+      coefs += block_size;
+      bytes += entry_bytes;
+      ++block_size_histogram[block_size];
+    }
+
+    double HitRate() const
+    // Return fraction of lookups which were hits (or 0, if no
+    // lookups have been made).
+    {
+      return (hits+misses) ? double(hits)/(hits+misses) : 0.;
+    }
+
+    void Report(std::ostream& os, const std::string& name) const
+    // Write statistics, as lines of "keyword value(s)", prefixed by
+    // cache name.
+    {
+      os << name << " hits " << hits << std::endl;
+      os << name << " misses " << misses << std::endl;
+      os << name << " hit_rate " << HitRate() << std::endl;
+      os << name << " evictions " << evictions << std::endl;
+      os << name << " recomputes " << recomputes << std::endl;
+      os << name << " blocks " << blocks << std::endl;
+      os << name << " coefs " << coefs << std::endl;
+      os << name << " bytes " << bytes << std::endl;
+      for (const auto& size_count : block_size_histogram)
+        os << name << " block_size " << size_count.first << " " << size_count.second << std::endl;
+    }
+
+    // retrieval counters (evictions and recomputes are only counted
+    // by BoundedCoefCache)
+    long hits, misses, evictions, recomputes;
+
+    // cached blocks
+    std::size_t blocks, coefs, bytes;
+
+    // number of cached blocks, by number of coefficients in block
+    std::map<std::size_t,std::size_t> block_size_histogram;
+  };
+
+}  // namespace
+
+#endif
@@ -0,0 +1,245 @@
+/****************************************************************
+  coef_payload.h
+
+  Compact storage for coefficient values of coupling coefficient
+  blocks.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+
+****************************************************************/
+
+#ifndef COEF_PAYLOAD_H_
+#define COEF_PAYLOAD_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // coefficient arena
+  ////////////////////////////////////////////////////////////////
+
+  class CoefArena
+  // Chunked bump allocator for coefficient values.
+  //
+  // Storage is allocated in large chunks, which are carved into
+  // payloads back to back and released only when the arena is
+  // cleared or destroyed.  Chunks never move, so pointers into the
+  // arena remain valid until then.
+  //
+  // Not thread-safe.
+  {
+  public:
+
+    explicit CoefArena(std::size_t chunk_size = 8192)
+    // Construct empty arena.
+    //
+    // Arguments:
+    //   chunk_size (std::size_t, optional): number of doubles per
+    //     chunk (larger requests get a chunk of their own)
+      : chunk_size_(chunk_size), position_(nullptr), remaining_(0), capacity_(0)
+    {}
+
+    // not copyable (payloads point into chunks)
+    CoefArena(const CoefArena&) = delete;
+    CoefArena& operator=(const CoefArena&) = delete;
+    CoefArena(CoefArena&&) = default;
+    CoefArena& operator=(CoefArena&&) = default;
+
+    double* Allocate(std::size_t size)
+    // Return storage for size doubles.
+    {
+      if (size>remaining_)
+        {
+          std::size_t chunk_size = std::max(chunk_size_,size);
+          chunks_.emplace_back(new double[chunk_size]);
+          position_ = chunks_.back().get();
+          remaining_ = chunk_size;
+          capacity_ += chunk_size;
+        }
+      double* storage = position_;
+      position_ += size;
+      remaining_ -= size;
+      return storage;
+    }
+
+    std::size_t bytes() const
+    // Return memory held by chunks.
+    {
+      return capacity_*sizeof(double);
+    }
+
+    void clear()
+    // Release all chunks.
+    {
+      chunks_.clear();
+      position_ = nullptr;
+      remaining_ = capacity_ = 0;
+    }
+
+  private:
+    std::size_t chunk_size_;
+    std::vector<std::unique_ptr<double[]>> chunks_;
+    double* position_;
+    std::size_t remaining_, capacity_;
+  };
+
+  ////////////////////////////////////////////////////////////////
+  // coefficient payload
+  ////////////////////////////////////////////////////////////////
+
+  class CoefPayload
+  // Coefficient values of a block.
+  //
+  // Replaces std::vector<double> as the storage of the block classes
+  // (UCoefBlock, etc.), in 16 bytes rather than a 24-byte vector
+  // header plus heap allocation:
+  //
+  //   - A single coefficient (the common case) is stored inline.
+  //
+  //   - Larger payloads are held on the heap, or, once moved into a
+  //     cache's arena (MoveToArena), in the arena.  A payload in an
+  //     arena does not own its storage, so it must not outlive the
+  //     arena.  Copying a payload always gives an independent
+  //     (heap-owned) copy, so blocks copied out of a cache are safe.
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    CoefPayload()
+      : size_(0), owned_(false)
+    {
+      storage_.value = 0.;
+    }
+
+    CoefPayload(const double* coefs, std::size_t size)
+      : CoefPayload()
+    // Construct copy of given coefficient values.
+    {
+      assign(coefs,size);
+    }
+
+    CoefPayload(const CoefPayload& payload)
+      : CoefPayload()
+    {
+      assign(payload.data(),payload.size());
+    }
+
+    CoefPayload(CoefPayload&& payload)
+      : CoefPayload()
+    {
+      swap(payload);
+    }
+
+    CoefPayload& operator=(CoefPayload payload)
+    {
+      swap(payload);
+      return *this;
+    }
+
+    ~CoefPayload()
+    {
+      Release();
+    }
+
+    void assign(const double* coefs, std::size_t size)
+    // Replace contents with copy of given coefficient values.
+    {
+      Release();
+      assert(size<=std::numeric_limits<std::uint32_t>::max());
+      size_ = std::uint32_t(size);
+      if (size_<=1)
+        {
+          owned_ = false;
+          storage_.value = size_ ? coefs[0] : 0.;
+        }
+      else
+        {
+          owned_ = true;
+          storage_.pointer = new double[size_];
+          std::copy(coefs,coefs+size_,storage_.pointer);
+        }
+    }
+
+    void swap(CoefPayload& payload)
+    {
+      std::swap(size_,payload.size_);
+      std::swap(owned_,payload.owned_);
+      std::swap(storage_,payload.storage_);
+    }
+
+    void MoveToArena(u3::CoefArena& arena)
+    // Move heap-held values into arena (no-op for inline or
+    // arena-held values).
+    {
+      if (!owned_)
+        return;
+      double* storage = arena.Allocate(size_);
+      std::copy(storage_.pointer,storage_.pointer+size_,storage);
+      delete[] storage_.pointer;
+      storage_.pointer = storage;
+      owned_ = false;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // access
+    ////////////////////////////////////////////////////////////////
+
+    const double* data() const
+    {
+      return (size_<=1) ? &storage_.value : storage_.pointer;
+    }
+
+    std::size_t size() const
+    {
+      return size_;
+    }
+
+    double operator[](std::size_t index) const
+    {
+      return data()[index];
+    }
+
+  private:
+
+    void Release()
+    {
+      if (owned_)
+        delete[] storage_.pointer;
+      owned_ = false;
+    }
+
+    std::uint32_t size_;
+    bool owned_;  // whether storage_.pointer is heap allocation to be freed
+    union Storage
+    {
+      double value;  // size_<=1
+      double* pointer;  // size_>1
+    } storage_;
+  };
+
+  inline std::size_t CoefPayloadBytes(std::size_t size)
+  // Return memory used for coefficient values outside the payload
+  // object itself (none for inline values).
+  {
+    return (size>1) ? size*sizeof(double) : 0;
+  }
+
+}  // namespace
+
+#endif
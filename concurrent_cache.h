@@ -0,0 +1,505 @@
+/****************************************************************
+  concurrent_cache.h
+
+  Thread-safe block cache for coupling coefficients.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Add hit and miss counters.
+  10/16/26 (mac): Count hits in per-thread counters.
+
+****************************************************************/
+
+#ifndef CONCURRENT_CACHE_H_
+#define CONCURRENT_CACHE_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "boost/functional/hash.hpp"
+
+#include "sp3rlib/coef_cache_stats.h"
+#include "sp3rlib/coef_payload.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // concurrent coefficient cache
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  template <typename tLabels, typename tBlock, typename tHash = boost::hash<tLabels> >
+  class ConcurrentCoefCache
+  // Thread-safe cache of coefficient blocks, keyed by labels.
+  //
+  // Intended as a drop-in for the unordered_map caches (UCoefCache,
+  // etc.) when coefficients are requested from within OpenMP parallel
+  // regions.
+  //
+  // Organization: The cache is divided into shards, selected by the
+  // low bits of the label hash.  Each shard holds an open-addressing
+  // (linear probing) table of pointers to entries.  Entries are
+  // allocated individually and never move or are freed until the
+  // cache is cleared or destroyed, so references to blocks remain
+  // valid.
+  //
+  // Concurrency:
+  //
+  //   - Hits are lock-free.  A reader loads the shard's current table
+  //     and probes it with atomic loads.  It never takes a lock or
+  //     waits on a writer, once the block is ready.
+  //
+  //   - Insertion takes the shard's mutex, but only to claim a slot
+  //     for the new entry.  The table is grown by allocating a new
+  //     table and publishing it atomically.  Retired tables (arrays of
+  //     pointers only) are retained until the cache is cleared, since
+  //     readers may still be probing them.
+  //
+  //   - The block itself is constructed outside the shard lock, under
+  //     a per-entry std::once_flag.  If several threads miss on the
+  //     same labels, one constructs the block and the others wait for
+  //     it, so each block is computed exactly once.
+  //
+  //   - Hits are counted in per-thread counters, each written only by
+  //     its own thread, and summed when statistics are requested, so
+  //     that counting does not make concurrent readers contend for a
+  //     shared cache line.  Misses are counted per shard, under the
+  //     shard's mutex.
+  //
+  //   - Note that the cache does not make block construction itself
+  //     concurrent.  For the su3lib coefficient blocks, construction
+  //     takes the global su3lib lock (see u3coef.h), so misses on
+  //     different labels are still computed one at a time.
+  //
+  // Template parameters:
+  //   tLabels: label type, with operator== and hash
+  //   tBlock: block type, default constructible and constructible
+  //     from tLabels
+  //   tHash: hash function object for tLabels
+  //
+  // EX:
+  //   u3::ConcurrentUCoefCache cache;
+  //   #pragma omp parallel for
+  //   for (...)
+  //     {
+  //       const u3::UCoefBlock& block = cache.GetBlock(labels);
+  //       ...
+  //     }
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    explicit ConcurrentCoefCache(int num_shards = 64)
+    // Construct empty cache.
+    //
+    // Arguments:
+    //   num_shards (int, optional): number of shards (rounded up to
+    //     power of 2)
+      : shard_bits_(0), cache_id_(NextCacheId())
+    {
+      while ((1<<shard_bits_)<num_shards)
+        ++shard_bits_;
+      shards_ = std::vector<Shard>(std::size_t(1)<<shard_bits_);
+      for (Shard& shard : shards_)
+        shard.Reset();
+    }
+
+    // not copyable (entries are referenced by pointer)
+    ConcurrentCoefCache(const ConcurrentCoefCache&) = delete;
+    ConcurrentCoefCache& operator=(const ConcurrentCoefCache&) = delete;
+
+    ////////////////////////////////////////////////////////////////
+    // retrieval
+    ////////////////////////////////////////////////////////////////
+
+    const tBlock& GetBlock(const tLabels& labels)
+    // Retrieve block for given labels, constructing it if not already
+    // cached.
+    //
+    // Thread-safe.  The returned reference remains valid until the
+    // cache is cleared or destroyed.
+    {
+      const std::size_t hash = tHash()(labels);
+      Shard& shard = shards_[hash&((std::size_t(1)<<shard_bits_)-1)];
+
+      // fast path: lock-free probe
+      Entry* entry = Find(*shard.table.load(std::memory_order_acquire),hash,labels);
+
+      // slow path: insert entry
+      if (entry)
+        CountHit();
+      else
+        entry = Insert(shard,hash,labels);
+
+      // construct block (exactly once)
+      if (!entry->ready.load(std::memory_order_acquire))
+        {
+          std::call_once(
+              entry->once,
+              [entry]()
+              {
+                entry->block = tBlock(entry->labels);
+                entry->ready.store(true,std::memory_order_release);
+              }
+            );
+        }
+      return entry->block;
+    }
+
+    bool Contains(const tLabels& labels) const
+    // Check if block for given labels has been constructed.
+    //
+    // Thread-safe.
+    {
+      const std::size_t hash = tHash()(labels);
+      const Shard& shard = shards_[hash&((std::size_t(1)<<shard_bits_)-1)];
+      const Entry* entry = Find(*shard.table.load(std::memory_order_acquire),hash,labels);
+      return entry && entry->ready.load(std::memory_order_acquire);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    std::size_t size() const
+    // Return number of entries.
+    //
+    // Not synchronized with concurrent insertion.
+    {
+      std::size_t count = 0;
+      for (const Shard& shard : shards_)
+        count += shard.entries.size();
+      return count;
+    }
+
+    int num_shards() const
+    {
+      return int(shards_.size());
+    }
+
+    template <typename tFunction>
+      void ForEach(tFunction function) const
+    // Invoke function(labels,block) for each constructed entry.
+    //
+    // Not thread-safe with respect to concurrent insertion.
+    {
+      for (const Shard& shard : shards_)
+        for (const std::unique_ptr<Entry>& entry : shard.entries)
+          if (entry->ready.load(std::memory_order_acquire))
+            function(entry->labels,entry->block);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // statistics
+    ////////////////////////////////////////////////////////////////
+
+    long hits() const
+    // Return number of lookups finding an existing entry (including
+    // those which then wait for another thread to construct the
+    // block).
+    {
+      std::lock_guard<std::mutex> lock(hit_counters_mutex_);
+      long count = 0;
+      for (const auto& thread_counter : hit_counters_)
+        count += thread_counter.second->count.load(std::memory_order_relaxed);
+      return count;
+    }
+
+    long misses() const
+    // Return number of lookups creating an entry.
+    {
+      long count = 0;
+      for (const Shard& shard : shards_)
+        count += shard.misses.load(std::memory_order_relaxed);
+      return count;
+    }
+
+    void ResetStats()
+    // Reset hit and miss counters.
+    //
+    // Not synchronized with concurrent retrieval (a hit counted at the
+    // same time may survive the reset).
+    {
+      for (Shard& shard : shards_)
+        shard.misses.store(0,std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(hit_counters_mutex_);
+      for (auto& thread_counter : hit_counters_)
+        thread_counter.second->count.store(0,std::memory_order_relaxed);
+    }
+
+    static std::size_t EntryBytes(const tBlock& block)
+    // Return memory used by entry holding given block.
+    //
+    // This is the coefficient payload, plus the entry object, its
+    // owning pointer, and two table slots (at the maximum load factor
+    // of 1/2).
+    {
+      return u3::CoefPayloadBytes(block.size())
+        + sizeof(Entry)+sizeof(std::unique_ptr<Entry>)
+        + 2*sizeof(std::atomic<Entry*>);
+    }
+
+    u3::CoefCacheStats Stats() const
+    // Return snapshot of cache statistics.
+    //
+    // Not synchronized with concurrent insertion.
+    {
+      u3::CoefCacheStats stats;
+      stats.hits = hits();
+      stats.misses = misses();
+      ForEach(
+          [&stats](const tLabels&, const tBlock& block)
+          {stats.AddBlock(block.size(),EntryBytes(block));}
+        );
+      return stats;
+    }
+
+    void clear()
+    // Release all entries.
+    //
+    // Not thread-safe.  Invalidates all references to blocks.
+    {
+      for (Shard& shard : shards_)
+        shard.Reset();
+    }
+
+  private:
+
+    ////////////////////////////////////////////////////////////////
+    // internal data structures
+    ////////////////////////////////////////////////////////////////
+
+    struct Entry
+    {
+      Entry(std::size_t hash_, const tLabels& labels_)
+        : hash(hash_), labels(labels_), ready(false)
+      {}
+
+      std::size_t hash;
+      tLabels labels;
+      std::atomic<bool> ready;
+      std::once_flag once;
+      tBlock block;
+    };
+
+    struct Table
+    // Open-addressing table of entry pointers.
+    {
+      explicit Table(std::size_t capacity)
+        : mask(capacity-1), slots(new std::atomic<Entry*>[capacity])
+      {
+        assert((capacity&mask)==0);
+        for (std::size_t i=0; i<capacity; ++i)
+          slots[i].store(nullptr,std::memory_order_relaxed);
+      }
+
+      std::size_t capacity() const
+      {
+        return mask+1;
+      }
+
+      std::size_t mask;
+      std::unique_ptr<std::atomic<Entry*>[]> slots;
+    };
+
+    struct Shard
+    {
+      Shard() : table(nullptr), misses(0) {}
+
+      // vector<Shard> requires a copy constructor, though shards are
+      // only copied while empty
+      Shard(const Shard&) : table(nullptr), misses(0) {}
+
+      void Reset()
+      // Release entries and tables, and allocate fresh table.
+      {
+        entries.clear();
+        tables.clear();
+        tables.emplace_back(new Table(kInitialCapacity));
+        table.store(tables.back().get(),std::memory_order_release);
+      }
+
+      // current table (tables.back())
+      std::atomic<Table*> table;
+
+      // guard for insertion
+      std::mutex mutex;
+
+      // current and retired tables
+      std::vector<std::unique_ptr<Table>> tables;
+
+      // entries (owned)
+      std::vector<std::unique_ptr<Entry>> entries;
+
+      // statistics (updated under mutex)
+      std::atomic<long> misses;
+    };
+
+    struct HitCounter
+    // Hit counter written by a single thread (padded, so that
+    // counters of different threads do not share a cache line).
+    {
+      HitCounter() : count(0) {}
+
+      char padding_before[64];
+      std::atomic<long> count;
+      char padding_after[64];
+    };
+
+    static const std::size_t kInitialCapacity = 16;
+
+    // size of each thread's table of hit counters for recently used
+    // caches (power of 2)
+    static const std::size_t kLocalHitCounters = 8;
+
+    ////////////////////////////////////////////////////////////////
+    // internal operations
+    ////////////////////////////////////////////////////////////////
+
+    std::size_t Home(const Table& table, std::size_t hash) const
+    // Return starting probe position for hash, using the bits above
+    // those used to select the shard.
+    {
+      return (hash>>shard_bits_)&table.mask;
+    }
+
+    Entry* Find(const Table& table, std::size_t hash, const tLabels& labels) const
+    // Probe table for entry (lock-free).
+    {
+      for (std::size_t i = Home(table,hash); ; i = (i+1)&table.mask)
+        {
+          Entry* entry = table.slots[i].load(std::memory_order_acquire);
+          if (!entry)
+            return nullptr;
+          if ((entry->hash==hash)&&(entry->labels==labels))
+            return entry;
+        }
+    }
+
+    void Place(Table& table, Entry* entry) const
+    // Store entry pointer in first free slot.
+    //
+    // Precondition: shard mutex held
+    {
+      std::size_t i = Home(table,entry->hash);
+      while (table.slots[i].load(std::memory_order_relaxed))
+        i = (i+1)&table.mask;
+      table.slots[i].store(entry,std::memory_order_release);
+    }
+
+    static std::uint64_t NextCacheId()
+    // Return unique (nonzero) identifier for new cache, distinguishing
+    // it from any earlier cache which occupied the same address.
+    {
+      static std::atomic<std::uint64_t> next_cache_id(1);
+      return next_cache_id.fetch_add(1,std::memory_order_relaxed);
+    }
+
+    HitCounter* LocalHitCounter() const
+    // Return calling thread's hit counter for this cache, registering
+    // a new counter on the thread's first hit.
+    //
+    // The thread keeps pointers to its counters for recently used
+    // caches in a small thread-local table, indexed by cache
+    // identifier, so only the first hit (or a hit after the pointer
+    // has been displaced by another cache's) takes the mutex.
+    {
+      struct LocalEntry
+      {
+        std::uint64_t cache_id;
+        HitCounter* counter;
+      };
+      static thread_local LocalEntry local_counters[kLocalHitCounters] = {};
+      LocalEntry& local_entry = local_counters[cache_id_&(kLocalHitCounters-1)];
+      if (local_entry.cache_id!=cache_id_)
+        {
+          std::lock_guard<std::mutex> lock(hit_counters_mutex_);
+          std::unique_ptr<HitCounter>& counter = hit_counters_[std::this_thread::get_id()];
+          if (!counter)
+            counter.reset(new HitCounter);
+          local_entry.cache_id = cache_id_;
+          local_entry.counter = counter.get();
+        }
+      return local_entry.counter;
+    }
+
+    void CountHit() const
+    // Increment calling thread's hit counter.
+    //
+    // Only the owning thread writes the counter, so a relaxed load and
+    // store suffice (no atomic read-modify-write is needed).
+    {
+      HitCounter* counter = LocalHitCounter();
+      counter->count.store(counter->count.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+    }
+
+    Entry* Insert(Shard& shard, std::size_t hash, const tLabels& labels)
+    // Insert entry for labels, unless another thread has done so in
+    // the meantime.
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      Table* table = shard.tables.back().get();
+
+      // recheck under lock
+      Entry* entry = Find(*table,hash,labels);
+      if (entry)
+        {
+          CountHit();
+          return entry;
+        }
+
+      // grow table to keep load factor at most 1/2
+      if (2*(shard.entries.size()+1)>table->capacity())
+        {
+          shard.tables.emplace_back(new Table(2*table->capacity()));
+          table = shard.tables.back().get();
+          for (const std::unique_ptr<Entry>& old_entry : shard.entries)
+            Place(*table,old_entry.get());
+          shard.table.store(table,std::memory_order_release);
+        }
+
+      // create and publish entry
+      shard.misses.fetch_add(1,std::memory_order_relaxed);
+      shard.entries.emplace_back(new Entry(hash,labels));
+      entry = shard.entries.back().get();
+      Place(*table,entry);
+      return entry;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // data
+    ////////////////////////////////////////////////////////////////
+
+    int shard_bits_;
+    std::vector<Shard> shards_;
+
+    // hit counters, by thread (retained until cache is destroyed, since
+    // threads hold pointers to them)
+    std::uint64_t cache_id_;
+    mutable std::mutex hit_counters_mutex_;
+    mutable std::unordered_map<std::thread::id,std::unique_ptr<HitCounter>> hit_counters_;
+  };
+
+  template <typename tLabels, typename tBlock, typename tHash>
+    const std::size_t ConcurrentCoefCache<tLabels,tBlock,tHash>::kInitialCapacity;
+  template <typename tLabels, typename tBlock, typename tHash>
+    const std::size_t ConcurrentCoefCache<tLabels,tBlock,tHash>::kLocalHitCounters;
+
+}  // namespace
+
+#endif
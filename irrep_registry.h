@@ -0,0 +1,154 @@
+/****************************************************************
+  irrep_registry.h
+
+  Interning of U(3) and SU(3) irrep labels as dense integer ids.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+
+****************************************************************/
+
+#ifndef IRREP_REGISTRY_H_
+#define IRREP_REGISTRY_H_
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "sp3rlib/u3.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // irrep registry
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  template <typename tIrrep>
+  class IrrepRegistry
+  // Registry assigning each distinct irrep a dense integer id.
+  //
+  // Ids are assigned consecutively (0,1,...) in order of first
+  // interning, and remain stable for the lifetime of the registry.
+  // Lookup in either direction is O(1): id->irrep is a vector index,
+  // and irrep->id is a hash lookup on the irrep's packed 64-bit key.
+  //
+  // Tables indexed by tuples of irreps (coefficient caches, subspace
+  // lookups) may then be keyed on tuples of small integers, or
+  // indexed as flat arrays, rather than hashing composite label
+  // tuples.
+  //
+  // Template parameter tIrrep must provide PackedKey() (u3::SU3,
+  // u3::U3, u3::U3S, or u3::U3ST).
+  //
+  // The registry is not thread-safe for Intern.  Concurrent lookups
+  // (LookUpId, GetIrrep) are safe once interning is complete.
+  //
+  // EX:
+  //   u3::SU3Registry registry;
+  //   int id = registry.Intern(u3::SU3(4,2));
+  //   assert(registry.GetIrrep(id)==u3::SU3(4,2));
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // typedefs and constants
+    ////////////////////////////////////////////////////////////////
+
+    typedef int IdType;
+
+    // id returned by LookUpId for irrep not in registry
+    static const IdType kNone = -1;
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    IrrepRegistry() = default;
+
+    ////////////////////////////////////////////////////////////////
+    // interning and lookup
+    ////////////////////////////////////////////////////////////////
+
+    inline IdType Intern(const tIrrep& irrep)
+    // Retrieve id of irrep, assigning a new id if irrep has not been
+    // seen before.
+    {
+      auto result = ids_.emplace(irrep.PackedKey(),IdType(irreps_.size()));
+      if (result.second)
+        irreps_.push_back(irrep);
+      return result.first->second;
+    }
+
+    inline IdType LookUpId(const tIrrep& irrep) const
+    // Retrieve id of irrep, or kNone if irrep has not been interned.
+    {
+      auto it = ids_.find(irrep.PackedKey());
+      if (it==ids_.end())
+        return kNone;
+      return it->second;
+    }
+
+    inline bool Contains(const tIrrep& irrep) const
+    {
+      return ids_.count(irrep.PackedKey())>0;
+    }
+
+    inline const tIrrep& GetIrrep(IdType id) const
+    // Retrieve irrep with given id.
+    {
+      assert((id>=0)&&(id<IdType(irreps_.size())));
+      return irreps_[id];
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    inline std::size_t size() const
+    // Return number of interned irreps.
+    {
+      return irreps_.size();
+    }
+
+    inline const std::vector<tIrrep>& irreps() const
+    // Return interned irreps, indexed by id.
+    {
+      return irreps_;
+    }
+
+    inline void clear()
+    // Release all irreps.  Previously assigned ids become invalid.
+    {
+      irreps_.clear();
+      ids_.clear();
+    }
+
+  private:
+
+    // irreps indexed by id
+    std::vector<tIrrep> irreps_;
+
+    // ids by packed key
+    std::unordered_map<uint64_t,IdType> ids_;
+  };
+
+  template <typename tIrrep>
+  const typename IrrepRegistry<tIrrep>::IdType IrrepRegistry<tIrrep>::kNone;
+
+  // convenience typedefs
+  typedef IrrepRegistry<u3::SU3> SU3Registry;
+  typedef IrrepRegistry<u3::U3> U3Registry;
+  typedef IrrepRegistry<u3::U3S> U3SRegistry;
+
+}  // namespace
+
+#endif
@@ -4,11 +4,11 @@ $(eval $(begin-module))
 # unit definitions
 ################################################################
 
-module_units_h := multiplicity_tagged
-module_units_cpp-h := u3 vcs sp3r u3coef sp3r_operator
+module_units_h := multiplicity_tagged irrep_registry concurrent_cache bounded_cache coef_cache_stats coef_payload
+module_units_cpp-h := u3 u3product vcs sp3r u3coef u3coef_store u3coef_prefill u3coef_native u3coef_backend sp3r_operator
 
 # module_units_f := 
-module_programs_cpp_test := u3_test sp3r_test u3coef_test vcs_test
+module_programs_cpp_test := u3_test sp3r_test u3coef_test vcs_test u3_benchmark u3_allocation_test u3coef_benchmark u3coef_store_test u3coef_prefill_test u3coef_symmetry_test u3coef_native_test u3coef_backend_test
 # module_programs_f :=
 # module_generated :=
 
@@ -131,10 +131,11 @@
     //   for each allowed coupling omega
     //      store to states multimap as key value pair
     //        omega -> (n,rho_max)
+      u3::U3ProductBuffer omega_tagged_vec;  // reused across raising polynomials
       for (auto n_iter = n_vec.begin(); n_iter != n_vec.end(); ++n_iter)
       {
        u3::U3 n = (*n_iter);
-       MultiplicityTagged<u3::U3>::vector omega_tagged_vec = KroneckerProduct(sigma,n);
+       KroneckerProduct(sigma,n,omega_tagged_vec);
        for (
         auto omega_tagged_iter = omega_tagged_vec.begin();
         omega_tagged_iter != omega_tagged_vec.end();
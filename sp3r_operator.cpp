@@ -117,7 +117,7 @@ namespace sp3r
   //   double rme=0;
   //   if(
   //       (sigmap==sigma)
-  //       &&(u3::OuterMultiplicity(omega.SU3(),u3::SU3(2,0),omegap.SU3())!=0)
+  //       &&(u3::OuterMultiplicity<2,0>(omega.SU3(),omegap.SU3())!=0)
   //       && ((omega.N()+2)==omegap.N())
   //     )
   //       rme=sqrt(vcs::Omega(np_rhop.irrep, omegap)-vcs::Omega(n_rho.irrep, omega))
@@ -135,7 +135,7 @@ namespace sp3r
   //   double rme=0;
   //   if(
   //       (sigmap==sigma)
-  //       &&(u3::OuterMultiplicity(omega.SU3(),u3::SU3(0,2),omegap.SU3())!=0)
+  //       &&(u3::OuterMultiplicity<0,2>(omega.SU3(),omegap.SU3())!=0)
   //       && ((omega.N()-2)==omegap.N())
   //     )
   //       rme=parity(u3::ConjugationGrade(omegap))//.lambda()+omegap.mu+omega.lambda+omega.mu)
@@ -54,9 +54,11 @@ namespace sp3r
     {
       // TODO: Finish debugging
       std::vector<u3::U3> poly_vector=RaisingPolynomialLabels(Nmax);
+      // product buffers, reused across iterations
+      u3::SU3ProductBuffer n1p_set, n3_set, n3p_set;
       for(auto n1 : poly_vector)
         {
-          MultiplicityTagged<u3::SU3>::vector n1p_set=u3::KroneckerProduct(n1.SU3(),u3::SU3(0,2));
+          n1p_set = u3::KroneckerProduct<0,2>(n1.SU3());
           int N1p=int(n1.N()-2);
           u3::U3 n1p;
           bool continue_flag=true;
@@ -75,8 +77,8 @@ namespace sp3r
           double coef1=vcs::BosonCreationRME(n1,n1p);
           for(auto n2 : poly_vector)
             {
-              MultiplicityTagged<u3::SU3>::vector n3_set=u3::KroneckerProduct(n1.SU3(),n2.SU3());
-              MultiplicityTagged<u3::SU3>::vector n3p_set=u3::KroneckerProduct(n1p.SU3(),n2.SU3());
+              u3::KroneckerProduct(n1.SU3(),n2.SU3(),n3_set);
+              u3::KroneckerProduct(n1p.SU3(),n2.SU3(),n3p_set);
               int N3=int(n1.N()+n2.N());
               int N3p=N3-2;
               for(auto n3_tagged :n3_set)
@@ -105,7 +107,7 @@ namespace sp3r
                             continue;
                           if((n3p.SU3().lambda()%2!=0)||(n3p.SU3().mu()%2!=0))
                             continue;
-                          if(u3::OuterMultiplicity(n3p.SU3(),u3::SU3(2,0),n3.SU3())==0)
+                          if(u3::OuterMultiplicity<2,0>(n3p.SU3(),n3.SU3())==0)
                             continue;
                           double coef3=vcs::BosonCreationRME(n3,n3p);
                           int rhop_max=n3p_tagged.tag;
@@ -9,12 +9,28 @@
 
 #include "sp3rlib/u3.h"
 
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
 #include <sstream>
 
+// AVX2 code path for batch kernels, selected at run time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define U3_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
 
 
 namespace u3 
 {
+
+  void PackLabelOverflow(int value, int width)
+  {
+    std::cerr << "ERROR: u3::PackLabel: label value " << value
+              << " out of range for " << width << "-bit packed key field" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
   
   std::string SU3::Str() const
   {
@@ -94,7 +110,312 @@ namespace u3
     return multiplicity;
   }
 
+  ////////////////////////////////////////////////////////////////
+  // batch multiplicity kernels
+  ////////////////////////////////////////////////////////////////
+
+  static void OuterMultiplicityBatchScalar(
+      std::size_t begin, std::size_t end,
+      const int* lambda1, const int* mu1,
+      const int* lambda2, const int* mu2,
+      const int* lambda3, const int* mu3,
+      int* multiplicities
+    )
+  // Evaluate outer multiplicity over entries [begin,end) by
+  // branch-free scalar loop.
+  {
+    for (std::size_t i=begin; i<end; ++i)
+      {
+        const int Nx = (lambda1[i]-mu1[i]) + (lambda2[i]-mu2[i]) - (lambda3[i]-mu3[i]);
+
+        // conjugate labels (by select) for "oblate" cases
+        const bool oblate = (Nx<0);
+        const int a1 = oblate ? mu1[i] : lambda1[i], b1 = oblate ? lambda1[i] : mu1[i];
+        const int a2 = oblate ? mu2[i] : lambda2[i], b2 = oblate ? lambda2[i] : mu2[i];
+        const int b3 = oblate ? lambda3[i] : mu3[i];
+        const int Nx_abs = oblate ? -Nx : Nx;
+        const int Mx = Nx_abs/3;
+
+        // main calculation, with all short circuits deferred to final mask
+        const int N = Mx+b1+b2-b3;
+        const int Mu = std::min(a1-Mx,b2);
+        const int Nu = std::min(a2-Mx,b1);
+        const int multiplicity = std::max(std::min(N,Nu)-std::max(N-Mu,0)+1,0);
+        const bool allowed = (3*Mx==Nx_abs) & (Mu>=0) & (Nu>=0);
+        multiplicities[i] = allowed ? multiplicity : 0;
+      }
+  }
+
+  static void BranchingMultiplicitySO3BatchScalar(
+      std::size_t begin, std::size_t end,
+      const int* lambda, const int* mu, const int* L,
+      int* multiplicities
+    )
+  // Evaluate branching multiplicity over entries [begin,end) by
+  // branch-free scalar loop.
+  {
+    for (std::size_t i=begin; i<end; ++i)
+      multiplicities[i]
+        = std::max(0,(lambda[i]+mu[i]+2-L[i])/2)
+        - std::max(0,(lambda[i]+1-L[i])/2)
+        - std::max(0,(mu[i]+1-L[i])/2);
+  }
+
+#ifdef U3_BATCH_AVX2
+
+  __attribute__((target("avx2")))
+  static std::size_t OuterMultiplicityBatchAVX2(
+      std::size_t n,
+      const int* lambda1, const int* mu1,
+      const int* lambda2, const int* mu2,
+      const int* lambda3, const int* mu3,
+      int* multiplicities
+    )
+  // Evaluate outer multiplicity eight entries at a time, over the
+  // largest multiple of eight entries.
+  //
+  // Returns number of entries processed.
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+    // slightly above 1/3, so truncation gives exact quotient for
+    // multiples of three below 2^22
+    const __m256 one_third = _mm256_set1_ps(1.f/3.f);
+
+    const std::size_t n_vector = n-n%8;
+    for (std::size_t i=0; i<n_vector; i+=8)
+      {
+        const __m256i l1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lambda1+i));
+        const __m256i m1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mu1+i));
+        const __m256i l2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lambda2+i));
+        const __m256i m2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mu2+i));
+        const __m256i l3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lambda3+i));
+        const __m256i m3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mu3+i));
+        const __m256i Nx = _mm256_sub_epi32(
+            _mm256_add_epi32(_mm256_sub_epi32(l1,m1),_mm256_sub_epi32(l2,m2)),
+            _mm256_sub_epi32(l3,m3)
+          );
+
+        // conjugate labels (by blend) for "oblate" cases
+        const __m256i oblate = _mm256_cmpgt_epi32(zero,Nx);
+        const __m256i a1 = _mm256_blendv_epi8(l1,m1,oblate), b1 = _mm256_blendv_epi8(m1,l1,oblate);
+        const __m256i a2 = _mm256_blendv_epi8(l2,m2,oblate), b2 = _mm256_blendv_epi8(m2,l2,oblate);
+        const __m256i b3 = _mm256_blendv_epi8(m3,l3,oblate);
+        const __m256i Nx_abs = _mm256_abs_epi32(Nx);
+        const __m256i Mx = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(Nx_abs),one_third));
+
+        // main calculation
+        const __m256i N = _mm256_sub_epi32(_mm256_add_epi32(Mx,_mm256_add_epi32(b1,b2)),b3);
+        const __m256i Mu = _mm256_min_epi32(_mm256_sub_epi32(a1,Mx),b2);
+        const __m256i Nu = _mm256_min_epi32(_mm256_sub_epi32(a2,Mx),b1);
+        const __m256i multiplicity = _mm256_max_epi32(
+            _mm256_add_epi32(
+                _mm256_sub_epi32(_mm256_min_epi32(N,Nu),_mm256_max_epi32(_mm256_sub_epi32(N,Mu),zero)),
+                one
+              ),
+            zero
+          );
+        const __m256i allowed = _mm256_and_si256(
+            _mm256_cmpeq_epi32(_mm256_mullo_epi32(Mx,three),Nx_abs),
+            _mm256_and_si256(_mm256_cmpgt_epi32(Mu,minus_one),_mm256_cmpgt_epi32(Nu,minus_one))
+          );
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(multiplicities+i),
+            _mm256_and_si256(multiplicity,allowed)
+          );
+      }
+    return n_vector;
+  }
+
+  __attribute__((target("avx2")))
+  static std::size_t BranchingMultiplicitySO3BatchAVX2(
+      std::size_t n, const int* lambda, const int* mu, const int* L,
+      int* multiplicities
+    )
+  // Evaluate branching multiplicity eight entries at a time, over the
+  // largest multiple of eight entries.
+  //
+  // The arithmetic right shift rounds toward minus infinity rather
+  // than zero, which only differs for negative numerators, where the
+  // result is clamped to zero in either case.
+  //
+  // Returns number of entries processed.
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i two = _mm256_set1_epi32(2);
+
+    const std::size_t n_vector = n-n%8;
+    for (std::size_t i=0; i<n_vector; i+=8)
+      {
+        const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lambda+i));
+        const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mu+i));
+        const __m256i LL = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(L+i));
+        const __m256i t1 = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(l,m),two),LL),1);
+        const __m256i t2 = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_add_epi32(l,one),LL),1);
+        const __m256i t3 = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_add_epi32(m,one),LL),1);
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(multiplicities+i),
+            _mm256_sub_epi32(
+                _mm256_max_epi32(t1,zero),
+                _mm256_add_epi32(_mm256_max_epi32(t2,zero),_mm256_max_epi32(t3,zero))
+              )
+          );
+      }
+    return n_vector;
+  }
+
+  static bool HaveAVX2()
+  // Check (once) whether processor supports AVX2.
+  {
+    static const bool have_avx2 = __builtin_cpu_supports("avx2");
+    return have_avx2;
+  }
+
+#endif  // U3_BATCH_AVX2
+
+  void OuterMultiplicityBatch(
+      std::size_t n,
+      const int* lambda1, const int* mu1,
+      const int* lambda2, const int* mu2,
+      const int* lambda3, const int* mu3,
+      int* multiplicities
+    )
+  {
+    std::size_t n_done = 0;
+#ifdef U3_BATCH_AVX2
+    if (HaveAVX2())
+      n_done = OuterMultiplicityBatchAVX2(n,lambda1,mu1,lambda2,mu2,lambda3,mu3,multiplicities);
+#endif
+    OuterMultiplicityBatchScalar(n_done,n,lambda1,mu1,lambda2,mu2,lambda3,mu3,multiplicities);
+  }
+
+  void OuterMultiplicityBatch(
+      const u3::SU3Batch& x1, const u3::SU3Batch& x2, const u3::SU3Batch& x3,
+      std::vector<int>& multiplicities
+    )
+  {
+    assert((x1.size()==x3.size())&&(x2.size()==x3.size()));
+    multiplicities.resize(x3.size());
+    OuterMultiplicityBatch(
+        x3.size(),
+        x1.lambda.data(),x1.mu.data(),
+        x2.lambda.data(),x2.mu.data(),
+        x3.lambda.data(),x3.mu.data(),
+        multiplicities.data()
+      );
+  }
+
+  void BranchingMultiplicitySO3Batch(
+      std::size_t n, const int* lambda, const int* mu, const int* L,
+      int* multiplicities
+    )
+  {
+    std::size_t n_done = 0;
+#ifdef U3_BATCH_AVX2
+    if (HaveAVX2())
+      n_done = BranchingMultiplicitySO3BatchAVX2(n,lambda,mu,L,multiplicities);
+#endif
+    BranchingMultiplicitySO3BatchScalar(n_done,n,lambda,mu,L,multiplicities);
+  }
+
+  void BranchingMultiplicitySO3Batch(
+      const u3::SU3Batch& x, const std::vector<int>& L,
+      std::vector<int>& multiplicities
+    )
+  {
+    assert(x.size()==L.size());
+    multiplicities.resize(x.size());
+    BranchingMultiplicitySO3Batch(x.size(),x.lambda.data(),x.mu.data(),L.data(),multiplicities.data());
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // multiplicity table
+  ////////////////////////////////////////////////////////////////
+
+  int MultiplicityTable::lm_max_ = -1;
+  int MultiplicityTable::mu_stride_ = 0;
+  std::vector<uint8_t> MultiplicityTable::table_;
+
+  void MultiplicityTable::Build(int lm_max)
+  {
+    assert((lm_max>=0)&&(lm_max<=kMaxLm));
+
+    // release any existing table
+    Clear();
+
+    // allocate table
+    const int n = lm_max+1;
+    const int mu_stride = (n+2)/3;
+    std::vector<uint8_t> table(std::size_t(n)*n*n*n*n*mu_stride,0);
+
+    // populate table
+    //
+    // Each stored slot (x1,x2,lambda3,mu3/3) is visited by exactly one
+    // mu3 of the allowed triality.
+    std::size_t index = 0;
+    for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+      for (int mu1=0; mu1<=lm_max; ++mu1)
+        for (int lambda2=0; lambda2<=lm_max; ++lambda2)
+          for (int mu2=0; mu2<=lm_max; ++mu2)
+            for (int lambda3=0; lambda3<=lm_max; ++lambda3)
+              {
+                // smallest mu3 satisfying triality constraint
+                int residue = (lambda3+(mu1+mu2)-(lambda1+lambda2))%3;
+                int mu3_min = (residue<0) ? residue+3 : residue;
+                for (int mu3=mu3_min; mu3<=lm_max; mu3+=3)
+                  table[index+mu3/3] = OuterMultiplicity(
+                      u3::SU3(lambda1,mu1),u3::SU3(lambda2,mu2),u3::SU3(lambda3,mu3)
+                    );
+                index += mu_stride;
+              }
+
+    // install table
+    lm_max_ = lm_max;
+    mu_stride_ = mu_stride;
+    table_.swap(table);
+  }
+
+  void MultiplicityTable::Clear()
+  {
+    lm_max_ = -1;
+    mu_stride_ = 0;
+    std::vector<uint8_t>().swap(table_);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // Kronecker product enumeration
+  ////////////////////////////////////////////////////////////////
+
   MultiplicityTagged<u3::SU3>::vector KroneckerProduct(const u3::SU3& x1, const u3::SU3& x2)
+  {
+    MultiplicityTagged<u3::SU3>::vector product;
+    product.reserve(KroneckerProductMaxSize(x1,x2));
+    KroneckerProduct(x1,x2,std::back_inserter(product));
+    return product;
+  }
+
+  void KroneckerProduct(
+      const u3::SU3& x1, const u3::SU3& x2,
+      MultiplicityTagged<u3::SU3>::vector& product
+    )
+  {
+    product.clear();
+    KroneckerProduct(x1,x2,std::back_inserter(product));
+  }
+
+  void KroneckerProduct(
+      const u3::SU3& x1, const u3::SU3& x2,
+      u3::SU3ProductBuffer& product
+    )
+  {
+    product.clear();
+    KroneckerProduct(x1,x2,std::back_inserter(product));
+  }
+
+  MultiplicityTagged<u3::SU3>::vector KroneckerProductGridScan(const u3::SU3& x1, const u3::SU3& x2)
   {
     // calculate bounds on (lambda3,mu3)
     int lambda3_min = 0;  // could be further constrained
@@ -103,17 +424,6 @@ namespace u3
     int mu3_max = x1.mu()+x2.mu()+std::min(x1.lambda(),x2.lambda());
 
     // allocate container for product
-
-    // Is this max_entries too big?
-    //
-    // SU3::Couple just reserves x1.lambda()+x2.lambda()+x1.mu()+x2.mu().
-    //
-    // TESTING: compare final size() with final capacity()
-    //
-    // Note: could trim container for product with shrink_to_fit() at end if
-    // storage will be persistent enough to make this worthwhile
-    // (nonbinding request in C++11)
-
     MultiplicityTagged<u3::SU3>::vector product;
     int max_entries = (lambda3_max - lambda3_min + 1) * (mu3_max - mu3_min + 1);
     product.reserve(max_entries);
@@ -134,27 +444,59 @@ namespace u3
 
   MultiplicityTagged<u3::U3>::vector KroneckerProduct(const u3::U3& omega1, const u3::U3& omega2)
   {
-    // couple U(1)
-    HalfInt N = omega1.N() + omega2.N();
-    
-    // couple SU(3)
-    MultiplicityTagged<u3::SU3>::vector su3_product = KroneckerProduct(omega1.SU3(),omega2.SU3());
+    MultiplicityTagged<u3::U3>::vector product;
+    product.reserve(KroneckerProductMaxSize(omega1.SU3(),omega2.SU3()));
+    KroneckerProduct(omega1,omega2,std::back_inserter(product));
+    return product;
+  }
 
-    // augment SU(3) entries with U(1) number
-    MultiplicityTagged<u3::U3>::vector u3_product;
-    u3_product.reserve(su3_product.size());
-    for (auto x_tagged_iter = su3_product.begin(); x_tagged_iter !=su3_product.end(); ++x_tagged_iter)
-      {
-        MultiplicityTagged<u3::SU3> x_tagged = *x_tagged_iter;
-        // AEM
-        if (u3::U3(N,x_tagged.irrep).Valid())
-        {
-          MultiplicityTagged<u3::U3> omega_tagged(u3::U3(N,x_tagged.irrep),x_tagged.tag);
-          u3_product.push_back(omega_tagged);
-        }
-      }
+  void KroneckerProduct(
+      const u3::U3& omega1, const u3::U3& omega2,
+      MultiplicityTagged<u3::U3>::vector& product
+    )
+  {
+    product.clear();
+    KroneckerProduct(omega1,omega2,std::back_inserter(product));
+  }
+
+  void KroneckerProduct(
+      const u3::U3& omega1, const u3::U3& omega2,
+      u3::U3ProductBuffer& product
+    )
+  {
+    product.clear();
+    KroneckerProduct(omega1,omega2,std::back_inserter(product));
+  }
+
+  MultiplicityTagged<u3::SU3>::vector KroneckerPreimage(const u3::SU3& x2, const u3::SU3& x3)
+  {
+    return KroneckerProduct(x3,Conjugate(x2));
+  }
 
-    return u3_product;
+  void KroneckerPreimage(
+      const u3::SU3& x2, const u3::SU3& x3,
+      u3::SU3ProductBuffer& preimage
+    )
+  {
+    preimage.clear();
+    KroneckerPreimage(x2,x3,std::back_inserter(preimage));
+  }
+
+  MultiplicityTagged<u3::U3>::vector KroneckerPreimage(const u3::U3& omega2, const u3::U3& omega3)
+  {
+    MultiplicityTagged<u3::U3>::vector preimage;
+    preimage.reserve(KroneckerProductMaxSize(omega3.SU3(),Conjugate(omega2.SU3())));
+    KroneckerPreimage(omega2,omega3,std::back_inserter(preimage));
+    return preimage;
+  }
+
+  void KroneckerPreimage(
+      const u3::U3& omega2, const u3::U3& omega3,
+      u3::U3ProductBuffer& preimage
+    )
+  {
+    preimage.clear();
+    KroneckerPreimage(omega2,omega3,std::back_inserter(preimage));
   }
 
   int BranchingMultiplicitySO3(const u3::SU3& x, int L)
@@ -13,16 +13,31 @@
   3/9/16 (aem,mac): Add KeyType typedefs.  Extract MultiplicityTagged.
   3/16/16 (aem): Add validity check to U(3) Kronecker product.
   9/6/16 (mac): Upgrade U3S and U3ST from struct to class with hash function, etc.
+  10/16/26 (mac): Replace grid scan in KroneckerProduct with direct
+    enumeration of allowed irreps.
+  10/16/26 (mac): Add opt-in MultiplicityTable lookup for outer multiplicities.
+  10/16/26 (mac): Add batch multiplicity kernels.
+  10/16/26 (mac): Take batch kernel labels as structure of arrays, with AVX2
+    code path.
+  10/16/26 (mac): Compare and hash labels on packed 64-bit keys.
+  10/16/26 (mac): Add allocation-free KroneckerProduct overloads.
+  10/16/26 (mac): Add fixed-operator coupling kernels for (2,0), (0,2), (1,1).
+  10/16/26 (mac): Add KroneckerPreimage.
+  10/16/26 (mac): Check packed label field ranges at run time.
 
 ****************************************************************/
 
 #ifndef U3_H_
 #define U3_H_
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <iterator>
 #include <string>
 #include <vector>
 
+#include "boost/container/small_vector.hpp"
 #include "boost/functional/hash.hpp"
 
 #include "am/halfint.h"
@@ -34,6 +49,59 @@
 namespace u3 
 {
 
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // packed label keys
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  // Each label class provides a PackedKey(), which packs its labels
+  // into a single 64-bit integer.  Each label occupies a fixed-width
+  // bit field, biased so that unsigned comparison of the packed key
+  // reproduces lexicographic comparison of the labels (as given by
+  // Key()).  Comparisons and hashing are then carried out on the
+  // packed key, rather than on a freshly-constructed Key() tuple.
+
+  [[noreturn]] void PackLabelOverflow(int value, int width);
+  // Report label value out of range for packed key field, and abort.
+
+  inline uint64_t PackLabel(int value, int width)
+  // Pack signed label into biased bit field of given width.
+  //
+  // The range is checked in all builds (not just by assert), since an
+  // out-of-range value would silently alias the key of another label,
+  // and thus corrupt comparisons and hashing.
+  //
+  // Arguments:
+  //   value (int): label value, in range -2^(width-1)..2^(width-1)-1
+  //   width (int): field width in bits
+  //
+  // Returns:
+  //   (uint64_t): field value, in range 0..2^width-1
+  {
+    const int64_t bias = int64_t(1)<<(width-1);
+    if ((value<-bias)||(value>=bias))
+      PackLabelOverflow(value,width);
+    return uint64_t(value+bias);
+  }
+
+  inline std::size_t PackedHash(uint64_t key)
+  // Hash packed key by a single multiplication.
+  //
+  // Multiplicative (Fibonacci) hashing by 2^64/phi, with the
+  // well-mixed high-order bits folded back into the low-order bits.
+  {
+    const uint64_t product = key*UINT64_C(0x9E3779B97F4A7C15);
+    return std::size_t(product^(product>>32));
+  }
+
+  inline std::size_t PackedHashCombine(std::size_t seed, uint64_t key)
+  // Combine hash seed with further packed key, for composite labels
+  // (e.g., coefficient cache keys).
+  {
+    return PackedHash(uint64_t(seed)^key);
+  }
+
   ////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////
   // SU(3) irrep
@@ -86,27 +154,25 @@ namespace u3
       return KeyType(lambda(),mu());
     }
 
+    inline uint64_t PackedKey() const
+    // Pack (lambda,mu) into 32-bit fields.
+    {
+      return (PackLabel(lambda_,32)<<32) | PackLabel(mu_,32);
+    }
+
     inline friend bool operator == (const SU3& x1, const SU3& x2)
     {
-      return x1.Key() == x2.Key();
+      return x1.PackedKey() == x2.PackedKey();
     }
 
     inline friend bool operator < (const SU3& x1, const SU3& x2)
     {
-      return x1.Key() < x2.Key();
+      return x1.PackedKey() < x2.PackedKey();
     }
 
-    // alternative: if find need to avoid hash combination functions...
-    //
-    //   static const int label_width = 8;
-    //   int packed_labels = (x.lambda_ << label_width) | (x.mu_ << 0);
-    //   boost::hash<int> hasher;
-    //   return hasher(packed_labels);
-
-   inline friend std::size_t hash_value(const SU3& v)
+    inline friend std::size_t hash_value(const SU3& v)
     {
-      boost::hash<SU3::KeyType> hasher;
-      return hasher(v.Key());
+      return PackedHash(v.PackedKey());
     }
 
     ////////////////////////////////////////////////////////////////
@@ -124,10 +190,6 @@ namespace u3
     // Elliott labels
     int lambda_, mu_;
 
-    // Could save memory by packing labels into a uint16_t:
-    // uint16_t packed_labels_;
-    // packed_labels_ = (lambda << label_width) | (mu << 0);
-
   };
 
   ////////////////////////////////////////////////////////////////
@@ -287,34 +349,28 @@ namespace u3
       return KeyType(N(),SU3());
     }
 
+    inline uint64_t PackedKey() const
+    // Pack (2N,lambda,mu) into 24/20/20-bit fields.
+    {
+      return
+        (PackLabel(TwiceValue(N()),24)<<40)
+        | (PackLabel(int(f1_-f2_),20)<<20)
+        | PackLabel(int(f2_-f3_),20);
+    }
+
     inline friend bool operator == (const U3& omega1, const U3& omega2)
     {
-      return omega1.Key() == omega2.Key();
+      return omega1.PackedKey() == omega2.PackedKey();
     }
 
     inline friend bool operator < (const U3& omega1, const U3& omega2)
     {
-      return omega1.Key() < omega2.Key();
+      return omega1.PackedKey() < omega2.PackedKey();
     }
 
-    // Alternative old "manual" combination...
-    //
-    //   static const int label_width = 12;
-    //   inline friend std::size_t hash_value(const U3& omega)
-    //   {
-    //     int packed_labels =
-    //       (TwiceValue(omega.f1_) << 2*label_width)
-    //       | (TwiceValue(omega.f2_) << label_width)
-    //       | (TwiceValue(omega.f3_) << 0);
-    //   
-    //     boost::hash<int> hasher;
-    //     return hasher(packed_labels);
-    //   }
-
     inline friend std::size_t hash_value(const U3& v)
     {
-      boost::hash<U3::KeyType> hasher;
-      return hasher(v.Key());
+      return PackedHash(v.PackedKey());
     }
 
 
@@ -435,20 +491,30 @@ namespace u3
       return KeyType(omega_,S_);
     }
 
+    inline uint64_t PackedKey() const
+    // Pack (2N,lambda,mu,2S) into 20/16/16/12-bit fields.
+    {
+      u3::SU3 x = omega_.SU3();
+      return
+        (PackLabel(TwiceValue(omega_.N()),20)<<44)
+        | (PackLabel(x.lambda(),16)<<28)
+        | (PackLabel(x.mu(),16)<<12)
+        | PackLabel(TwiceValue(S_),12);
+    }
+
     inline friend bool operator == (const U3S& omegaS1, const U3S& omegaS2)
     {
-      return omegaS1.Key() == omegaS2.Key();
+      return omegaS1.PackedKey() == omegaS2.PackedKey();
     }
 
     inline friend bool operator < (const U3S& omegaS1, const U3S& omegaS2)
     {
-      return omegaS1.Key() < omegaS2.Key();
+      return omegaS1.PackedKey() < omegaS2.PackedKey();
     }
 
     inline friend std::size_t hash_value(const U3S& v)
     {
-      boost::hash<U3S::KeyType> hasher;
-      return hasher(v.Key());
+      return PackedHash(v.PackedKey());
     }
 
     ////////////////////////////////////////////////////////////////
@@ -540,20 +606,31 @@ namespace u3
       return KeyType(omega_,S_,T_);
     }
 
+    inline uint64_t PackedKey() const
+    // Pack (2N,lambda,mu,2S,2T) into 18/14/14/9/9-bit fields.
+    {
+      u3::SU3 x = omega_.SU3();
+      return
+        (PackLabel(TwiceValue(omega_.N()),18)<<46)
+        | (PackLabel(x.lambda(),14)<<32)
+        | (PackLabel(x.mu(),14)<<18)
+        | (PackLabel(TwiceValue(S_),9)<<9)
+        | PackLabel(TwiceValue(T_),9);
+    }
+
     inline friend bool operator == (const U3ST& omegaST1, const U3ST& omegaST2)
     {
-      return omegaST1.Key() == omegaST2.Key();
+      return omegaST1.PackedKey() == omegaST2.PackedKey();
     }
 
     inline friend bool operator < (const U3ST& omegaST1, const U3ST& omegaST2)
     {
-      return omegaST1.Key() < omegaST2.Key();
+      return omegaST1.PackedKey() < omegaST2.PackedKey();
     }
 
     inline friend std::size_t hash_value(const U3ST& v)
     {
-      boost::hash<U3ST::KeyType> hasher;
-      return hasher(v.Key());
+      return PackedHash(v.PackedKey());
     }
 
     ////////////////////////////////////////////////////////////////
@@ -601,17 +678,399 @@ namespace u3
   // Reference: C. K. Chew and R. T. Sharp, Can. J. Phys. 44, 2789 (1966).  To be verified.
   // As in SU3LIB MULTU3 or UNU3SU3Basics SU3::mult.
   //
+  // Always evaluated by the arithmetic formula.  A precomputed
+  // MultiplicityTable (below) is only consulted through
+  // MultiplicityTable::Get.
+  //
   // Arguments:
   //   x1, x2, x3 (u3::SU3): irreps
   //
   // Returns:
   //   (int) : multiplicity 
 
+  struct SU3Batch
+  // Batch of SU(3) labels for the batch multiplicity kernels.
+  //
+  // Labels are stored as separate lambda and mu arrays (structure of
+  // arrays), so that the kernels can load eight consecutive lambda or
+  // mu values into one vector register.
+  {
+    std::vector<int> lambda, mu;
+
+    inline std::size_t size() const
+    {
+      return lambda.size();
+    }
+
+    inline void clear()
+    {
+      lambda.clear();
+      mu.clear();
+    }
+
+    inline void reserve(std::size_t n)
+    {
+      lambda.reserve(n);
+      mu.reserve(n);
+    }
+
+    inline void push_back(const u3::SU3& x)
+    {
+      lambda.push_back(x.lambda());
+      mu.push_back(x.mu());
+    }
+
+    inline u3::SU3 operator[](std::size_t i) const
+    {
+      return u3::SU3(lambda[i],mu[i]);
+    }
+  };
+
+  void OuterMultiplicityBatch(
+      std::size_t n,
+      const int* lambda1, const int* mu1,
+      const int* lambda2, const int* mu2,
+      const int* lambda3, const int* mu3,
+      int* multiplicities
+    );
+  // Calculate outer multiplicities for a batch of triples x1 x x2 -> x3.
+  //
+  // Evaluates the same formula as OuterMultiplicity, with the
+  // conjugation of "oblate" cases and the short circuits replaced by
+  // selects.  On x86 processors supporting AVX2 (detected at run
+  // time, and only when built with GCC or Clang), eight triples are
+  // processed per iteration with 256-bit integer intrinsics.
+  // Otherwise, or for the remainder of the batch, a branch-free scalar
+  // loop is used.  Intended for label screening over large candidate
+  // sets.
+  //
+  // Labels must be nonnegative and less than 2^20.
+  //
+  // Arguments:
+  //   n (std::size_t): number of triples
+  //   lambda1, mu1, lambda2, mu2, lambda3, mu3 (const int*): labels
+  //     of irreps (each of size n)
+  //   multiplicities (int*): output multiplicities (size n)
+
+  void OuterMultiplicityBatch(
+      const u3::SU3Batch& x1, const u3::SU3Batch& x2, const u3::SU3Batch& x3,
+      std::vector<int>& multiplicities
+    );
+  // Overloaded for label batches.  The output vector is resized as
+  // needed.
+
+  class MultiplicityTable
+  // Precomputed lookup table of SU(3) outer multiplicities.
+  //
+  // Stores rho_max for every triple x1 x x2 -> x3 with all lambda,mu
+  // in the range 0..lm_max, as one byte per entry.  Only x3
+  // satisfying the triality constraint
+  //
+  //   (lambda1-mu1)+(lambda2-mu2)-(lambda3-mu3) = 0 (mod 3)
+  //
+  // are stored, so, for given (x1,x2,lambda3), the allowed mu3 are
+  // indexed by mu3/3.  The table occupies
+  //
+  //   (lm_max+1)^5 * ceil((lm_max+1)/3)
+  //
+  // bytes, e.g., 1.9 MB for lm_max=12, 29 MB for lm_max=20, or
+  // 315 MB for the largest supported bound lm_max=kMaxLm=30.  The
+  // footprint grows as lm_max^6.
+  //
+  // The table is opt-in and is only consulted through Get (or
+  // Lookup).  OuterMultiplicity always uses the arithmetic formula,
+  // since the lookup is not faster: in u3_benchmark (lm_max=12, random
+  // mix of allowed and disallowed triples), the table gave 77.3
+  // Mcall/s against 90.5 Mcall/s for the formula, as the table
+  // exceeds the cache and each lookup is a likely cache miss.  The
+  // table is global state: Build and Clear must not be called while
+  // other threads may be calling Get.
+  //
+  // EX:
+  //   u3::MultiplicityTable::Build(12);
+  //   std::cout << u3::MultiplicityTable::MemoryFootprint() << std::endl;
+  //   int rho_max = u3::MultiplicityTable::Get(x1,x2,x3);
+  {
+  public:
+
+    // largest supported bound on labels
+    static constexpr int kMaxLm = 30;
+
+    static void Build(int lm_max);
+    // Build table covering lambda,mu<=lm_max, replacing any existing
+    // table.
+    //
+    // Arguments:
+    //   lm_max (int): bound on lambda and mu for all three irreps (at
+    //     most kMaxLm)
+
+    static void Clear();
+    // Release table.
+
+    inline static bool Enabled()
+    {
+      return !table_.empty();
+    }
+
+    inline static int lm_max()
+    {
+      return lm_max_;
+    }
+
+    inline static std::size_t MemoryFootprint()
+    // Return memory occupied by table (in bytes).
+    {
+      return table_.capacity()*sizeof(uint8_t);
+    }
+
+    inline static bool Covers(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+    // Check if all labels lie within the range of the table.
+    //
+    // Unsigned comparison also rejects negative labels.
+    {
+      const unsigned int bound = lm_max_;
+      return Enabled()
+        && (unsigned(x1.lambda())<=bound) && (unsigned(x1.mu())<=bound)
+        && (unsigned(x2.lambda())<=bound) && (unsigned(x2.mu())<=bound)
+        && (unsigned(x3.lambda())<=bound) && (unsigned(x3.mu())<=bound);
+    }
+
+    inline static int Lookup(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+    // Retrieve multiplicity from table.
+    //
+    // Precondition: Covers(x1,x2,x3)
+    {
+      int Nx = (x1.lambda()-x1.mu()) + (x2.lambda()-x2.mu()) - (x3.lambda()-x3.mu());
+      if ((Nx%3)!=0)
+        return 0;
+      return table_[Index(x1,x2,x3)];
+    }
+
+    inline static int Get(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+    // Retrieve multiplicity from table if all labels are covered, and
+    // otherwise calculate it by OuterMultiplicity.
+    {
+      if (Covers(x1,x2,x3))
+        return Lookup(x1,x2,x3);
+      return OuterMultiplicity(x1,x2,x3);
+    }
+
+  private:
+
+    inline static std::size_t Index(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+    // Calculate position of entry in table.
+    {
+      const std::size_t n = lm_max_+1;
+      std::size_t index = x1.lambda();
+      index = index*n + x1.mu();
+      index = index*n + x2.lambda();
+      index = index*n + x2.mu();
+      index = index*n + x3.lambda();
+      index = index*mu_stride_ + x3.mu()/3;
+      return index;
+    }
+
+    // bound on labels
+    static int lm_max_;
+
+    // number of stored mu3 values per (x1,x2,lambda3)
+    static int mu_stride_;
+
+    // multiplicities
+    static std::vector<uint8_t> table_;
+  };
+
+  // Kronecker product
+  //
+  // The Kronecker product may be returned as a freshly allocated
+  // vector, written into a caller-provided buffer (whose capacity is
+  // retained between calls), or written through an output iterator.
+  // In steady state, with a reused buffer, the product step performs
+  // no heap allocation.
+  //
+  // The buffer typedefs SU3ProductBuffer and U3ProductBuffer are
+  // small-buffer vectors, which hold typical products (e.g., with
+  // (2,0) or a low-grade raising polynomial) without touching the
+  // heap at all.
+
+  typedef boost::container::small_vector<MultiplicityTagged<u3::SU3>,16> SU3ProductBuffer;
+  typedef boost::container::small_vector<MultiplicityTagged<u3::U3>,16> U3ProductBuffer;
+
+  inline int FloorDiv(int a, int b)
+  // Integer division rounding toward minus infinity (for b>0).
+  {
+    return (a>=0) ? (a/b) : -((-a+b-1)/b);
+  }
+
+  inline int CeilDiv(int a, int b)
+  // Integer division rounding toward plus infinity (for b>0).
+  {
+    return -FloorDiv(-a,b);
+  }
+
+  inline int KroneckerProductMaxSize(const u3::SU3& x1, const u3::SU3& x2)
+  // Calculate bound on number of irreps in SU(3) Kronecker product.
+  //
+  // The number of product irreps is bounded by
+  // (min(lambda1,lambda2)+1)*(mu1+mu2+1)+min(mu1,mu2)*(lambda1+lambda2+1),
+  // from the counts of allowed (k,N) in the prolate and oblate cases
+  // (see KroneckerProductVisit).
+  {
+    return (std::min(x1.lambda(),x2.lambda())+1)*(x1.mu()+x2.mu()+1)
+      + std::min(x1.mu(),x2.mu())*(x1.lambda()+x2.lambda()+1);
+  }
+
+  template <typename tVisitor>
+    void KroneckerProductVisit(const u3::SU3& x1, const u3::SU3& x2, tVisitor visitor)
+  // Enumerate SU(3) Kronecker product, invoking visitor(x3,rho_max)
+  // for each product irrep.
+  //
+  // Enumerates the allowed (lambda3,mu3) directly, as obtained by
+  // inverting the outer multiplicity formula of OuterMultiplicity.
+  //
+  // The outer multiplicity formula is parametrized by the "excess"
+  // k=|Nx|/3, where Nx is the triality mismatch, together with the
+  // auxiliary count N=k+mu1+mu2-mu3 (evaluated for the conjugated
+  // labels when Nx<0).  For fixed k, the allowed N form the
+  // contiguous range 0<=N<=Mu+Nu, so, for fixed lambda3, the allowed
+  // mu3 are
+  //
+  //   mu3 = lambda3+(mu1+mu2)-(lambda1+lambda2)+3j
+  //
+  // for j in a contiguous range, with j=k>=0 for the "prolate" case
+  // (Nx>=0) and j=-k<0 for the "oblate" case (Nx<0).  The bounds on k
+  // follow from the inequalities 0<=N<=Mu+Nu.  The time is therefore
+  // linear in the size of the product.
+  //
+  // Irreps are visited in lexicographic order by (lambda3,mu3).
+  {
+    const int lambda1 = x1.lambda(), mu1 = x1.mu();
+    const int lambda2 = x2.lambda(), mu2 = x2.mu();
+
+    // bound on lambda3 (attained in oblate case with k=min(mu1,mu2))
+    const int lambda3_max = lambda1+lambda2+std::min(mu1,mu2);
+
+    for (int lambda3 = 0; lambda3 <= lambda3_max; ++lambda3)
+      {
+        const int mu3_base = lambda3+(mu1+mu2)-(lambda1+lambda2);
+
+        // oblate case (Nx<0): increasing mu3 corresponds to decreasing k
+        int k_min = std::max(1,lambda3-lambda1-lambda2);
+        int k_max = std::min(std::min(mu1,mu2),lambda3);
+        k_max = std::min(k_max,FloorDiv(mu3_base,3));
+        k_max = std::min(k_max,FloorDiv(mu1-lambda2+lambda3,2));
+        k_max = std::min(k_max,FloorDiv(mu2-lambda1+lambda3,2));
+        for (int k = k_max; k >= k_min; --k)
+          {
+            int N = k+lambda1+lambda2-lambda3;
+            int Mu = std::min(mu1-k,lambda2);
+            int Nu = std::min(mu2-k,lambda1);
+            int multiplicity = std::min(N,Nu)-std::max(N-Mu,0)+1;
+            visitor(u3::SU3(lambda3,mu3_base-3*k),multiplicity);
+          }
+
+        // prolate case (Nx>=0): increasing mu3 corresponds to increasing k
+        k_min = std::max(0,CeilDiv(lambda1+lambda2-lambda3-mu1-mu2,2));
+        k_min = std::max(k_min,std::max(lambda2-lambda3-mu1,lambda1-lambda3-mu2));
+        k_max = std::min(std::min(lambda1,lambda2),FloorDiv(lambda1+lambda2-lambda3,2));
+        for (int k = k_min; k <= k_max; ++k)
+          {
+            int N = lambda1+lambda2-2*k-lambda3;
+            int Mu = std::min(lambda1-k,mu2);
+            int Nu = std::min(lambda2-k,mu1);
+            int multiplicity = std::min(N,Nu)-std::max(N-Mu,0)+1;
+            visitor(u3::SU3(lambda3,mu3_base+3*k),multiplicity);
+          }
+      }
+  }
+
+  template <typename tOutputIterator>
+    tOutputIterator KroneckerProduct(const u3::SU3& x1, const u3::SU3& x2, tOutputIterator out)
+  // Write SU(3) Kronecker product through output iterator.
+  //
+  // Arguments:
+  //   x1, x2 (u3::SU3) : irreps
+  //   out (tOutputIterator) : output iterator accepting
+  //     MultiplicityTagged<u3::SU3>
+  //
+  // Returns:
+  //   (tOutputIterator) : output iterator past last irrep written
+  {
+    KroneckerProductVisit(
+        x1,x2,
+        [&out](const u3::SU3& x3, int multiplicity)
+        {
+          *out++ = MultiplicityTagged<u3::SU3>(x3,multiplicity);
+        }
+      );
+    return out;
+  }
+
+  template <typename tOutputIterator>
+    tOutputIterator KroneckerProduct(const u3::U3& omega1, const u3::U3& omega2, tOutputIterator out)
+  // Write U(3) Kronecker product through output iterator.
+  //
+  // Only product irreps with valid U(3) labels are retained.
+  //
+  // Arguments:
+  //   omega1, omega2 (u3::U3) : irreps
+  //   out (tOutputIterator) : output iterator accepting
+  //     MultiplicityTagged<u3::U3>
+  //
+  // Returns:
+  //   (tOutputIterator) : output iterator past last irrep written
+  {
+    const HalfInt N = omega1.N()+omega2.N();
+    KroneckerProductVisit(
+        omega1.SU3(),omega2.SU3(),
+        [&out,&N](const u3::SU3& x3, int multiplicity)
+        {
+          u3::U3 omega3(N,x3);
+          if (omega3.Valid())
+            *out++ = MultiplicityTagged<u3::U3>(omega3,multiplicity);
+        }
+      );
+    return out;
+  }
+
   MultiplicityTagged<u3::SU3>::vector KroneckerProduct(const u3::SU3& x1, const u3::SU3& x2);
   // Generate multiplicity-tagged vector of SU(3) irreps in SU(3) Kronecker product.
   //
-  // Generates Kronecker product by iterating over possible
-  // (lambda,mu) in product and checking multiplicity.
+  // Irreps are generated in lexicographic order by (lambda3,mu3),
+  // i.e., the same order as the grid scan in
+  // KroneckerProductGridScan.  See KroneckerProductVisit.
+  //
+  // Arguments:
+  //   x1, x2 (u3::SU3) : irreps
+  //
+  // Returns:
+  //   (MultiplicityTagged<u3::SU3>::vector) : vector with each irrep
+  //   (of nonzero multiplicity) tagged by its multiplicity rho_max
+
+  void KroneckerProduct(
+      const u3::SU3& x1, const u3::SU3& x2,
+      MultiplicityTagged<u3::SU3>::vector& product
+    );
+  void KroneckerProduct(
+      const u3::SU3& x1, const u3::SU3& x2,
+      u3::SU3ProductBuffer& product
+    );
+  // Overloaded to write SU(3) Kronecker product into caller-provided
+  // buffer.
+  //
+  // The buffer is cleared and refilled.  Its capacity is retained,
+  // so no allocation occurs once the buffer has grown to hold the
+  // largest product encountered.  (The buffer is not reserved to
+  // KroneckerProductMaxSize, which can greatly overestimate the
+  // product size, e.g., for products with (2,0).)
+
+  MultiplicityTagged<u3::SU3>::vector KroneckerProductGridScan(const u3::SU3& x1, const u3::SU3& x2);
+  // Generate SU(3) Kronecker product by grid scan.
+  //
+  // Reference implementation, retained for validation and
+  // benchmarking of KroneckerProduct.  Iterates over possible
+  // (lambda3,mu3) in a rectangle containing the product and checks
+  // the multiplicity of each.
   //
   // As in UNU3SU3Basics SU3::Couple but adopting more restrictive
   // bounds on product (lambda3,mu3).
@@ -624,8 +1083,302 @@ namespace u3
   //   (of nonzero multiplicity) tagged by its multiplicity rho_max
 
   MultiplicityTagged<u3::U3>::vector KroneckerProduct(const u3::U3& omega1, const u3::U3& omega2);
+  void KroneckerProduct(
+      const u3::U3& omega1, const u3::U3& omega2,
+      MultiplicityTagged<u3::U3>::vector& product
+    );
+  void KroneckerProduct(
+      const u3::U3& omega1, const u3::U3& omega2,
+      u3::U3ProductBuffer& product
+    );
   // Overloaded for U3.
 
+  // Kronecker preimage
+  //
+  // The reverse query to the Kronecker product: given x2 and a target
+  // x3, enumerate the x1 for which x1 x x2 contains x3.  Since the
+  // multiplicity of x3 in x1 x x2 equals the multiplicity of x1 in x3
+  // x conj(x2), the preimage is obtained directly as a Kronecker
+  // product, in time linear in the size of the preimage, without
+  // enumerating forward products and filtering.
+
+  template <typename tOutputIterator>
+    tOutputIterator KroneckerPreimage(const u3::SU3& x2, const u3::SU3& x3, tOutputIterator out)
+  // Write SU(3) irreps x1 with x1 x x2 containing x3 through output
+  // iterator.
+  //
+  // Arguments:
+  //   x2 (u3::SU3) : irrep coupled to x1
+  //   x3 (u3::SU3) : target irrep
+  //   out (tOutputIterator) : output iterator accepting
+  //     MultiplicityTagged<u3::SU3>, where the tag is the outer
+  //     multiplicity of x3 in x1 x x2
+  //
+  // Returns:
+  //   (tOutputIterator) : output iterator past last irrep written
+  {
+    return KroneckerProduct(x3,Conjugate(x2),out);
+  }
+
+  template <typename tOutputIterator>
+    tOutputIterator KroneckerPreimage(const u3::U3& omega2, const u3::U3& omega3, tOutputIterator out)
+  // Write U(3) irreps omega1 with omega1 x omega2 containing omega3
+  // through output iterator.
+  //
+  // The U(1) label is N1=N3-N2.  Only irreps with valid U(3) labels
+  // are retained.
+  {
+    const HalfInt N = omega3.N()-omega2.N();
+    KroneckerProductVisit(
+        omega3.SU3(),Conjugate(omega2.SU3()),
+        [&out,&N](const u3::SU3& x1, int multiplicity)
+        {
+          u3::U3 omega1(N,x1);
+          if (omega1.Valid())
+            *out++ = MultiplicityTagged<u3::U3>(omega1,multiplicity);
+        }
+      );
+    return out;
+  }
+
+  MultiplicityTagged<u3::SU3>::vector KroneckerPreimage(const u3::SU3& x2, const u3::SU3& x3);
+  // Generate multiplicity-tagged vector of SU(3) irreps x1 with x1 x
+  // x2 containing x3.
+  //
+  // Irreps are generated in lexicographic order by (lambda1,mu1).
+  //
+  // Arguments:
+  //   x2 (u3::SU3) : irrep coupled to x1
+  //   x3 (u3::SU3) : target irrep
+  //
+  // Returns:
+  //   (MultiplicityTagged<u3::SU3>::vector) : vector with each x1
+  //   tagged by the outer multiplicity of x3 in x1 x x2
+
+  void KroneckerPreimage(
+      const u3::SU3& x2, const u3::SU3& x3,
+      u3::SU3ProductBuffer& preimage
+    );
+  // Overloaded to write into caller-provided buffer (cleared and
+  // refilled).
+
+  MultiplicityTagged<u3::U3>::vector KroneckerPreimage(const u3::U3& omega2, const u3::U3& omega3);
+  void KroneckerPreimage(
+      const u3::U3& omega2, const u3::U3& omega3,
+      u3::U3ProductBuffer& preimage
+    );
+  // Overloaded for U3.
+
+  // fixed-operator coupling kernels
+  //
+  // Specialized kernels for coupling with the symplectic raising and
+  // lowering irreps (2,0) and (0,2) and the U(3) generator irrep
+  // (1,1), which are the only couplings arising in the vcs and
+  // Sp(3,R) operator code.
+  //
+  // The product of x1 with such a small irrep x0 is contained in
+  // {x1+w}, where w runs over the weights of x0, so the product
+  // consists of at most six (for (2,0) or (0,2)) or seven (for (1,1))
+  // irreps.  The candidate shifts w are listed explicitly, in
+  // lexicographic order, and each candidate is checked by the outer
+  // multiplicity formula with x0 folded in at compile time.  There
+  // are no loops.
+  //
+  // EX:
+  //   u3::SU3ProductBuffer product = u3::KroneckerProduct<2,0>(u3::SU3(4,1));
+  //   int rho_max = u3::OuterMultiplicity<2,0>(u3::SU3(4,1),u3::SU3(6,1));
+
+  template <int lambda2, int mu2>
+    inline int OuterMultiplicity(const u3::SU3& x1, const u3::SU3& x3)
+  // Calculate outer multiplicity of x3 in x1 x (lambda2,mu2).
+  //
+  // Same formula as OuterMultiplicity, with x2 fixed at compile
+  // time.
+  {
+    const int lambda1 = x1.lambda(), mu1 = x1.mu();
+    const int lambda3 = x3.lambda(), mu3 = x3.mu();
+    const int Nx = (lambda1-mu1) + (lambda2-mu2) - (lambda3-mu3);
+    if ((Nx%3)!=0)
+      return 0;
+
+    // handle conjugation for "oblate" cases
+    const bool oblate = (Nx<0);
+    const int Mx = oblate ? -Nx/3 : Nx/3;
+    const int y1_lambda = oblate ? mu1 : lambda1, y1_mu = oblate ? lambda1 : mu1;
+    const int y2_lambda = oblate ? mu2 : lambda2, y2_mu = oblate ? lambda2 : mu2;
+    const int y3_mu = oblate ? lambda3 : mu3;
+
+    // main calculation
+    const int N = Mx+y1_mu+y2_mu-y3_mu;
+    const int Mu = std::min(y1_lambda-Mx,y2_mu);
+    const int Nu = std::min(y2_lambda-Mx,y1_mu);
+    if ((Mu<0)||(Nu<0))
+      return 0;
+    return std::max(std::min(N,Nu)-std::max(N-Mu,0)+1,0);
+  }
+
+  template <int lambda0, int mu0>
+    struct FixedCouplingShifts;
+  // Candidate shifts (lambda3-lambda1,mu3-mu1) for coupling with
+  // (lambda0,mu0), i.e., the weights of (lambda0,mu0) in (lambda,mu)
+  // form, listed in lexicographic order.
+  //
+  // Visit(visitor) invokes visitor(delta_lambda,delta_mu) for each
+  // distinct shift.
+
+  template <>
+    struct FixedCouplingShifts<2,0>
+  {
+    template <typename tVisitor>
+      static void Visit(tVisitor& visitor)
+    {
+      visitor(-2,+2);
+      visitor(-1,0);
+      visitor(0,-2);
+      visitor(0,+1);
+      visitor(+1,-1);
+      visitor(+2,0);
+    }
+  };
+
+  template <>
+    struct FixedCouplingShifts<0,2>
+  {
+    template <typename tVisitor>
+      static void Visit(tVisitor& visitor)
+    {
+      visitor(-2,0);
+      visitor(-1,+1);
+      visitor(0,-1);
+      visitor(0,+2);
+      visitor(+1,0);
+      visitor(+2,-2);
+    }
+  };
+
+  template <>
+    struct FixedCouplingShifts<1,1>
+  {
+    template <typename tVisitor>
+      static void Visit(tVisitor& visitor)
+    {
+      visitor(-2,+1);
+      visitor(-1,-1);
+      visitor(-1,+2);
+      visitor(0,0);
+      visitor(+1,-2);
+      visitor(+1,+1);
+      visitor(+2,-1);
+    }
+  };
+
+  template <int lambda0, int mu0, typename tOutputIterator>
+    tOutputIterator KroneckerProduct(const u3::SU3& x1, tOutputIterator out)
+  // Write SU(3) Kronecker product x1 x (lambda0,mu0) through output
+  // iterator.
+  //
+  // Irreps are generated in lexicographic order, as for the general
+  // KroneckerProduct.
+  //
+  // Template parameters:
+  //   lambda0, mu0 (int) : (2,0), (0,2), or (1,1)
+  //
+  // Arguments:
+  //   x1 (u3::SU3) : irrep
+  //   out (tOutputIterator) : output iterator accepting
+  //     MultiplicityTagged<u3::SU3>
+  //
+  // Returns:
+  //   (tOutputIterator) : output iterator past last irrep written
+  {
+    const int lambda1 = x1.lambda(), mu1 = x1.mu();
+    auto visitor = [&out,&x1,lambda1,mu1](int delta_lambda, int delta_mu)
+      {
+        const int lambda3 = lambda1+delta_lambda, mu3 = mu1+delta_mu;
+        if ((lambda3<0)||(mu3<0))
+          return;
+        const u3::SU3 x3(lambda3,mu3);
+        const int multiplicity = OuterMultiplicity<lambda0,mu0>(x1,x3);
+        if (multiplicity>0)
+          *out++ = MultiplicityTagged<u3::SU3>(x3,multiplicity);
+      };
+    FixedCouplingShifts<lambda0,mu0>::Visit(visitor);
+    return out;
+  }
+
+  template <int lambda0, int mu0>
+    u3::SU3ProductBuffer KroneckerProduct(const u3::SU3& x1)
+  // Generate SU(3) Kronecker product x1 x (lambda0,mu0).
+  //
+  // The product is returned in a small-buffer vector, which holds it
+  // without heap allocation.
+  {
+    u3::SU3ProductBuffer product;
+    KroneckerProduct<lambda0,mu0>(x1,std::back_inserter(product));
+    return product;
+  }
+
+  template <int lambda0, int mu0, typename tOutputIterator>
+    tOutputIterator KroneckerProduct(const u3::U3& omega1, const u3::U3& omega0, tOutputIterator out)
+  // Write U(3) Kronecker product omega1 x omega0 through output
+  // iterator, where omega0 has SU(3) labels (lambda0,mu0), e.g.,
+  // KroneckerProduct<0,2>(omega,u3::U3(0,0,-2),out).
+  //
+  // Only product irreps with valid U(3) labels are retained.
+  {
+    assert((omega0.SU3()==u3::SU3(lambda0,mu0)));
+    const HalfInt N = omega1.N()+omega0.N();
+    const int lambda1 = omega1.SU3().lambda(), mu1 = omega1.SU3().mu();
+    const u3::SU3 x1 = omega1.SU3();
+    auto visitor = [&out,&x1,&N,lambda1,mu1](int delta_lambda, int delta_mu)
+      {
+        const int lambda3 = lambda1+delta_lambda, mu3 = mu1+delta_mu;
+        if ((lambda3<0)||(mu3<0))
+          return;
+        const u3::SU3 x3(lambda3,mu3);
+        const int multiplicity = OuterMultiplicity<lambda0,mu0>(x1,x3);
+        if (multiplicity==0)
+          return;
+        const u3::U3 omega3(N,x3);
+        if (omega3.Valid())
+          *out++ = MultiplicityTagged<u3::U3>(omega3,multiplicity);
+      };
+    FixedCouplingShifts<lambda0,mu0>::Visit(visitor);
+    return out;
+  }
+
+  template <int lambda0, int mu0>
+    u3::U3ProductBuffer KroneckerProduct(const u3::U3& omega1, const u3::U3& omega0)
+  // Generate U(3) Kronecker product omega1 x omega0, where omega0 has
+  // SU(3) labels (lambda0,mu0).
+  //
+  // The product is returned in a small-buffer vector, which holds it
+  // without heap allocation.
+  {
+    u3::U3ProductBuffer product;
+    KroneckerProduct<lambda0,mu0>(omega1,omega0,std::back_inserter(product));
+    return product;
+  }
+
+  template <int lambda2, int mu2>
+    u3::SU3ProductBuffer KroneckerPreimage(const u3::SU3& x3)
+  // Generate SU(3) irreps x1 with x1 x (lambda2,mu2) containing x3.
+  //
+  // Fixed-operator counterpart to KroneckerPreimage, e.g.,
+  // KroneckerPreimage<2,0>(x3) gives the irreps x1 which are raised
+  // to x3 by a (2,0) boson creation operator.
+  {
+    return KroneckerProduct<mu2,lambda2>(x3);
+  }
+
+  template <int lambda2, int mu2>
+    u3::U3ProductBuffer KroneckerPreimage(const u3::U3& omega2, const u3::U3& omega3)
+  // Generate U(3) irreps omega1 with omega1 x omega2 containing
+  // omega3, where omega2 has SU(3) labels (lambda2,mu2).
+  {
+    return KroneckerProduct<mu2,lambda2>(omega3,Conjugate(omega2));
+  }
+
   ////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////
   // branching
@@ -650,6 +1403,28 @@ namespace u3
   //   BranchingMultiplicity(u3::SU3(4,3),3)
   //   returns 2
 
+  void BranchingMultiplicitySO3Batch(
+      std::size_t n, const int* lambda, const int* mu, const int* L,
+      int* multiplicities
+    );
+  // Calculate branching multiplicities for a batch of (x,L) pairs.
+  //
+  // Branch-free counterpart to BranchingMultiplicitySO3, with the
+  // same AVX2 and scalar code paths as OuterMultiplicityBatch.
+  //
+  // Arguments:
+  //   n (std::size_t): number of entries
+  //   lambda, mu (const int*): labels of SU(3) irreps (each of size n)
+  //   L (const int*): angular momenta (size n)
+  //   multiplicities (int*): output multiplicities (size n)
+
+  void BranchingMultiplicitySO3Batch(
+      const u3::SU3Batch& x, const std::vector<int>& L,
+      std::vector<int>& multiplicities
+    );
+  // Overloaded for label batches.  The output vector is resized as
+  // needed.
+
   MultiplicityTagged<int>::vector BranchingSO3(const u3::SU3& x);
   // Generate multiplicity-tagged vector of SO(3) irreps in SU(3) irrep.
   //
@@ -0,0 +1,162 @@
+/****************************************************************
+  u3_allocation_test.cpp
+
+  Count heap allocations in Kronecker product evaluation.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+
+****************************************************************/
+
+#include "sp3rlib/u3.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// allocation counting
+////////////////////////////////////////////////////////////////
+
+// Global operator new is replaced by a counting version for the
+// duration of this program.
+
+static long g_allocation_count = 0;
+
+void* operator new(std::size_t size)
+{
+  ++g_allocation_count;
+  void* pointer = std::malloc(size ? size : 1);
+  if (!pointer)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+////////////////////////////////////////////////////////////////
+// product loops
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::U3> PolynomialLabels(int Nn_max)
+// Generate raising polynomial labels, as in
+// sp3r::RaisingPolynomialLabels.
+{
+  std::vector<u3::U3> poly_labels;
+  poly_labels.push_back(u3::U3(0,0,0));
+  for (int N=0; N<=Nn_max; N+=2)
+    for (int a=N-2; a>=0; a-=2)
+      for (int b=2*(a/4); b>=std::max((2*a-N),0); b-=2)
+        poly_labels.push_back(u3::U3(N-a,a-b,b));
+  return poly_labels;
+}
+
+template <typename tBuffer>
+long SpaceProductAllocations(const u3::U3& sigma, const std::vector<u3::U3>& n_vec, tBuffer& buffer)
+// Count allocations in product step of Sp3RSpace construction (sigma
+// x n for each raising polynomial n).
+{
+  long start_count = g_allocation_count;
+  for (const u3::U3& n : n_vec)
+    u3::KroneckerProduct(sigma,n,buffer);
+  return g_allocation_count-start_count;
+}
+
+template <typename tBuffer>
+long LoweringProductAllocations(const std::vector<u3::U3>& omega_vec, tBuffer& buffer)
+// Count allocations in product step of S-matrix generation (omega x
+// (0,0,-2) for each omega).
+{
+  long start_count = g_allocation_count;
+  for (const u3::U3& omega : omega_vec)
+    u3::KroneckerProduct(omega,u3::U3(0,0,-2),buffer);
+  return g_allocation_count-start_count;
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+
+  const u3::U3 sigma(HalfInt(45,2),HalfInt(33,2),HalfInt(29,2));
+  const int Nn_max = 8;
+  std::vector<u3::U3> n_vec = PolynomialLabels(Nn_max);
+
+  // collect omega labels, as would appear in space
+  std::vector<u3::U3> omega_vec;
+  for (const u3::U3& n : n_vec)
+    for (const MultiplicityTagged<u3::U3>& omega_tagged : u3::KroneckerProduct(sigma,n))
+      omega_vec.push_back(omega_tagged.irrep);
+  std::cout << fmt::format("sigma {} Nn_max {} polynomials {} omegas {}",
+                           sigma.Str(),Nn_max,n_vec.size(),omega_vec.size())
+            << std::endl;
+
+  // allocating interface (for comparison)
+  long start_count = g_allocation_count;
+  for (const u3::U3& n : n_vec)
+    u3::KroneckerProduct(sigma,n);
+  std::cout << fmt::format("  returned vector: allocations {}",g_allocation_count-start_count) << std::endl;
+
+  // vector buffer: first pass grows buffer, second pass should not allocate
+  MultiplicityTagged<u3::U3>::vector vector_buffer;
+  long warmup = SpaceProductAllocations(sigma,n_vec,vector_buffer);
+  long steady_state
+    = SpaceProductAllocations(sigma,n_vec,vector_buffer)
+    + LoweringProductAllocations(omega_vec,vector_buffer);
+  std::cout << fmt::format("  vector buffer: warmup allocations {} steady-state allocations {}",
+                           warmup,steady_state)
+            << std::endl;
+
+  // small-buffer vector: first pass grows buffer, second pass should not allocate
+  u3::U3ProductBuffer small_buffer;
+  warmup = SpaceProductAllocations(sigma,n_vec,small_buffer);
+  long small_steady_state
+    = SpaceProductAllocations(sigma,n_vec,small_buffer)
+    + LoweringProductAllocations(omega_vec,small_buffer);
+  std::cout << fmt::format("  small buffer: warmup allocations {} steady-state allocations {}",
+                           warmup,small_steady_state)
+            << std::endl;
+
+  // SU(3) products with (2,0) and (0,2) fit in small buffer from the start
+  u3::SU3ProductBuffer su3_buffer;
+  start_count = g_allocation_count;
+  for (const u3::U3& omega : omega_vec)
+    {
+      u3::KroneckerProduct(omega.SU3(),u3::SU3(2,0),su3_buffer);
+      u3::KroneckerProduct(omega.SU3(),u3::SU3(0,2),su3_buffer);
+    }
+  long su3_allocations = g_allocation_count-start_count;
+  std::cout << fmt::format("  SU(3) x (2,0),(0,2) small buffer: allocations {}",su3_allocations) << std::endl;
+
+  // output iterator
+  MultiplicityTagged<u3::SU3> output_array[16];
+  start_count = g_allocation_count;
+  std::size_t num_written = 0;
+  for (const u3::U3& omega : omega_vec)
+    num_written += u3::KroneckerProduct(omega.SU3(),u3::SU3(2,0),output_array)-output_array;
+  std::cout << fmt::format("  SU(3) x (2,0) output iterator: irreps {} allocations {}",
+                           num_written,g_allocation_count-start_count)
+            << std::endl;
+
+  bool pass = (steady_state==0) && (small_steady_state==0) && (su3_allocations==0);
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+
+}
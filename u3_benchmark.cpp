@@ -0,0 +1,454 @@
+/****************************************************************
+  u3_benchmark.cpp
+
+  Timing and validation of SU(3) coupling kernels.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created, with Kronecker product benchmark.
+  10/16/26 (mac): Add outer multiplicity table benchmark.
+  10/16/26 (mac): Add batch multiplicity kernel benchmark.
+  10/16/26 (mac): Add Kronecker product cache benchmark.
+  10/16/26 (mac): Add fixed-operator coupling kernel benchmark.
+  10/16/26 (mac): Add multi-fold Kronecker product benchmark.
+
+****************************************************************/
+
+#include "sp3rlib/u3.h"
+#include "sp3rlib/u3product.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// timing helper
+////////////////////////////////////////////////////////////////
+
+typedef std::chrono::steady_clock ClockType;
+
+double ElapsedSeconds(const ClockType::time_point& start_time)
+// Return time (in seconds) elapsed since given start time.
+{
+  std::chrono::duration<double> elapsed = ClockType::now()-start_time;
+  return elapsed.count();
+}
+
+////////////////////////////////////////////////////////////////
+// Kronecker product
+////////////////////////////////////////////////////////////////
+
+void KroneckerProductBenchmark(int lm_max, int lm_step)
+// Compare direct enumeration of Kronecker product against the
+// reference grid scan, for all x1,x2 with lambda,mu in
+// 0,lm_step,...,lm_max.
+//
+// Products are compared entry by entry, and any discrepancies are
+// reported.
+{
+  std::cout << fmt::format("Kronecker product: lm_max {} lm_step {}",lm_max,lm_step) << std::endl;
+
+  // enumerate irreps
+  std::vector<u3::SU3> irreps;
+  for (int lambda=0; lambda<=lm_max; lambda+=lm_step)
+    for (int mu=0; mu<=lm_max; mu+=lm_step)
+      irreps.push_back(u3::SU3(lambda,mu));
+
+  // validation pass
+  int num_mismatches = 0;
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      {
+        MultiplicityTagged<u3::SU3>::vector product = u3::KroneckerProduct(x1,x2);
+        MultiplicityTagged<u3::SU3>::vector reference = u3::KroneckerProductGridScan(x1,x2);
+        if (product!=reference)
+          {
+            ++num_mismatches;
+            std::cout << fmt::format("  mismatch {} x {}",x1.Str(),x2.Str()) << std::endl;
+          }
+      }
+  std::cout << fmt::format("  products {} mismatches {}",irreps.size()*irreps.size(),num_mismatches) << std::endl;
+
+  // timing: grid scan
+  std::size_t checksum_scan = 0;
+  ClockType::time_point start_time = ClockType::now();
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      checksum_scan += u3::KroneckerProductGridScan(x1,x2).size();
+  double time_scan = ElapsedSeconds(start_time);
+
+  // timing: direct enumeration
+  std::size_t checksum_direct = 0;
+  start_time = ClockType::now();
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      checksum_direct += u3::KroneckerProduct(x1,x2).size();
+  double time_direct = ElapsedSeconds(start_time);
+
+  std::cout << fmt::format("  product irreps {} (grid scan {})",checksum_direct,checksum_scan) << std::endl;
+  std::cout << fmt::format("  time grid scan {:.3f} s direct {:.3f} s speedup {:.1f}",
+                           time_scan,time_direct,time_scan/time_direct)
+            << std::endl;
+}
+
+////////////////////////////////////////////////////////////////
+// outer multiplicity table
+////////////////////////////////////////////////////////////////
+
+void GenerateCouplingTriples(
+    int lm_max, int num_triples,
+    std::vector<u3::SU3>& x1_set, std::vector<u3::SU3>& x2_set, std::vector<u3::SU3>& x3_set
+  )
+// Generate pseudorandom triples x1 x x2 -> x3 with lambda,mu<=lm_max.
+//
+// Half of the triples are drawn from the Kronecker product (so have
+// nonzero multiplicity), and half have arbitrary x3 (mostly zero
+// multiplicity), as in typical label screening.
+{
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> label_distribution(0,lm_max);
+  x1_set.clear();
+  x2_set.clear();
+  x3_set.clear();
+  while (int(x3_set.size())<num_triples)
+    {
+      u3::SU3 x1(label_distribution(generator),label_distribution(generator));
+      u3::SU3 x2(label_distribution(generator),label_distribution(generator));
+      u3::SU3 x3(label_distribution(generator),label_distribution(generator));
+      if (x3_set.size()%2==0)
+        {
+          MultiplicityTagged<u3::SU3>::vector product = u3::KroneckerProduct(x1,x2);
+          x3 = product[generator()%product.size()].irrep;
+          if ((x3.lambda()>lm_max)||(x3.mu()>lm_max))
+            continue;
+        }
+      x1_set.push_back(x1);
+      x2_set.push_back(x2);
+      x3_set.push_back(x3);
+    }
+}
+
+void MultiplicityTableBenchmark(int lm_max, int num_triples, int num_passes)
+// Compare throughput of OuterMultiplicity (arithmetic formula) and
+// MultiplicityTable::Get (table lookup).
+{
+  std::cout << fmt::format("Multiplicity table: lm_max {} triples {} passes {}",lm_max,num_triples,num_passes) << std::endl;
+
+  // build table
+  ClockType::time_point start_time = ClockType::now();
+  u3::MultiplicityTable::Build(lm_max);
+  double time_build = ElapsedSeconds(start_time);
+  std::cout << fmt::format("  build time {:.3f} s footprint {:.1f} MB",
+                           time_build,u3::MultiplicityTable::MemoryFootprint()/1e6)
+            << std::endl;
+
+  // generate test triples
+  std::vector<u3::SU3> x1_set, x2_set, x3_set;
+  GenerateCouplingTriples(lm_max,num_triples,x1_set,x2_set,x3_set);
+
+  // validation pass
+  int num_mismatches = 0;
+  for (int i=0; i<num_triples; ++i)
+    if (u3::MultiplicityTable::Get(x1_set[i],x2_set[i],x3_set[i])!=u3::OuterMultiplicity(x1_set[i],x2_set[i],x3_set[i]))
+      ++num_mismatches;
+  std::cout << fmt::format("  mismatches {}",num_mismatches) << std::endl;
+
+  // timing: arithmetic
+  long checksum_direct = 0;
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (int i=0; i<num_triples; ++i)
+      checksum_direct += u3::OuterMultiplicity(x1_set[i],x2_set[i],x3_set[i]);
+  double time_direct = ElapsedSeconds(start_time);
+
+  // timing: table
+  long checksum_table = 0;
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (int i=0; i<num_triples; ++i)
+      checksum_table += u3::MultiplicityTable::Get(x1_set[i],x2_set[i],x3_set[i]);
+  double time_table = ElapsedSeconds(start_time);
+
+  double num_calls = double(num_triples)*num_passes;
+  std::cout << fmt::format("  checksum direct {} table {}",checksum_direct,checksum_table) << std::endl;
+  std::cout << fmt::format("  throughput direct {:.1f} Mcall/s table {:.1f} Mcall/s",
+                           num_calls/time_direct/1e6,num_calls/time_table/1e6)
+            << std::endl;
+
+  u3::MultiplicityTable::Clear();
+}
+
+////////////////////////////////////////////////////////////////
+// batch multiplicity kernels
+////////////////////////////////////////////////////////////////
+
+void BatchMultiplicityBenchmark(int lm_max, int num_triples, int num_passes)
+// Compare throughput of scalar and batch multiplicity kernels.
+{
+  std::cout << fmt::format("Batch multiplicity: lm_max {} triples {} passes {}",lm_max,num_triples,num_passes) << std::endl;
+
+  // generate test triples
+  std::vector<u3::SU3> x1_set, x2_set, x3_set;
+  GenerateCouplingTriples(lm_max,num_triples,x1_set,x2_set,x3_set);
+  std::vector<int> L_set(num_triples);
+  for (int i=0; i<num_triples; ++i)
+    L_set[i] = i%(2*lm_max+1);
+  u3::SU3Batch x1_batch, x2_batch, x3_batch;
+  for (int i=0; i<num_triples; ++i)
+    {
+      x1_batch.push_back(x1_set[i]);
+      x2_batch.push_back(x2_set[i]);
+      x3_batch.push_back(x3_set[i]);
+    }
+
+  // outer multiplicity: validation
+  std::vector<int> multiplicities;
+  u3::OuterMultiplicityBatch(x1_batch,x2_batch,x3_batch,multiplicities);
+  int num_mismatches = 0;
+  for (int i=0; i<num_triples; ++i)
+    if (multiplicities[i]!=u3::OuterMultiplicity(x1_set[i],x2_set[i],x3_set[i]))
+      ++num_mismatches;
+  std::cout << fmt::format("  outer multiplicity mismatches {}",num_mismatches) << std::endl;
+
+  // outer multiplicity: timing
+  double num_calls = double(num_triples)*num_passes;
+  ClockType::time_point start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (int i=0; i<num_triples; ++i)
+      multiplicities[i] = u3::OuterMultiplicity(x1_set[i],x2_set[i],x3_set[i]);
+  double time_scalar = ElapsedSeconds(start_time);
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    u3::OuterMultiplicityBatch(x1_batch,x2_batch,x3_batch,multiplicities);
+  double time_batch = ElapsedSeconds(start_time);
+  std::cout << fmt::format("  outer multiplicity scalar {:.1f} Mcall/s batch {:.1f} Mcall/s",
+                           num_calls/time_scalar/1e6,num_calls/time_batch/1e6)
+            << std::endl;
+
+  // branching multiplicity: validation
+  u3::BranchingMultiplicitySO3Batch(x3_batch,L_set,multiplicities);
+  num_mismatches = 0;
+  for (int i=0; i<num_triples; ++i)
+    if (multiplicities[i]!=u3::BranchingMultiplicitySO3(x3_set[i],L_set[i]))
+      ++num_mismatches;
+  std::cout << fmt::format("  branching multiplicity mismatches {}",num_mismatches) << std::endl;
+
+  // branching multiplicity: timing
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (int i=0; i<num_triples; ++i)
+      multiplicities[i] = u3::BranchingMultiplicitySO3(x3_set[i],L_set[i]);
+  time_scalar = ElapsedSeconds(start_time);
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    u3::BranchingMultiplicitySO3Batch(x3_batch,L_set,multiplicities);
+  time_batch = ElapsedSeconds(start_time);
+  std::cout << fmt::format("  branching multiplicity scalar {:.1f} Mcall/s batch {:.1f} Mcall/s",
+                           num_calls/time_scalar/1e6,num_calls/time_batch/1e6)
+            << std::endl;
+}
+
+////////////////////////////////////////////////////////////////
+// Kronecker product cache
+////////////////////////////////////////////////////////////////
+
+void KroneckerProductCacheBenchmark(int Nmax, int num_passes)
+// Compare direct and cached Kronecker products over all pairs of
+// raising polynomial SU(3) labels, as in GenerateBCoefCache.
+{
+  std::cout << fmt::format("Kronecker product cache: Nmax {} passes {}",Nmax,num_passes) << std::endl;
+
+  // raising polynomial labels
+  std::vector<u3::SU3> irreps;
+  irreps.push_back(u3::SU3(0,0));
+  for (int N=0; N<=Nmax; N+=2)
+    for (int a=N-2; a>=0; a-=2)
+      for (int b=2*(a/4); b>=std::max((2*a-N),0); b-=2)
+        irreps.push_back(u3::U3(N-a,a-b,b).SU3());
+
+  // validation pass
+  u3::KroneckerProductCache cache;
+  int num_mismatches = 0;
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      if (cache.Get(x1,x2)!=u3::KroneckerProduct(x1,x2))
+        ++num_mismatches;
+  std::cout << fmt::format("  pairs {} cached products {} mismatches {} hit rate {:.3f}",
+                           irreps.size()*irreps.size(),cache.size(),num_mismatches,cache.HitRate())
+            << std::endl;
+
+  // timing: direct
+  std::size_t checksum_direct = 0;
+  ClockType::time_point start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (const u3::SU3& x1 : irreps)
+      for (const u3::SU3& x2 : irreps)
+        checksum_direct += u3::KroneckerProduct(x1,x2).size();
+  double time_direct = ElapsedSeconds(start_time);
+
+  // timing: cached
+  std::size_t checksum_cached = 0;
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (const u3::SU3& x1 : irreps)
+      for (const u3::SU3& x2 : irreps)
+        checksum_cached += cache.Get(x1,x2).size();
+  double time_cached = ElapsedSeconds(start_time);
+
+  std::cout << fmt::format("  checksum direct {} cached {}",checksum_direct,checksum_cached) << std::endl;
+  std::cout << fmt::format("  time direct {:.3f} s cached {:.3f} s hits {} misses {} hit rate {:.3f}",
+                           time_direct,time_cached,cache.hits(),cache.misses(),cache.HitRate())
+            << std::endl;
+}
+
+////////////////////////////////////////////////////////////////
+// fixed-operator coupling kernels
+////////////////////////////////////////////////////////////////
+
+template <int lambda0, int mu0>
+void FixedCouplingBenchmark(int lm_max, int num_passes)
+// Compare fixed-operator kernels against general Kronecker product
+// and outer multiplicity, for all x1 with lambda,mu<=lm_max.
+{
+  std::cout << fmt::format("Fixed coupling ({},{}): lm_max {} passes {}",lambda0,mu0,lm_max,num_passes) << std::endl;
+  const u3::SU3 x0(lambda0,mu0);
+  const int N0 = (lambda0>mu0) ? 2 : ((lambda0<mu0) ? -2 : 0);  // boson or generator
+  const u3::U3 omega0(HalfInt(N0,1),x0);
+
+  // validation pass
+  int num_mismatches = 0;
+  for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+    for (int mu1=0; mu1<=lm_max; ++mu1)
+      {
+        const u3::SU3 x1(lambda1,mu1);
+        u3::SU3ProductBuffer product = u3::KroneckerProduct<lambda0,mu0>(x1);
+        MultiplicityTagged<u3::SU3>::vector reference = u3::KroneckerProduct(x1,x0);
+        if ((product.size()!=reference.size())||!std::equal(product.begin(),product.end(),reference.begin()))
+          ++num_mismatches;
+        for (int lambda3=0; lambda3<=lm_max+2; ++lambda3)
+          for (int mu3=0; mu3<=lm_max+2; ++mu3)
+            {
+              const u3::SU3 x3(lambda3,mu3);
+              if (u3::OuterMultiplicity<lambda0,mu0>(x1,x3)!=u3::OuterMultiplicity(x1,x0,x3))
+                ++num_mismatches;
+            }
+        // U(3) variant
+        const u3::U3 omega1(HalfInt(3*lm_max+lambda1+2*mu1,1),x1);
+        u3::U3ProductBuffer u3_product = u3::KroneckerProduct<lambda0,mu0>(omega1,omega0);
+        MultiplicityTagged<u3::U3>::vector u3_reference = u3::KroneckerProduct(omega1,omega0);
+        if ((u3_product.size()!=u3_reference.size())||!std::equal(u3_product.begin(),u3_product.end(),u3_reference.begin()))
+          ++num_mismatches;
+      }
+  std::cout << fmt::format("  mismatches {}",num_mismatches) << std::endl;
+
+  // timing
+  std::size_t checksum_general = 0;
+  u3::SU3ProductBuffer buffer;
+  ClockType::time_point start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+      for (int mu1=0; mu1<=lm_max; ++mu1)
+        {
+          u3::KroneckerProduct(u3::SU3(lambda1,mu1),x0,buffer);
+          checksum_general += buffer.size();
+        }
+  double time_general = ElapsedSeconds(start_time);
+  std::size_t checksum_fixed = 0;
+  start_time = ClockType::now();
+  for (int pass=0; pass<num_passes; ++pass)
+    for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+      for (int mu1=0; mu1<=lm_max; ++mu1)
+        checksum_fixed += u3::KroneckerProduct<lambda0,mu0>(u3::SU3(lambda1,mu1)).size();
+  double time_fixed = ElapsedSeconds(start_time);
+  std::cout << fmt::format("  checksum general {} fixed {}",checksum_general,checksum_fixed) << std::endl;
+  std::cout << fmt::format("  time general {:.3f} s fixed {:.3f} s speedup {:.1f}",
+                           time_general,time_fixed,time_general/time_fixed)
+            << std::endl;
+}
+
+////////////////////////////////////////////////////////////////
+// multi-fold Kronecker product
+////////////////////////////////////////////////////////////////
+
+void MultiKroneckerBenchmark(const std::vector<u3::SU3>& factors)
+// Validate multi-fold Kronecker product against naive successive
+// coupling, and report size of coupling graph.
+{
+  std::cout << "Multi-fold Kronecker product:";
+  for (const u3::SU3& x : factors)
+    std::cout << " " << x.Str();
+  std::cout << std::endl;
+
+  // naive successive coupling (exploded list of coupling paths)
+  ClockType::time_point start_time = ClockType::now();
+  std::vector<u3::SU3> paths(1,u3::SU3(0,0));
+  for (const u3::SU3& factor : factors)
+    {
+      std::vector<u3::SU3> next_paths;
+      for (const u3::SU3& x : paths)
+        for (const MultiplicityTagged<u3::SU3>& x_rho : u3::KroneckerProduct(x,factor))
+          next_paths.insert(next_paths.end(),x_rho.tag,x_rho.irrep);
+      paths.swap(next_paths);
+    }
+  std::sort(paths.begin(),paths.end());
+  MultiplicityTagged<u3::SU3>::vector reference;
+  for (const u3::SU3& x : paths)
+    if (reference.empty()||!(reference.back().irrep==x))
+      reference.push_back(MultiplicityTagged<u3::SU3>(x,1));
+    else
+      ++reference.back().tag;
+  double time_naive = ElapsedSeconds(start_time);
+
+  // accumulated multiplicities
+  start_time = ClockType::now();
+  MultiplicityTagged<u3::SU3>::vector decomposition = u3::MultiKroneckerProduct(factors);
+  double time_multi = ElapsedSeconds(start_time);
+
+  // coupling graph
+  start_time = ClockType::now();
+  u3::MultiKroneckerDAG dag(factors);
+  double time_dag = ElapsedSeconds(start_time);
+
+  // dimension check
+  long dimension_product = 1, dimension_sum = 0;
+  for (const u3::SU3& x : factors)
+    dimension_product *= u3::dim(x);
+  for (const MultiplicityTagged<u3::SU3>& x_rho : decomposition)
+    dimension_sum += long(x_rho.tag)*u3::dim(x_rho.irrep);
+
+  std::cout << fmt::format("  irreps {} paths {} matches naive {} matches graph {} dimension {} {}",
+                           decomposition.size(),paths.size(),
+                           decomposition==reference,decomposition==dag.Decomposition(),
+                           dimension_product,dimension_sum)
+            << std::endl;
+  std::cout << fmt::format("  graph nodes {} edges {}",dag.num_nodes(),dag.num_edges()) << std::endl;
+  std::cout << fmt::format("  time naive {:.4f} s accumulated {:.4f} s graph {:.4f} s",
+                           time_naive,time_multi,time_dag)
+            << std::endl;
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+
+  KroneckerProductBenchmark(60,4);
+  MultiplicityTableBenchmark(12,1000000,20);
+  BatchMultiplicityBenchmark(30,1000000,20);
+  KroneckerProductCacheBenchmark(24,10);
+  FixedCouplingBenchmark<2,0>(40,200);
+  FixedCouplingBenchmark<0,2>(40,200);
+  FixedCouplingBenchmark<1,1>(40,200);
+  MultiKroneckerBenchmark(std::vector<u3::SU3>(8,u3::SU3(2,0)));
+  MultiKroneckerBenchmark({u3::SU3(2,0),u3::SU3(1,1),u3::SU3(4,2),u3::SU3(0,2),u3::SU3(2,0),u3::SU3(3,1)});
+
+}
@@ -9,6 +9,8 @@
   3/7/16 (aem,mac): Created.
   3/8/16 (aem,mac): Add tests for U3ST.
   3/9/16 (aem,mac): Update includes and namespaces.
+  10/16/26 (mac): Add tests for IrrepRegistry.
+  10/16/26 (mac): Add tests for KroneckerPreimage.
 
 ****************************************************************/
 
@@ -18,6 +20,7 @@
 #include <algorithm>
 
 #include "am/am.h"
+#include "sp3rlib/irrep_registry.h"
 
 int main(int argc, char **argv)
 {
@@ -190,4 +193,57 @@ int main(int argc, char **argv)
             }
       }
 
+  ////////////////////////////////////////////////////////////////
+  // irrep registry
+  ////////////////////////////////////////////////////////////////
+
+  std::cout << "Irrep registry" << std::endl;
+  u3::SU3Registry su3_registry;
+  for (const MultiplicityTagged<u3::SU3>& x_rho : u3::KroneckerProduct(u3::SU3(2,1),u3::SU3(1,2)))
+    su3_registry.Intern(x_rho.irrep);
+  su3_registry.Intern(u3::SU3(2,1));  // repeated
+  for (int id=0; id<int(su3_registry.size()); ++id)
+    std::cout << "  " << id << " " << su3_registry.GetIrrep(id).Str()
+              << " " << su3_registry.LookUpId(su3_registry.GetIrrep(id)) << std::endl;
+  std::cout << "  size " << su3_registry.size()
+            << " lookup missing " << su3_registry.LookUpId(u3::SU3(9,9)) << std::endl;
+
+  u3::U3SRegistry u3s_registry;
+  u3s_registry.Intern(u3::U3S(u3::U3(HalfInt(7,2),u3::SU3(2,0)),HalfInt(1,2)));
+  u3s_registry.Intern(u3::U3S(u3::U3(HalfInt(7,2),u3::SU3(2,0)),HalfInt(3,2)));
+  u3s_registry.Intern(u3::U3S(u3::U3(HalfInt(7,2),u3::SU3(2,0)),HalfInt(1,2)));
+  for (int id=0; id<int(u3s_registry.size()); ++id)
+    std::cout << "  " << id << " " << u3s_registry.GetIrrep(id).Str() << std::endl;
+
+  ////////////////////////////////////////////////////////////////
+  // Kronecker preimage
+  ////////////////////////////////////////////////////////////////
+
+  std::cout << "Kronecker preimage" << std::endl;
+  {
+    u3::SU3 x2(2,1), x3(3,2);
+    MultiplicityTagged<u3::SU3>::vector preimage = u3::KroneckerPreimage(x2,x3);
+    for (const MultiplicityTagged<u3::SU3>& x1_rho : preimage)
+      std::cout << "  " << x1_rho.Str()
+                << " " << u3::OuterMultiplicity(x1_rho.irrep,x2,x3)
+                << std::endl;
+
+    // check against brute force scan
+    int num_found = 0;
+    for (int lambda1=0; lambda1<=10; ++lambda1)
+      for (int mu1=0; mu1<=10; ++mu1)
+        if (u3::OuterMultiplicity(u3::SU3(lambda1,mu1),x2,x3)>0)
+          ++num_found;
+    std::cout << "  preimage size " << preimage.size() << " brute force " << num_found << std::endl;
+
+    // U(3) and fixed-operator forms
+    u3::U3 omega3(HalfInt(13,1),u3::SU3(4,0));
+    for (const MultiplicityTagged<u3::U3>& omega1_rho : u3::KroneckerPreimage(u3::U3(2,0,0),omega3))
+      std::cout << "  " << omega1_rho.Str();
+    std::cout << std::endl;
+    for (const MultiplicityTagged<u3::U3>& omega1_rho : u3::KroneckerPreimage<2,0>(u3::U3(2,0,0),omega3))
+      std::cout << "  " << omega1_rho.Str();
+    std::cout << std::endl;
+  }
+
 } //main
@@ -9,9 +9,16 @@
   SPDX-License-Identifier: MIT
 ****************************************************************/
 #include "sp3rlib/u3coef.h"
+#include "sp3rlib/u3coef_backend.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 
 #include "fmt/format.h"
 
@@ -19,27 +26,115 @@
 
 namespace u3
 {
+
+  bool g_su3lib_serialized = true;
+  std::mutex g_su3lib_mutex;
+
+  inline std::unique_lock<std::mutex> Su3libLock()
+  // Acquire lock for su3lib call (if serialization enabled).
+  {
+    std::unique_lock<std::mutex> lock(g_su3lib_mutex,std::defer_lock);
+    if (g_su3lib_serialized)
+      lock.lock();
+    return lock;
+  }
   
+  ////////////////////////////////////////////////////////////////
+  // su3lib instrumentation
+  ////////////////////////////////////////////////////////////////
+
+  // call counts and times (ns), indexed by Su3libRoutine
+  static std::atomic<long> g_su3lib_calls[kNumSu3libRoutines];
+  static std::atomic<long> g_su3lib_nanoseconds[kNumSu3libRoutines];
+
+  class Su3libTimer
+  // Scoped timer for su3lib call, to be constructed after the su3lib
+  // lock is acquired.
+  {
+  public:
+    explicit Su3libTimer(Su3libRoutine routine)
+      : routine_(int(routine)), start_time_(std::chrono::steady_clock::now())
+    {}
+
+    ~Su3libTimer()
+    {
+      long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now()-start_time_
+        ).count();
+      g_su3lib_calls[routine_].fetch_add(1,std::memory_order_relaxed);
+      g_su3lib_nanoseconds[routine_].fetch_add(nanoseconds,std::memory_order_relaxed);
+    }
+
+  private:
+    int routine_;
+    std::chrono::steady_clock::time_point start_time_;
+  };
+
+  const char* Su3libRoutineName(Su3libRoutine routine)
+  {
+    static const char* const kNames[kNumSu3libRoutines]
+      = {"wru3optimized","wzu3optimized","wu3r3w","wu39lm"};
+    return kNames[int(routine)];
+  }
+
+  Su3libRoutineStats GetSu3libStats(Su3libRoutine routine)
+  {
+    Su3libRoutineStats stats;
+    stats.calls = g_su3lib_calls[int(routine)].load(std::memory_order_relaxed);
+    stats.time = 1e-9*g_su3lib_nanoseconds[int(routine)].load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  void ResetSu3libStats()
+  {
+    for (int routine=0; routine<kNumSu3libRoutines; ++routine)
+      {
+        g_su3lib_calls[routine].store(0,std::memory_order_relaxed);
+        g_su3lib_nanoseconds[routine].store(0,std::memory_order_relaxed);
+      }
+  }
+
+  void Su3libReport(std::ostream& os)
+  {
+    for (int routine=0; routine<kNumSu3libRoutines; ++routine)
+      {
+        Su3libRoutineStats stats = GetSu3libStats(Su3libRoutine(routine));
+        os << fmt::format("su3lib {} {} {:.6f}",Su3libRoutineName(Su3libRoutine(routine)),stats.calls,stats.time)
+           << std::endl;
+      }
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // initialization
+  ////////////////////////////////////////////////////////////////
+
   void U3CoefInit()
   {
     su3lib::blocks_();
   }
 
-  double W(const u3::SU3& x1, int k1, int L1, const u3::SU3& x2, int k2, int L2, const u3::SU3& x3, int k3, int L3, int r0)
+  static bool MultiplicityLabelInRange(int label, int label_max)
+  // Check that multiplicity label lies in 1..label_max.
   {
-    double w_array[su3lib::MAX_K][su3lib::MAX_K][su3lib::MAX_K][su3lib::MAX_K];
-    // Zero initialize
-    memset(w_array,0,sizeof(w_array));
-    //su3lib::wu3r3w_(x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x3.lambda(), x3.mu(), L1 , L2, L3, r0,1,1,1, w_array);
-    // arguements in positions 10-13 are dummy variables which are set in code; Will return max value if variable is passed.
-    // that is 
-    //   r0=1;
-    //   su3lib::wu3r3w_(x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x3.lambda(), x3.mu(), L1 , L2, L3, rho_max,1,1,1, w_array);
-    //   now r0=rho_max;
-    su3lib::wu3r3w_(x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x3.lambda(), x3.mu(), L1 , L2, L3, 1,1,1,1, w_array);
+    return (label>=1)&&(label<=label_max);
+  }
 
-    //Using row-major C to access column-major Fortran array
-    return w_array[k3-1][k2-1][k1-1][r0-1];
+  double W(const u3::SU3& x1, int k1, int L1, const u3::SU3& x2, int k2, int L2, const u3::SU3& x3, int k3, int L3, int r0)
+  {
+    // validate multiplicity indices (zero coefficient outside range)
+    int kappa1_max, kappa2_max, kappa3_max, rho_max;
+    std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = WMultiplicity(x1,L1,x2,L2,x3,L3);
+    if (!(
+            MultiplicityLabelInRange(k1,kappa1_max)
+            &&MultiplicityLabelInRange(k2,kappa2_max)
+            &&MultiplicityLabelInRange(k3,kappa3_max)
+            &&MultiplicityLabelInRange(r0,rho_max)
+          ))
+      return 0.;
+
+    std::vector<double> w_block;
+    u3::WMultiplicityTuple multiplicities = WBlock(x1,L1,x2,L2,x3,L3,w_block);
+    return w_block[WBlockIndex(multiplicities,k1,k2,k3,r0)];
   }
 
   u3::UMultiplicityTuple UMultiplicity(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x,
@@ -81,101 +176,198 @@ namespace u3
             const u3::SU3& x12, int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23,
             UZMode mode
             )
+  {
+    // validate multiplicity indices (zero coefficient outside range)
+    int r12_max, r12_3_max, r23_max, r1_23_max;
+    std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = UMultiplicity(x1,x2,x,x3,x12,x23);
+    if (!(
+            MultiplicityLabelInRange(r12,r12_max)
+            &&MultiplicityLabelInRange(r12_3,r12_3_max)
+            &&MultiplicityLabelInRange(r23,r23_max)
+            &&MultiplicityLabelInRange(r1_23,r1_23_max)
+          ))
+      return 0.;
+
+    // compute block of coefficients
+    std::vector<double> u_block;
+    u3::UMultiplicityTuple multiplicities = UZBlock(x1,x2,x,x3,x12,x23,mode,u_block);
+
+    // retrieve value of interest
+    return u_block[UZBlockIndex(multiplicities,r12,r12_3,r23,r1_23)];
+  }
+   
+  double Phi(const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x3, int r, int rp)
+  // Phi phase factor that arrises in chainging the coupling order of SU(3) irreps 
+  {
+    return Z(x1,u3::SU3(0,0),x3,x2,x1,1,r,x2,1,rp);
+  }
+
+  double Unitary9LambdaMu(
+                          const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+                          const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+                          const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+                          int r13,     int r24,     int r12_34)    
+  {
+    // validate multiplicity indices (zero coefficient outside range)
+    if (!(
+            MultiplicityLabelInRange(r12,u3::OuterMultiplicity(x1,x2,x12))
+            &&MultiplicityLabelInRange(r34,u3::OuterMultiplicity(x3,x4,x34))
+            &&MultiplicityLabelInRange(r13,u3::OuterMultiplicity(x1,x3,x13))
+            &&MultiplicityLabelInRange(r24,u3::OuterMultiplicity(x2,x4,x24))
+            &&MultiplicityLabelInRange(r13_24,u3::OuterMultiplicity(x13,x24,x))
+            &&MultiplicityLabelInRange(r12_34,u3::OuterMultiplicity(x12,x34,x))
+          ))
+      return 0.;
+
+    std::vector<double> nine_lm_block;
+    u3::NineLMMultiplicityTuple multiplicities
+      = Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,nine_lm_block);
+    return nine_lm_block[Unitary9LambdaMuBlockIndex(multiplicities,r12,r34,r12_34,r13,r24,r13_24)];
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // block access
+  ////////////////////////////////////////////////////////////////
+
+  u3::UMultiplicityTuple UZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      UZMode mode,
+      std::vector<double>& block
+    )
+  {
+    return CurrentCoefBackend().UZBlock(x1,x2,x,x3,x12,x23,mode,block);
+  }
+
+  u3::WMultiplicityTuple WBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    )
+  {
+    return CurrentCoefBackend().WBlock(x1,L1,x2,L2,x3,L3,block);
+  }
+
+  u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+      std::vector<double>& block
+    )
+  {
+    return CurrentCoefBackend().Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,block);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // direct su3lib block access
+  ////////////////////////////////////////////////////////////////
+
+  u3::UMultiplicityTuple Su3libUZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      UZMode mode,
+      std::vector<double>& block
+    )
   {
     // compute multiplicity
     int r12_max, r12_3_max, r23_max, r1_23_max;
     std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = UMultiplicity(x1,x2,x,x3,x12,x23);
     int r_max=r12_max*r12_3_max*r23_max*r1_23_max;
-    // std::cout<<fmt::format("{} {} {} {}",r12_max,r12_3_max,r23_max,r1_23_max)<<std::endl;
     assert(r_max > 0);
  
     // compute block of coefficients
-    std::vector<double> u_array(r_max);
+    block.resize(r_max);
+    std::unique_lock<std::mutex> lock = Su3libLock();
     if (mode == UZMode::kU)
       {
-        //        su3lib::wru3optimized_(
+        Su3libTimer timer(Su3libRoutine::kWRU3);
         WRU3_FUNCTION(
                       x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x.lambda(), x.mu(), x3.lambda(), x3.mu(), x12.lambda(), x12.mu(), x23.lambda(), x23.mu(),
                       r12_max, r12_3_max, r23_max, r1_23_max, 
-                      &u_array[0], r_max
+                      block.data(), r_max
                       );
       }
     else
       {
         // calculate Z
+        Su3libTimer timer(Su3libRoutine::kWZU3);
         su3lib::wzu3optimized_(
                                x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x.lambda(), x.mu(), x3.lambda(), x3.mu(), x12.lambda(), x12.mu(), x23.lambda(), x23.mu(),
                                r12_max, r12_3_max, r23_max, r1_23_max, 
-                               &u_array[0], r_max
+                               block.data(), r_max
                                );
       }
 
-    // validate multiplicity indices
-    assert(
-           (r12_max   >= r12)
-           &&(r12_3_max >= r12_3)
-           &&(r23_max   >= r23)
-           &&(r1_23_max >= r1_23)
-           );
-
-    // calculate index into block
-    //
-    // build up index, dimension by dimension
-    //
-    // equivalent to (but with fewer multiplies and potentially better mult+add structure)
-    //   index=r12+r12_max_*(r12_3-1)+r12_max_*r12_3_max_*(r23-1)+r12_max_*r12_3_max_*r23_max_*(r1_23-1)-1;
-    int index = (r1_23-1);
-    index = index * r23_max + (r23-1);
-    index = index * r12_3_max + (r12_3-1);
-    index = index * r12_max + (r12-1);
-
-    // retrieve value of interest
-    double value = u_array[index];
-    return value;
+    return UMultiplicityTuple(r12_max,r12_3_max,r23_max,r1_23_max);
   }
-   
-  double Phi(const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x3, int r, int rp)
-  // Phi phase factor that arrises in chainging the coupling order of SU(3) irreps 
+
+  u3::WMultiplicityTuple Su3libWBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    )
   {
-    return Z(x1,u3::SU3(0,0),x3,x2,x1,1,r,x2,1,rp);
-  }
+    // compute multiplicity
+    int kappa1_max, kappa2_max, kappa3_max, rho_max;
+    std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = WMultiplicity(x1,L1,x2,L2,x3,L3);
 
+    // compute full array of coefficients
+    //
+    // Arguments in positions 10-13 are dummy variables which are set
+    // in code, to the maximum values of the multiplicities.
+    double w_array[su3lib::MAX_K][su3lib::MAX_K][su3lib::MAX_K][su3lib::MAX_K];
+    memset(w_array,0,sizeof(w_array));
+    {
+      std::unique_lock<std::mutex> lock = Su3libLock();
+      Su3libTimer timer(Su3libRoutine::kWU3R3W);
+      su3lib::wu3r3w_(x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x3.lambda(), x3.mu(), L1 , L2, L3, 1,1,1,1, w_array);
+    }
+
+    // extract block
+    block.resize(rho_max*kappa1_max*kappa2_max*kappa3_max);
+    auto position = block.begin();
+    for(int rho=1; rho<=rho_max; ++rho)
+      for(int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+        for(int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+          for(int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+            //Using row-major C to access column-major Fortran array
+            *(position++) = w_array[kappa3-1][kappa2-1][kappa1-1][rho-1];
 
+    return WMultiplicityTuple(kappa1_max,kappa2_max,kappa3_max,rho_max);
+  }
 
-  double Unitary9LambdaMu(
-                          const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
-                          const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
-                          const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
-                          int r13,     int r24,     int r12_34)    
+  u3::NineLMMultiplicityTuple Su3libUnitary9LambdaMuBlock(
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+      std::vector<double>& block
+    )
   {
+    // compute multiplicity
     int r12_max=u3::OuterMultiplicity(x1,x2,x12);
     int r34_max=u3::OuterMultiplicity(x3,x4,x34);
     int r13_max=u3::OuterMultiplicity(x1,x3,x13);
     int r24_max=u3::OuterMultiplicity(x2,x4,x24);
     int r13_24_max=u3::OuterMultiplicity(x13,x24,x);
     int r12_34_max=u3::OuterMultiplicity(x12,x34,x);
-    //std::vector<double> NLM_array;
-    int index=(
-               r12_max*(r34-1)
-               +r12_max*r34_max*(r12_34_max-1)
-               +r12_max*r34_max*r12_34_max*(r13_max-1)
-               +r12_max*r34_max*r12_34_max*r13_max*(r24_max-1)
-               +r12_max*r34_max*r12_34_max*r13_max*r24_max*(r13_24_max-1)
-               );
     int r_max=r12_max*r34_max*r13_max*r24_max*r12_34_max*r13_24_max;
-    std::vector<double> NLM_array(r_max);
-    // double NLM_array[r_max];
-    //NLM_array.resize(r_max);
+    assert(r_max > 0);
+
+    // compute block of coefficients
+    block.resize(r_max);
+    std::unique_lock<std::mutex> lock = Su3libLock();
+    Su3libTimer timer(Su3libRoutine::kWU39LM);
     su3lib::wu39lm_(
                     x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x12.lambda(), x12.mu(),
                     x3.lambda(), x3.mu(), x4.lambda(), x4.mu(), x34.lambda(), x34.mu(),
                     x13.lambda(), x13.mu(), x24.lambda(), x24.mu(), x.lambda(), x.mu(),
-                    &NLM_array[0],r_max
-                    );    
-    return NLM_array[index];
-  }
+                    block.data(),r_max
+                    );
 
+    return NineLMMultiplicityTuple(r12_max,r34_max,r12_34_max,r13_max,r24_max,r13_24_max);
+  }
 
+  ////////////////////////////////////////////////////////////////
+  // block storage
+  ////////////////////////////////////////////////////////////////
 
   std::string UCoefLabels::Str() const
   {
@@ -186,27 +378,22 @@ namespace u3
     return ss.str();
   }
   
-  UCoefBlock::UCoefBlock(const u3::UCoefLabels& labels)
+  UCoefBlock::UCoefBlock(const u3::UCoefLabels& labels, UZMode mode)
   {
-    // calculate multiplicities
     u3::SU3 x1,x2,x,x3,x12,x23;
     std::tie(x1,x2,x,x3,x12,x23) = labels.Key();
-    std::tie(r12_max_,r12_3_max_,r23_max_,r1_23_max_) = UMultiplicity(x1,x2,x,x3,x12,x23);
+    std::vector<double> coefs;
+    std::tie(r12_max_,r12_3_max_,r23_max_,r1_23_max_) = UZBlock(x1,x2,x,x3,x12,x23,mode,coefs);
+    coefs_.assign(coefs.data(),coefs.size());
+  }
 
-    // pre-size vector
-    int r_max = r12_max_*r12_3_max_*r23_max_*r1_23_max_;
-    assert(r_max > 0);
-    coefs_.resize(r_max);
 
-    // populate vector
-    WRU3_FUNCTION(
-                  x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x.lambda(), x.mu(), x3.lambda(), x3.mu(), x12.lambda(), x12.mu(), x23.lambda(), x23.mu(),
-                  r12_max_, r12_3_max_, r23_max_, r1_23_max_, 
-                  &coefs_[0], r_max
-                  ); 
+  UCoefBlock::UCoefBlock(const KeyType& multiplicities, const double* coefs)
+  {
+    std::tie(r12_max_,r12_3_max_,r23_max_,r1_23_max_) = multiplicities;
+    coefs_.assign(coefs,r12_max_*r12_3_max_*r23_max_*r1_23_max_);
   }
 
-
   double UCoefBlock::GetCoef(int r12, int r12_3, int r23, int r1_23) const
   {
     // validate multiplicity indices
@@ -217,22 +404,108 @@ namespace u3
            &&(r1_23 <= r1_23_max_)
            );
     
-    // calculate index into block
-    //
-    // build up index, dimension by dimension
-    //
-    int index = (r1_23-1);
-    index = index * r23_max_ + (r23-1);
-    index = index * r12_3_max_ + (r12_3-1);
-    index = index * r12_max_ + (r12-1);
-
     // retrieve entry
-    double value = coefs_[index];
+    double value = coefs_[Index(r12,r12_3,r23,r1_23)];
 
     return value;
   }
 
   bool g_u_cache_enabled = true;
+  bool g_u_symmetry_enabled = false;
+
+  bool CheckUConjugationSymmetry(int lm_max, std::ostream* log)
+  {
+    const double kTolerance = 1e-12;
+    std::vector<u3::SU3> irreps;
+    for (int lambda=0; lambda<=lm_max; ++lambda)
+      for (int mu=0; mu<=lm_max; ++mu)
+        irreps.push_back(u3::SU3(lambda,mu));
+
+    // check each conjugate pair once, from its canonical member
+    std::size_t num_blocks = 0, num_blocks_multiplicity = 0;
+    int num_mismatches = 0;
+    std::vector<double> block, conjugate_block;
+    for (const u3::SU3& x1 : irreps)
+      for (const u3::SU3& x2 : irreps)
+        for (const u3::SU3& x3 : irreps)
+          for (const MultiplicityTagged<u3::SU3>& x12_rho : u3::KroneckerProduct(x1,x2))
+            for (const MultiplicityTagged<u3::SU3>& x_rho : u3::KroneckerProduct(x12_rho.irrep,x3))
+              for (const MultiplicityTagged<u3::SU3>& x23_rho : u3::KroneckerProduct(x2,x3))
+                {
+                  const u3::UCoefLabels labels(x1,x2,x_rho.irrep,x3,x12_rho.irrep,x23_rho.irrep);
+                  const u3::UCoefLabels conjugate_labels = labels.Conjugate();
+                  if (!labels.Allowed()||(conjugate_labels<labels))
+                    continue;
+                  for (UZMode mode : {UZMode::kU,UZMode::kZ})
+                    {
+                      u3::SU3 y1,y2,y,y3,y12,y23;
+                      std::tie(y1,y2,y,y3,y12,y23) = labels.Key();
+                      const u3::UMultiplicityTuple multiplicities = u3::UZBlock(y1,y2,y,y3,y12,y23,mode,block);
+                      std::tie(y1,y2,y,y3,y12,y23) = conjugate_labels.Key();
+                      u3::UZBlock(y1,y2,y,y3,y12,y23,mode,conjugate_block);
+                      ++num_blocks;
+                      if (block.size()>1)
+                        ++num_blocks_multiplicity;
+
+                      int r12_max, r12_3_max, r23_max, r1_23_max;
+                      std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = multiplicities;
+                      bool mismatch = false;
+                      for (int r12=1; r12<=r12_max; ++r12)
+                        for (int r12_3=1; r12_3<=r12_3_max; ++r12_3)
+                          for (int r23=1; r23<=r23_max; ++r23)
+                            for (int r1_23=1; r1_23<=r1_23_max; ++r1_23)
+                              {
+                                int index = u3::UZBlockIndex(multiplicities,r12,r12_3,r23,r1_23);
+                                int phase = u3::UConjugationPhase(multiplicities,r12,r12_3,r23,r1_23);
+                                if (std::fabs(conjugate_block[index]-phase*block[index])>kTolerance)
+                                  mismatch = true;
+                              }
+                      if (mismatch)
+                        {
+                          ++num_mismatches;
+                          if (log&&(num_mismatches<=10))
+                            *log << "  " << (mode==UZMode::kU ? "U" : "Z")
+                                 << " conjugation mismatch " << labels.Str() << std::endl;
+                        }
+                    }
+                }
+
+    if (log)
+      *log << fmt::format(
+          "  U/Z conjugation check: lm_max {} blocks {} (with multiplicity {}) mismatches {}",
+          lm_max,num_blocks,num_blocks_multiplicity,num_mismatches
+        ) << std::endl;
+    return (num_mismatches==0);
+  }
+
+  void EnableUSymmetry(int lm_max)
+  {
+    if (!CheckUConjugationSymmetry(lm_max))
+      {
+        CheckUConjugationSymmetry(lm_max,&std::cerr);
+        std::cerr << "ERROR: U/Z conjugation symmetry fails for current coefficient backend" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    g_u_symmetry_enabled = true;
+  }
+
+  template <typename tCache>
+  inline double UZCachedValue(
+      tCache& cache, const u3::UCoefLabels& labels,
+      int r12, int r12_3, int r23, int r1_23
+    )
+  // Retrieve U or Z coefficient from cache, through canonical labels
+  // if symmetry is enabled.
+  {
+    if (!g_u_symmetry_enabled)
+      return cache.GetBlock(labels).GetCoef(r12,r12_3,r23,r1_23);
+    bool conjugated;
+    const auto& block = cache.GetBlock(CanonicalUCoefLabels(labels,conjugated));
+    double value = block.GetCoef(r12,r12_3,r23,r1_23);
+    if (conjugated)
+      value *= UConjugationPhase(block.Key(),r12,r12_3,r23,r1_23);
+    return value;
+  }
 
   double UCached(
                  u3::UCoefCache& cache, 
@@ -245,17 +518,7 @@ namespace u3
       // retrieve from cache
       {
         const u3::UCoefLabels labels(x1,x2,x,x3,x12,x23);
-        // cache.count(labels);
-        // #pragma omp critical (ucoef)
-          {// std::cout<<"thread number "<<omp_get_thread_num()<<std::endl;
-            if (cache.count(labels)==0)
-              {
-                //// #pragma omp critical
-                cache[labels]=u3::UCoefBlock(labels);
-              }
-          }
-        const u3::UCoefBlock& block = cache.at(labels);  // throws exception if entry missing from cache
-        value = block.GetCoef(r12,r12_3,r23,r1_23);
+        value = UZCachedValue(cache,labels,r12,r12_3,r23,r1_23);
       }
     else
       // calculate on the fly
@@ -266,6 +529,30 @@ namespace u3
     return value;
   }
 
+  bool g_z_cache_enabled = true;
+
+  double ZCached(
+                 u3::ZCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 )
+  {
+    double value;
+    if (g_z_cache_enabled)
+      // retrieve from cache
+      {
+        const u3::ZCoefLabels labels(x1,x2,x,x3,x12,x23);
+        value = UZCachedValue(cache,labels,r12,r12_3,r23,r1_23);
+      }
+    else
+      // calculate on the fly
+      {
+        value = u3::Z(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+      }
+
+    return value;
+  }
+
   std::string WCoefLabels::Str() const
   {
     std::ostringstream ss;
@@ -277,26 +564,18 @@ namespace u3
   
   WCoefBlock::WCoefBlock(const u3::WCoefLabels& labels)
   {
-    // calculate multiplicities
     u3::SU3 x1,x2,x3;
     int L1,L2,L3;
     std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
-    std::tie(kappa1_max_,kappa2_max_,kappa3_max_,rho_max_) = WMultiplicity(x1,L1,x2,L2,x3,L3);
-    double w_array[su3lib::MAX_K][su3lib::MAX_K][su3lib::MAX_K][su3lib::MAX_K];
-    // zero initialize array
-    memset(w_array,0,sizeof(w_array));
-    su3lib::wu3r3w_(x1.lambda(), x1.mu(), x2.lambda(), x2.mu(), x3.lambda(), x3.mu(), L1 , L2, L3, 1,1,1,1, w_array);
-    int size=rho_max_*kappa1_max_*kappa2_max_*kappa3_max_;
-
-    //coefs_.resize(size);
-    // coefs are in column-major Fortran array
-    auto position=coefs_.begin();
-    for(int rho=1; rho<=rho_max_; ++rho)
-      for(int kappa2=1; kappa2<=kappa2_max_; ++kappa2)
-        for(int kappa1=1; kappa1<=kappa1_max_; ++kappa1)
-          for(int kappa3=1; kappa3<=kappa3_max_; ++kappa3)
-            //Using row-major C to access column-major Fortran array
-            coefs_.push_back(w_array[kappa3-1][kappa2-1][kappa1-1][rho-1]);
+    std::vector<double> coefs;
+    std::tie(kappa1_max_,kappa2_max_,kappa3_max_,rho_max_) = WBlock(x1,L1,x2,L2,x3,L3,coefs);
+    coefs_.assign(coefs.data(),coefs.size());
+  }
+
+  WCoefBlock::WCoefBlock(const KeyType& multiplicities, const double* coefs)
+  {
+    std::tie(kappa1_max_,kappa2_max_,kappa3_max_,rho_max_) = multiplicities;
+    coefs_.assign(coefs,rho_max_*kappa1_max_*kappa2_max_*kappa3_max_);
   }
 
   double WCoefBlock::GetCoef(int kappa1, int kappa2, int kappa3, int rho) const
@@ -310,16 +589,9 @@ namespace u3
            &&(kappa3 <= kappa3_max_)
            );
     
-    // calculate index into block
-    // equivalent to looking up w_array[k3-1][k2-1][k1-1][r0-1]
-    // build up index, dimension by dimension
-    int index = (rho-1);
-    index = index * kappa2_max_ + (kappa2-1);
-    index = index * kappa1_max_ + (kappa1-1);
-    index = index * kappa3_max_ + (kappa3-1);
-
     // retrieve entry
-    double value = coefs_[index];
+    // equivalent to looking up w_array[k3-1][k2-1][k1-1][r0-1]
+    double value = coefs_[Index(kappa1,kappa2,kappa3,rho)];
 
     return value;
   }
@@ -337,13 +609,7 @@ namespace u3
       // retrieve from cache
       {
         const u3::WCoefLabels labels(x1,L1,x2,L2,x3,L3);
-        // std::cout<<fmt::format("{}  {} {} {} {}",labels.Str(),kappa1,kappa2,kappa3,rho)<<std::endl;
-        // #pragma omp critical (wcoef)
-        {
-          if (cache.count(labels)==0)
-            cache[labels]=u3::WCoefBlock(labels);          
-        }
-        const u3::WCoefBlock& block = cache.at(labels);  // throws exception if entry missing from cache
+        const u3::WCoefBlock& block = cache.GetBlock(labels);
         value = block.GetCoef(kappa1, kappa2, kappa3, rho);
       }
     else
@@ -357,11 +623,7 @@ namespace u3
 
   void WBlockCached(WCoefCache& cache, const u3::WCoefLabels& labels)
   {
-    if (cache.count(labels)==0)
-      {
-        // #pragma omp critical
-        cache[labels]=u3::WCoefBlock(labels);
-      }
+    cache.GetBlock(labels);
   }
 
   std::string PhiCoefLabels::Str() const
@@ -375,19 +637,19 @@ namespace u3
 
   PhiCoefBlock::PhiCoefBlock(const u3::PhiCoefLabels& labels)
   {
-    // calculate multiplicities
+    // Phi coefficients are Z coefficients with x2=(0,0), so
+    // multiplicities are (1,rho_max,1,rho_max)
     u3::SU3 x1,x2,x3;
     std::tie(x1,x2,x3) = labels.Key();
-    rho_max_=u3::OuterMultiplicity(x1,x2,x3);
-    // zero initialize array
-    int rho_dummy=1;
-    int dim=rho_max_*rho_max_;
-    cache_.resize(dim);
-    su3lib::wzu3optimized_(
-     x1.lambda(), x1.mu(), 0, 0, x3.lambda(), x3.mu(), x2.lambda(), x2.mu(), 
-     x1.lambda(), x1.mu(), x2.lambda(), x2.mu(),rho_dummy, rho_max_, rho_dummy, rho_max_, 
-     &cache_[0], dim
-     );
+    std::vector<double> coefs;
+    std::tie(std::ignore,rho_max_,std::ignore,std::ignore) = ZBlock(x1,u3::SU3(0,0),x3,x2,x1,x2,coefs);
+    cache_.assign(coefs.data(),coefs.size());
+  }
+
+  PhiCoefBlock::PhiCoefBlock(const KeyType& multiplicities, const double* coefs)
+  {
+    rho_max_ = std::get<0>(multiplicities);
+    cache_.assign(coefs,rho_max_*rho_max_);
   }
 
   double PhiCoefBlock::GetCoef(int rho1, int rho2) const
@@ -395,10 +657,8 @@ namespace u3
     // validate multiplicity indices
     assert((rho1 <= rho_max_)&&(rho2<=rho_max_));
     
-    int index = (rho2-1);
-    index = index * rho_max_ + (rho1-1);
     // retrieve entry
-    double value = cache_[index];
+    double value = cache_[Index(rho1,rho2)];
 
     return value;
   }
@@ -413,13 +673,7 @@ namespace u3
       // retrieve from cache
       {
         const u3::PhiCoefLabels labels(x1,x2,x3);
-        // #pragma omp critical (phi)
-        {
-          if (cache.count(labels)==0)            
-            cache[labels]=u3::PhiCoefBlock(labels);
-        }
-        
-        const u3::PhiCoefBlock& block = cache.at(labels);  // throws exception if entry missing from cache
+        const u3::PhiCoefBlock& block = cache.GetBlock(labels);
         value = block.GetCoef(rho1, rho2);
       }
     else
@@ -432,6 +686,324 @@ namespace u3
   }
 
 
+  ////////////////////////////////////////////////////////////////
+  // W coefficient exchange symmetry
+  ////////////////////////////////////////////////////////////////
+
+  bool CheckWExchangeSymmetry(int lm_max, std::ostream* log)
+  {
+    const double kTolerance = 1e-12;
+
+    // check each exchanged pair in both orientations, since the
+    // relation as applied by SymmetricWCoefCache (Phi of the
+    // non-canonical labels acting on the canonical block) is only the
+    // inverse of the relation from the canonical side if the Phi
+    // matrices of the two orientations are mutually inverse
+    std::size_t num_blocks = 0, num_blocks_multiplicity = 0;
+    int num_mismatches = 0;
+    std::vector<double> block, exchanged_block, phi_block;
+    for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+      for (int mu1=0; mu1<=lm_max; ++mu1)
+        for (int lambda2=0; lambda2<=lm_max; ++lambda2)
+          for (int mu2=0; mu2<=lm_max; ++mu2)
+            {
+              const u3::SU3 x1(lambda1,mu1), x2(lambda2,mu2);
+              for (const MultiplicityTagged<u3::SU3>& x3_rho : u3::KroneckerProduct(x1,x2))
+                {
+                  const u3::SU3& x3 = x3_rho.irrep;
+                  const u3::UMultiplicityTuple phi_multiplicities
+                    = u3::ZBlock(x1,u3::SU3(0,0),x3,x2,x1,x2,phi_block);
+                  for (const MultiplicityTagged<int>& L1_kappa : u3::BranchingSO3(x1))
+                    for (const MultiplicityTagged<int>& L2_kappa : u3::BranchingSO3(x2))
+                      for (const MultiplicityTagged<int>& L3_kappa : u3::BranchingSO3(x3))
+                        {
+                          const int L1 = L1_kappa.irrep, L2 = L2_kappa.irrep, L3 = L3_kappa.irrep;
+                          if ((L3<std::abs(L1-L2))||(L3>L1+L2))
+                            continue;
+                          const u3::WCoefLabels labels(x1,L1,x2,L2,x3,L3);
+                          const u3::WMultiplicityTuple multiplicities
+                            = u3::WBlock(x1,L1,x2,L2,x3,L3,block);
+                          const u3::WMultiplicityTuple exchanged_multiplicities
+                            = u3::WBlock(x2,L2,x1,L1,x3,L3,exchanged_block);
+                          int kappa1_max, kappa2_max, kappa3_max, rho_max;
+                          std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+                          ++num_blocks;
+                          if (rho_max>1)
+                            ++num_blocks_multiplicity;
+
+                          bool mismatch = false;
+                          for (int rho=1; rho<=rho_max; ++rho)
+                            for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+                              for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+                                for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+                                  {
+                                    double value = 0.;
+                                    for (int rhop=1; rhop<=rho_max; ++rhop)
+                                      value += phi_block[u3::UZBlockIndex(phi_multiplicities,1,rho,1,rhop)]
+                                        *exchanged_block[u3::WBlockIndex(exchanged_multiplicities,kappa2,kappa1,kappa3,rhop)];
+                                    value *= ParitySign(L1+L2-L3);
+                                    if (std::fabs(block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)]-value)>kTolerance)
+                                      mismatch = true;
+                                  }
+                          if (mismatch)
+                            {
+                              ++num_mismatches;
+                              if (log&&(num_mismatches<=10))
+                                *log << "  W exchange mismatch " << labels.Str() << std::endl;
+                            }
+                        }
+                }
+            }
+
+    if (log)
+      *log << fmt::format(
+          "  W exchange check: lm_max {} blocks {} (with multiplicity {}) mismatches {}",
+          lm_max,num_blocks,num_blocks_multiplicity,num_mismatches
+        ) << std::endl;
+    return (num_mismatches==0);
+  }
+
+  constexpr int SymmetricWCoefCache::kValidationLmMax;
+
+  SymmetricWCoefCache::SymmetricWCoefCache(bool validate)
+  {
+    if (validate && !CheckWExchangeSymmetry(kValidationLmMax))
+      {
+        CheckWExchangeSymmetry(kValidationLmMax,&std::cerr);
+        std::cerr << "ERROR: W exchange symmetry fails for current coefficient backend" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+  }
+
+  double SymmetricWCoefCache::GetCoef(
+      const u3::WCoefLabels& labels, int kappa1, int kappa2, int kappa3, int rho
+    )
+  {
+    bool exchanged;
+    const u3::WCoefBlock& block = w_cache_.GetBlock(CanonicalWCoefLabels(labels,exchanged));
+    if (!exchanged)
+      return block.GetCoef(kappa1,kappa2,kappa3,rho);
+
+    // recover from exchanged orientation
+    u3::SU3 x1,x2,x3;
+    int L1,L2,L3;
+    std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+    const u3::PhiCoefBlock& phi_block = phi_cache_.GetBlock(u3::PhiCoefLabels(x1,x2,x3));
+    double value = 0.;
+    for (int rhop=1; rhop<=phi_block.rho_max(); ++rhop)
+      value += phi_block.GetCoef(rho,rhop)*block.GetCoef(kappa2,kappa1,kappa3,rhop);
+    return ParitySign(L1+L2-L3)*value;
+  }
+
+  double WCached(
+                 u3::SymmetricWCoefCache& cache, 
+                 const u3::SU3& x1, int kappa1, int L1, const u3::SU3& x2, int kappa2, int L2, 
+                 const u3::SU3& x3, int kappa3, int L3, int rho 
+                 )
+  {
+    if (!g_w_cache_enabled)
+      return u3::W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+    return cache.GetCoef(u3::WCoefLabels(x1,L1,x2,L2,x3,L3),kappa1,kappa2,kappa3,rho);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // 9-(lambda,mu) symbol caching
+  ////////////////////////////////////////////////////////////////
+
+  std::string NineLMCoefLabels::Str() const
+  {
+    std::ostringstream ss;
+
+    ss << "[" << x1_.Str() << x2_.Str() << x12_.Str()
+       << x3_.Str() << x4_.Str() << x34_.Str()
+       << x13_.Str() << x24_.Str() << x_.Str() << "]";
+    return ss.str();
+  }
+
+  NineLMCoefBlock::NineLMCoefBlock(const u3::NineLMCoefLabels& labels)
+  {
+    u3::SU3 x1,x2,x12,x3,x4,x34,x13,x24,x;
+    std::tie(x1,x2,x12,x3,x4,x34,x13,x24,x) = labels.Key();
+    std::vector<double> coefs;
+    multiplicities_ = Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,coefs);
+    coefs_.assign(coefs.data(),coefs.size());
+  }
+
+  NineLMCoefBlock::NineLMCoefBlock(const KeyType& multiplicities, const double* coefs)
+    : multiplicities_(multiplicities)
+  {
+    int r12_max, r34_max, r12_34_max, r13_max, r24_max, r13_24_max;
+    std::tie(r12_max,r34_max,r12_34_max,r13_max,r24_max,r13_24_max) = multiplicities;
+    coefs_.assign(coefs,r12_max*r34_max*r12_34_max*r13_max*r24_max*r13_24_max);
+  }
+
+  double NineLMCoefBlock::GetCoef(int r12, int r34, int r12_34, int r13, int r24, int r13_24) const
+  {
+    // validate multiplicity indices
+    assert(
+           (r12 <= std::get<0>(multiplicities_))
+           &&(r34 <= std::get<1>(multiplicities_))
+           &&(r12_34 <= std::get<2>(multiplicities_))
+           &&(r13 <= std::get<3>(multiplicities_))
+           &&(r24 <= std::get<4>(multiplicities_))
+           &&(r13_24 <= std::get<5>(multiplicities_))
+           );
+
+    // retrieve entry
+    return coefs_[Index(r12,r34,r12_34,r13,r24,r13_24)];
+  }
+
+  bool g_nine_lm_cache_enabled = true;
+
+  double Unitary9LambdaMuCached(
+      u3::NineLMCoefCache& cache,
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+      int r13,     int r24,     int r12_34
+    )
+  {
+    double value;
+    if (g_nine_lm_cache_enabled)
+      // retrieve from cache
+      {
+        const u3::NineLMCoefLabels labels(x1,x2,x12,x3,x4,x34,x13,x24,x);
+        const u3::NineLMCoefBlock& block = cache.GetBlock(labels);
+        value = block.GetCoef(r12,r34,r12_34,r13,r24,r13_24);
+      }
+    else
+      // calculate on the fly
+      {
+        value = u3::Unitary9LambdaMu(x1,x2,x12,r12,x3,x4,x34,r34,x13,x24,x,r13_24,r13,r24,r12_34);
+      }
+
+    return value;
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // concurrent caching
+  ////////////////////////////////////////////////////////////////
+
+  double UCached(
+                 u3::ConcurrentUCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 )
+  {
+    if (!g_u_cache_enabled)
+      return u3::U(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+    return UZCachedValue(cache,u3::UCoefLabels(x1,x2,x,x3,x12,x23),r12,r12_3,r23,r1_23);
+  }
+
+  double ZCached(
+                 u3::ConcurrentZCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 )
+  {
+    if (!g_z_cache_enabled)
+      return u3::Z(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+    return UZCachedValue(cache,u3::ZCoefLabels(x1,x2,x,x3,x12,x23),r12,r12_3,r23,r1_23);
+  }
+
+  double WCached(
+                 u3::ConcurrentWCoefCache& cache, 
+                 const u3::SU3& x1, int kappa1, int L1, const u3::SU3& x2, int kappa2, int L2, 
+                 const u3::SU3& x3, int kappa3, int L3, int rho 
+                 )
+  {
+    if (!g_w_cache_enabled)
+      return u3::W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+    const u3::WCoefBlock& block = cache.GetBlock(u3::WCoefLabels(x1,L1,x2,L2,x3,L3));
+    return block.GetCoef(kappa1,kappa2,kappa3,rho);
+  }
+
+  double PhiCached(
+         u3::ConcurrentPhiCoefCache& cache, 
+         const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3, int rho1, int rho2 
+        )
+  {
+    if (!g_u_cache_enabled)
+      return u3::Phi(x1,x2,x3,rho1,rho2);
+    const u3::PhiCoefBlock& block = cache.GetBlock(u3::PhiCoefLabels(x1,x2,x3));
+    return block.GetCoef(rho1,rho2);
+  }
+
+  double Unitary9LambdaMuCached(
+      u3::ConcurrentNineLMCoefCache& cache,
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+      int r13,     int r24,     int r12_34
+    )
+  {
+    if (!g_nine_lm_cache_enabled)
+      return u3::Unitary9LambdaMu(x1,x2,x12,r12,x3,x4,x34,r34,x13,x24,x,r13_24,r13,r24,r12_34);
+    const u3::NineLMCoefBlock& block = cache.GetBlock(u3::NineLMCoefLabels(x1,x2,x12,x3,x4,x34,x13,x24,x));
+    return block.GetCoef(r12,r34,r12_34,r13,r24,r13_24);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // memory-bounded caching
+  ////////////////////////////////////////////////////////////////
 
+  double UCached(
+                 u3::BoundedUCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 )
+  {
+    if (!g_u_cache_enabled)
+      return u3::U(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+    return UZCachedValue(cache,u3::UCoefLabels(x1,x2,x,x3,x12,x23),r12,r12_3,r23,r1_23);
+  }
+
+  double ZCached(
+                 u3::BoundedZCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 )
+  {
+    if (!g_z_cache_enabled)
+      return u3::Z(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+    return UZCachedValue(cache,u3::ZCoefLabels(x1,x2,x,x3,x12,x23),r12,r12_3,r23,r1_23);
+  }
+
+  double WCached(
+                 u3::BoundedWCoefCache& cache, 
+                 const u3::SU3& x1, int kappa1, int L1, const u3::SU3& x2, int kappa2, int L2, 
+                 const u3::SU3& x3, int kappa3, int L3, int rho 
+                 )
+  {
+    if (!g_w_cache_enabled)
+      return u3::W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+    const u3::WCoefBlock& block = cache.GetBlock(u3::WCoefLabels(x1,L1,x2,L2,x3,L3));
+    return block.GetCoef(kappa1,kappa2,kappa3,rho);
+  }
+
+  double PhiCached(
+         u3::BoundedPhiCoefCache& cache, 
+         const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3, int rho1, int rho2 
+        )
+  {
+    if (!g_u_cache_enabled)
+      return u3::Phi(x1,x2,x3,rho1,rho2);
+    const u3::PhiCoefBlock& block = cache.GetBlock(u3::PhiCoefLabels(x1,x2,x3));
+    return block.GetCoef(rho1,rho2);
+  }
+
+  double Unitary9LambdaMuCached(
+      u3::BoundedNineLMCoefCache& cache,
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+      int r13,     int r24,     int r12_34
+    )
+  {
+    if (!g_nine_lm_cache_enabled)
+      return u3::Unitary9LambdaMu(x1,x2,x12,r12,x3,x4,x34,r34,x13,x24,x,r13_24,r13,r24,r12_34);
+    const u3::NineLMCoefBlock& block = cache.GetBlock(u3::NineLMCoefLabels(x1,x2,x12,x3,x4,x34,x13,x24,x));
+    return block.GetCoef(r12,r34,r12_34,r13,r24,r13_24);
+  }
 
 } // namespace 
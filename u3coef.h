@@ -16,16 +16,48 @@
   3/10/16 (aem,mac): Created based on prototype u3.py and T. Dytrych
     CSU3Master.
   10/17/16 (mac): Add comment on W.
+  10/16/26 (mac): Hash coefficient labels on packed SU(3) keys.
+  10/16/26 (mac): Add concurrent coefficient caches and serialize su3lib calls.
+  10/16/26 (mac): Document serialization of cache misses by su3lib lock.
+  10/16/26 (mac): Add single-probe GetBlock and contiguous block views.
+  10/16/26 (mac): Add block wrappers UZBlock, WBlock, and Unitary9LambdaMuBlock.
+  10/16/26 (mac): Add Z coefficient caching (ZCoefBlock, ZCoefCache, ZCached).
+  10/16/26 (mac): Add 9-(lambda,mu) symbol caching (NineLMCoefBlock, NineLMCoefCache).
+  10/16/26 (mac): Add memory-bounded caches.
+  10/16/26 (mac): Add cache statistics and su3lib timing.
+  10/16/26 (mac): Store block coefficients in CoefPayload, with arena in CoefCache.
+  10/16/26 (mac): Add conjugation-symmetric U and Z coefficient caching.
+  10/16/26 (mac): Add exchange-symmetric W coefficient cache (SymmetricWCoefCache).
+  10/16/26 (mac): Add runtime selection of native Wigner coefficient engine.
+  10/16/26 (mac): Add runtime selection of native U and Z coefficient engine.
+  10/16/26 (mac): Dispatch block functions through coefficient backend, replacing
+    engine selection, and add direct su3lib block functions.
+  10/16/26 (mac): Validate U/Z conjugation symmetry when enabling it
+    (CheckUConjugationSymmetry, EnableUSymmetry).
+  10/16/26 (mac): Validate W exchange symmetry on construction of
+    SymmetricWCoefCache (CheckWExchangeSymmetry).
+  10/16/26 (mac): Document that native backend is experimental.
+  10/16/26 (mac): Return zero from single-coefficient wrappers for
+    out-of-range multiplicity labels.
+  10/16/26 (mac): Check W exchange relation from both orientations.
+  10/16/26 (mac): Document native U and Z backend as migration path.
 
 ****************************************************************/
 
 #ifndef U3COEF_H_
 #define U3COEF_H_
 
+#include <mutex>
+#include <ostream>
 #include <unordered_map>
 #include <tuple>
+#include <vector>
 #include <boost/functional/hash_fwd.hpp>
 
+#include "sp3rlib/bounded_cache.h"
+#include "sp3rlib/coef_cache_stats.h"
+#include "sp3rlib/coef_payload.h"
+#include "sp3rlib/concurrent_cache.h"
 #include "sp3rlib/u3.h"
 
 
@@ -53,6 +85,249 @@ namespace u3
 
   } //namespace
 
+  ////////////////////////////////////////////////////////////////
+  // su3lib thread safety
+  ////////////////////////////////////////////////////////////////
+
+  // The su3lib routines are not assumed to be reentrant (they may
+  // use static storage), so calls to them are serialized through a
+  // global mutex.  Coefficient caches may thus be populated from
+  // multiple threads, with only the su3lib calls themselves
+  // serialized.  If su3lib has been built reentrant (e.g., with
+  // -frecursive), serialization may be disabled by setting
+  // g_su3lib_serialized to false.
+  //
+  // PERFORMANCE LIMIT: While g_su3lib_serialized is set, every cache
+  // miss, in every thread and in every cache, waits on this one
+  // mutex.  The concurrent caches (ConcurrentUCoefCache, etc.) only
+  // make hits scale with the number of threads.  A parallel region
+  // which mostly misses (e.g., the first sweep over a new basis)
+  // computes its coefficients at single-thread speed, no matter how
+  // many threads are used.  To compute a large set of cold blocks in
+  // parallel, prefill the cache beforehand with PrefillCache
+  // (u3coef_prefill.h), which runs su3lib in forked worker processes,
+  // each with its own su3lib state, and only then enter the parallel
+  // region.
+
+  extern bool g_su3lib_serialized;
+  extern std::mutex g_su3lib_mutex;
+
+  ////////////////////////////////////////////////////////////////
+  // su3lib instrumentation
+  ////////////////////////////////////////////////////////////////
+
+  // Calls to each su3lib routine are counted and timed.  The time is
+  // that spent within the routine itself, excluding any wait for the
+  // serialization lock.  Counters are process-wide and thread-safe.
+
+  enum class Su3libRoutine : int {kWRU3=0, kWZU3=1, kWU3R3W=2, kWU39LM=3};
+  constexpr int kNumSu3libRoutines = 4;
+
+  struct Su3libRoutineStats
+  {
+    long calls;
+    double time;  // seconds
+  };
+
+  const char* Su3libRoutineName(Su3libRoutine routine);
+  // Return name of su3lib routine (Fortran symbol, without trailing
+  // underscore).
+
+  Su3libRoutineStats GetSu3libStats(Su3libRoutine routine);
+  // Return call count and accumulated time for su3lib routine.
+
+  void ResetSu3libStats();
+  // Reset su3lib call counts and times.
+
+  void Su3libReport(std::ostream& os);
+  // Write su3lib call counts and times, as lines of
+  // "su3lib routine calls time".
+
+  ////////////////////////////////////////////////////////////////
+  // coefficient backend selection
+  ////////////////////////////////////////////////////////////////
+
+  // The block functions WBlock, UZBlock, and Unitary9LambdaMuBlock
+  // (and thus W, U, Z, Phi, Unitary9LambdaMu, and all coefficient
+  // caches) dispatch through the current coefficient backend, which
+  // may be su3lib (the default), native U and Z from su3lib W (in
+  // su3lib conventions), a precomputed store on disk, or a shadow
+  // backend which cross-checks one backend against another.  The
+  // migration path to the native engine is the native U and Z
+  // backend, validated by shadowing su3lib with
+  // ShadowComparison::kCoefficients.  Native W coefficients are not
+  // offered as a backend, until their agreement with su3lib is
+  // confirmed by u3coef_native_test.  See u3coef_backend.h.
+  //
+  // Backends need not reproduce the su3lib phase and multiplicity
+  // conventions, so coefficients from different backends should not
+  // be mixed in a calculation, and a backend should only replace
+  // su3lib once it has been checked against su3lib at the level of
+  // the coefficients themselves (ShadowComparison::kCoefficients),
+  // not just block norms.  In particular:
+  //
+  //   - The backend should not be changed while caches hold blocks.
+  //
+  //   - SymmetricWCoefCache combines W with Phi (from ZBlock), so it
+  //     requires both to come from the same conventions.  It checks
+  //     the exchange relation against the current backend when
+  //     constructed, so the backend should be selected first.
+  //
+  //   - The conjugation phase used when g_u_symmetry_enabled is set
+  //     is that of su3lib.  EnableUSymmetry checks it against the
+  //     current backend, so the backend should be selected first.
+
+  ////////////////////////////////////////////////////////////////
+  // coefficient cache
+  ////////////////////////////////////////////////////////////////
+
+  template <typename tLabels, typename tBlock>
+  class CoefCache
+    : public std::unordered_map<tLabels,tBlock,boost::hash<tLabels> >
+  // Cache of coefficient blocks, keyed by labels.
+  //
+  // An unordered_map, augmented with GetBlock, which retrieves (or
+  // constructs) a block with a single hash probe on a hit.  Callers
+  // looping over the multiplicity indices of a block should retrieve
+  // the block once with GetBlock and then index into it, rather than
+  // calling the per-coefficient cached accessors (UCached, etc.),
+  // which repeat the lookup for every coefficient.
+  //
+  // Hits and misses are counted by GetBlock (but not by direct use of
+  // the unordered_map interface, e.g., by PrefillCache).
+  //
+  // Storage: Coefficient values of blocks constructed by GetBlock are
+  // moved into an arena owned by the cache (see CoefPayload), so that
+  // multi-coefficient blocks are packed contiguously rather than each
+  // in its own heap allocation.  Blocks inserted through the
+  // unordered_map interface keep their own storage until Compact is
+  // called.  Arena storage is reclaimed only by clear, not by erasing
+  // individual entries.
+  //
+  // Not thread-safe.  See ConcurrentCoefCache.
+  {
+  public:
+
+    typedef std::unordered_map<tLabels,tBlock,boost::hash<tLabels> > BaseType;
+
+    CoefCache()
+      : hits_(0), misses_(0)
+    {}
+
+    // copies are independent (blocks are copied out of the arena)
+    CoefCache(const CoefCache& cache)
+      : BaseType(cache), hits_(cache.hits_), misses_(cache.misses_)
+    {}
+    CoefCache& operator=(const CoefCache& cache)
+    {
+      if (this!=&cache)
+        {
+          clear();
+          BaseType::operator=(cache);
+          hits_ = cache.hits_;
+          misses_ = cache.misses_;
+        }
+      return *this;
+    }
+    CoefCache(CoefCache&&) = default;
+    CoefCache& operator=(CoefCache&&) = default;
+
+    const tBlock& GetBlock(const tLabels& labels)
+    // Retrieve block for given labels, constructing it if not already
+    // cached.
+    //
+    // The returned reference remains valid until the entry is erased
+    // (rehashing does not invalidate references to unordered_map
+    // elements).
+    {
+      auto it = this->find(labels);
+      if (it==this->end())
+        {
+          ++misses_;
+          it = this->emplace(labels,tBlock(labels)).first;
+          it->second.MoveToArena(arena_);
+        }
+      else
+        ++hits_;
+      return it->second;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // storage
+    ////////////////////////////////////////////////////////////////
+
+    void Compact()
+    // Move coefficient values of all blocks into arena.
+    {
+      for (auto& labels_block : *this)
+        labels_block.second.MoveToArena(arena_);
+    }
+
+    void clear()
+    // Release all blocks and arena storage.
+    {
+      BaseType::clear();
+      arena_.clear();
+    }
+
+    std::size_t arena_bytes() const
+    // Return memory held by arena.
+    {
+      return arena_.bytes();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // statistics
+    ////////////////////////////////////////////////////////////////
+
+    long hits() const
+    {
+      return hits_;
+    }
+
+    long misses() const
+    {
+      return misses_;
+    }
+
+    void ResetStats()
+    // Reset hit and miss counters.
+    {
+      hits_ = misses_ = 0;
+    }
+
+    static std::size_t EntryBytes(const tBlock& block)
+    // Return memory used by entry holding given block.
+    //
+    // This is the coefficient payload (in arena or heap), plus the
+    // hash table node (label and block objects, next pointer, and
+    // cached hash code) and bucket pointer (at load factor 1).
+    {
+      return u3::CoefPayloadBytes(block.size())
+        + sizeof(typename CoefCache::value_type)+sizeof(void*)+sizeof(std::size_t)
+        + sizeof(void*);
+    }
+
+    u3::CoefCacheStats Stats() const
+    // Return snapshot of cache statistics.
+    {
+      u3::CoefCacheStats stats;
+      stats.hits = hits_;
+      stats.misses = misses_;
+      for (const auto& labels_block : *this)
+        stats.AddBlock(labels_block.second.size(),EntryBytes(labels_block.second));
+      return stats;
+    }
+
+  private:
+    // arena for coefficient values (declared after base class, so
+    // destroyed before it, but blocks do not access arena storage on
+    // destruction)
+    u3::CoefArena arena_;
+
+    long hits_, misses_;
+  };
+
   ////////////////////////////////////////////////////////////////
   // wrapper functions for single-coefficient access
   ////////////////////////////////////////////////////////////////
@@ -71,7 +346,8 @@ namespace u3
   //   r0 (int): outer multiplicity label on coupling coefficient
   //
   // Returns:
-  //   (double): value of coefficient
+  //   (double): value of coefficient (zero if any multiplicity label
+  //     lies outside its range, including if the block is empty)
 
 
   typedef std::tuple<int,int,int,int> UMultiplicityTuple;
@@ -114,7 +390,8 @@ namespace u3
   //   mode (UZMode): kU for U coefficient [(1x2)x3 to 1x(2x3)], kZ for Z coefficient [(1x2)x3 to 2x(1x3)]
   //
   // Returns:
-  //   (double): value of coefficient
+  //   (double): value of coefficient (zero if any multiplicity label
+  //     lies outside its range, including if the block is empty)
 
   inline
   double U(
@@ -148,6 +425,182 @@ namespace u3
   // Compute SU(3) unitary 9-(lambda,mu) symbol.
   //
   // Provides wrapper for su3lib function wu39lm_
+  //
+  // Returns zero if any multiplicity label lies outside its range,
+  // including if the block is empty.
+
+  ////////////////////////////////////////////////////////////////
+  // wrapper functions for block access
+  ////////////////////////////////////////////////////////////////
+
+  // Each su3lib call computes the full block of coefficients over all
+  // multiplicity indices.  These functions return the whole block, in
+  // a caller-provided buffer, so that callers needing several
+  // multiplicity components make only a single su3lib call.  The
+  // single-coefficient functions above are implemented in terms of
+  // these.
+  //
+  // The buffer is resized to the block size (the product of the
+  // multiplicities), and its existing capacity is reused.
+
+  u3::UMultiplicityTuple UZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      UZMode mode,
+      std::vector<double>& block
+    );
+  // Calculate block of SU(3) Racah recoupling coefficients.
+  //
+  // Coefficients are stored with r12 varying fastest, then r12_3,
+  // r23, and r1_23 slowest (see UZBlockIndex).
+  //
+  // Arguments:
+  //   x1, x2, ... (u3::SU3): SU3 labels for recoupling coefficient
+  //   mode (UZMode): kU for U coefficient, kZ for Z coefficient
+  //   block (std::vector<double>, output): coefficient values
+  //
+  // Returns:
+  //   (UMultiplicityTuple): tuple of multiplicities (r12_max,r12_3_max,r23_max,r1_23_max)
+
+  inline
+  u3::UMultiplicityTuple UBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      std::vector<double>& block
+    )
+  // Calculate block of U coefficients.  See comment for UZBlock above.
+  {
+    return u3::UZBlock(x1,x2,x,x3,x12,x23,UZMode::kU,block);
+  }
+
+  inline
+  u3::UMultiplicityTuple ZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      std::vector<double>& block
+    )
+  // Calculate block of Z coefficients.  See comment for UZBlock above.
+  {
+    return u3::UZBlock(x1,x2,x,x3,x12,x23,UZMode::kZ,block);
+  }
+
+  inline
+  int UZBlockIndex(
+      const u3::UMultiplicityTuple& multiplicities,
+      int r12, int r12_3, int r23, int r1_23
+    )
+  // Calculate position of coefficient in block returned by UZBlock.
+  {
+    int r12_max, r12_3_max, r23_max, r1_23_max;
+    std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = multiplicities;
+    int index = (r1_23-1);
+    index = index * r23_max + (r23-1);
+    index = index * r12_3_max + (r12_3-1);
+    index = index * r12_max + (r12-1);
+    return index;
+  }
+
+  u3::WMultiplicityTuple WBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    );
+  // Calculate block of SU(3) reduced coupling (Wigner) coefficients.
+  //
+  // Coefficients are stored with kappa3 varying fastest, then
+  // kappa1, kappa2, and rho slowest (see WBlockIndex).
+  //
+  // Arguments:
+  //   x1, x2, x3 (u3::SU3): SU3 labels for coupling coefficient
+  //   L1, L2, L3 (int): SO(3) labels for coupling coefficient
+  //   block (std::vector<double>, output): coefficient values
+  //
+  // Returns:
+  //   (WMultiplicityTuple): tuple of multiplicities (kappa1_max,kappa2_max,kappa3_max,rho_max)
+
+  inline
+  int WBlockIndex(
+      const u3::WMultiplicityTuple& multiplicities,
+      int kappa1, int kappa2, int kappa3, int rho
+    )
+  // Calculate position of coefficient in block returned by WBlock.
+  {
+    int kappa1_max, kappa2_max, kappa3_max, rho_max;
+    std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+    int index = (rho-1);
+    index = index * kappa2_max + (kappa2-1);
+    index = index * kappa1_max + (kappa1-1);
+    index = index * kappa3_max + (kappa3-1);
+    return index;
+  }
+
+  typedef std::tuple<int,int,int,int,int,int> NineLMMultiplicityTuple;
+  u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+      std::vector<double>& block
+    );
+  // Calculate block of SU(3) unitary 9-(lambda,mu) symbols.
+  //
+  // Coefficients are stored in su3lib order, with r12 varying
+  // fastest, then r34, r12_34, r13, r24, and r13_24 slowest (see
+  // Unitary9LambdaMuBlockIndex).
+  //
+  // Arguments:
+  //   x1, x2, ... (u3::SU3): SU3 labels for 9-(lambda,mu) symbol
+  //   block (std::vector<double>, output): coefficient values
+  //
+  // Returns:
+  //   (NineLMMultiplicityTuple): tuple of multiplicities
+  //     (r12_max,r34_max,r12_34_max,r13_max,r24_max,r13_24_max)
+
+  inline
+  int Unitary9LambdaMuBlockIndex(
+      const u3::NineLMMultiplicityTuple& multiplicities,
+      int r12, int r34, int r12_34, int r13, int r24, int r13_24
+    )
+  // Calculate position of coefficient in block returned by
+  // Unitary9LambdaMuBlock.
+  {
+    int r12_max, r34_max, r12_34_max, r13_max, r24_max, r13_24_max;
+    std::tie(r12_max,r34_max,r12_34_max,r13_max,r24_max,r13_24_max) = multiplicities;
+    int index = (r13_24-1);
+    index = index * r24_max + (r24-1);
+    index = index * r13_max + (r13-1);
+    index = index * r12_34_max + (r12_34-1);
+    index = index * r34_max + (r34-1);
+    index = index * r12_max + (r12-1);
+    return index;
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // direct su3lib block access
+  ////////////////////////////////////////////////////////////////
+
+  // Evaluate blocks with su3lib, bypassing the coefficient backend.
+  // Same interface and block layout as UZBlock, WBlock, and
+  // Unitary9LambdaMuBlock.  These are the implementation of the su3lib
+  // backend, and are also used by other backends for coefficients
+  // they do not provide themselves.
+
+  u3::UMultiplicityTuple Su3libUZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      UZMode mode,
+      std::vector<double>& block
+    );
+
+  u3::WMultiplicityTuple Su3libWBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    );
+
+  u3::NineLMMultiplicityTuple Su3libUnitary9LambdaMuBlock(
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+      std::vector<double>& block
+    );
 
 
   ////////////////////////////////////////////////////////////////
@@ -183,6 +636,15 @@ namespace u3
       return KeyType(x1_, x2_, x_, x3_, x12_, x23_);
     }
 
+    inline UCoefLabels Conjugate() const
+    // Return labels with all SU(3) irreps conjugated.
+    {
+      return UCoefLabels(
+          u3::Conjugate(x1_),u3::Conjugate(x2_),u3::Conjugate(x_),
+          u3::Conjugate(x3_),u3::Conjugate(x12_),u3::Conjugate(x23_)
+        );
+    }
+
     ////////////////////////////////////////////////////////////////
     // validation
     ////////////////////////////////////////////////////////////////
@@ -201,7 +663,8 @@ namespace u3
     ////////////////////////////////////////////////////////////////
     inline friend bool operator == (const UCoefLabels& coef1, const UCoefLabels& coef2)
     {
-      return coef1.Key() == coef2.Key();
+      return (coef1.x1_==coef2.x1_) && (coef1.x2_==coef2.x2_) && (coef1.x_==coef2.x_)
+        && (coef1.x3_==coef2.x3_) && (coef1.x12_==coef2.x12_) && (coef1.x23_==coef2.x23_);
     }
 
     inline friend bool operator < (const UCoefLabels& coef1, const UCoefLabels& coef2)
@@ -210,9 +673,15 @@ namespace u3
     }
 
     inline friend std::size_t hash_value(UCoefLabels const& ucoef_labels)
+    // Hash by combining packed keys of SU(3) labels.
     {
-      boost::hash<UCoefLabels::KeyType> hasher;
-      return hasher(ucoef_labels.Key());
+      std::size_t seed = PackedHash(ucoef_labels.x1_.PackedKey());
+      seed = PackedHashCombine(seed,ucoef_labels.x2_.PackedKey());
+      seed = PackedHashCombine(seed,ucoef_labels.x_.PackedKey());
+      seed = PackedHashCombine(seed,ucoef_labels.x3_.PackedKey());
+      seed = PackedHashCombine(seed,ucoef_labels.x12_.PackedKey());
+      seed = PackedHashCombine(seed,ucoef_labels.x23_.PackedKey());
+      return seed;
     }
 
     ////////////////////////////////////////////////////////////////
@@ -236,8 +705,8 @@ namespace u3
   // Class to store and retrieve block of U coefficients sharing same
   // SU(3) labels but with different multiplicity indices
   //
-  // FUTURE: Can generalize to store blocks of Z coefficients as well,
-  // like function UZ above.
+  // May alternatively hold a block of Z coefficients, like function UZ
+  // above (see ZCoefBlock).
   {
   public:
 
@@ -256,7 +725,11 @@ namespace u3
     : r12_max_(0), r12_3_max_(0), r23_max_(0), r1_23_max_(0){}
     // Construct and store multiplicites and coefficient values
 
-    UCoefBlock(const u3::UCoefLabels& labels);
+    UCoefBlock(const u3::UCoefLabels& labels, UZMode mode = UZMode::kU);
+
+    UCoefBlock(const KeyType& multiplicities, const double* coefs);
+    // Construct from given multiplicities and coefficient values
+    // (e.g., as retrieved from a CoefStore).
 
     ////////////////////////////////////////////////////////////////
     // accessors
@@ -273,6 +746,38 @@ namespace u3
 
     double GetCoef(int r12, int r12_3, int r23, int r1_23) const;
 
+    inline int Index(int r12, int r12_3, int r23, int r1_23) const
+    // Calculate position of coefficient in block (see data()).
+    {
+      int index = (r1_23-1);
+      index = index * r23_max_ + (r23-1);
+      index = index * r12_3_max_ + (r12_3-1);
+      index = index * r12_max_ + (r12-1);
+      return index;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // contiguous view
+    ////////////////////////////////////////////////////////////////
+
+    inline const double* data() const
+    // Return pointer to coefficients, with r12 varying fastest and
+    // r1_23 slowest (see Index).
+    {
+      return coefs_.data();
+    }
+
+    inline std::size_t size() const
+    {
+      return coefs_.size();
+    }
+
+    inline void MoveToArena(u3::CoefArena& arena)
+    // Move coefficient storage into cache arena (see CoefPayload).
+    {
+      coefs_.MoveToArena(arena);
+    }
+
     ////////////////////////////////////////////////////////////////
     // string conversion
     ////////////////////////////////////////////////////////////////
@@ -287,7 +792,7 @@ namespace u3
     // multiplicities
     int r12_max_, r12_3_max_, r23_max_, r1_23_max_;
     // coefficient values
-    std::vector<double> coefs_;
+    u3::CoefPayload coefs_;
 
   }; //end UCoefLabels
 
@@ -295,10 +800,7 @@ namespace u3
   // U coefficient caching
   ////////////////////////////////////////////////////////////////
 
-  typedef std::unordered_map<
-    u3::UCoefLabels,
-    u3::UCoefBlock,
-    boost::hash<u3::UCoefLabels> > UCoefCache;
+  typedef u3::CoefCache<u3::UCoefLabels,u3::UCoefBlock> UCoefCache;
 
   extern bool g_u_cache_enabled;
   double UCached(
@@ -321,6 +823,157 @@ namespace u3
   // Returns;
   //   (double): single coefficient value
 
+  ////////////////////////////////////////////////////////////////
+  // Z coefficient caching
+  ////////////////////////////////////////////////////////////////
+
+  // Z coefficients carry the same labels and multiplicity structure
+  // as U coefficients, so the U label and block classes are reused.
+
+  typedef u3::UCoefLabels ZCoefLabels;
+
+  class ZCoefBlock
+    : public UCoefBlock
+  // Block of Z coefficients sharing same SU(3) labels but with
+  // different multiplicity indices.
+  {
+  public:
+
+    inline ZCoefBlock() {}
+
+    inline ZCoefBlock(const u3::ZCoefLabels& labels)
+      : UCoefBlock(labels,UZMode::kZ) {}
+    // Construct and store multiplicites and coefficient values
+
+    inline ZCoefBlock(const KeyType& multiplicities, const double* coefs)
+      : UCoefBlock(multiplicities,coefs) {}
+  };
+
+  typedef u3::CoefCache<u3::ZCoefLabels,u3::ZCoefBlock> ZCoefCache;
+
+  extern bool g_z_cache_enabled;
+  double ZCached(
+                 ZCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 );
+  // Cached SU(3) Racah recoupling coefficient for recoupling from (1x2)x3 to 2x(1x3). 
+  //
+  // Global:
+  //
+  //   u3::g_z_cache_enabled (bool): mode flag determining whether to
+  //     use caching or calculate on the fly (for debugging and
+  //     profiling)
+  //
+  // Arguments:
+  //   cache (ZCoefCache): cache to use for Z coefficients
+  //   x1, ...: standard Z coefficient SU(3) and multiplicity labels
+  //     (as for U coefficient)
+  //
+  // Returns;
+  //   (double): single coefficient value
+
+  ////////////////////////////////////////////////////////////////
+  // U and Z coefficient conjugation symmetry
+  ////////////////////////////////////////////////////////////////
+
+  // Under conjugation of all SU(3) labels, U and Z coefficients are
+  // unchanged up to a phase depending on the multiplicity indices:
+  //
+  //   U(x1~,x2~,x~,x3~,x12~,r12,r12_3,x23~,r23,r1_23)
+  //     = (-1)^[(r12_max-r12)+(r12_3_max-r12_3)+(r23_max-r23)+(r1_23_max-r1_23)]
+  //       * U(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23)
+  //
+  // and likewise for Z.  Each reduced Wigner coefficient acquires a
+  // phase (-1)^[ConjugationGrade(x1)+ConjugationGrade(x2)-ConjugationGrade(x3)+rho_max-rho]
+  // under conjugation, in the su3lib convention.  The grade terms
+  // cancel between the two couplings of the bra and the two of the
+  // ket, leaving only the multiplicity terms.  Conjugate labels have
+  // the same multiplicities, so the block for the conjugate labels has
+  // the same layout (the multiplicity-index permutation is trivial).
+  //
+  // If g_u_symmetry_enabled is set, the cached accessors for U and Z
+  // coefficients (UCached and ZCached, for all cache types) and the
+  // prefill wrappers (PrefillUCache and PrefillZCache) store only the
+  // block for the canonical labels (the lesser of the labels and their
+  // conjugate), and apply the phase on lookup.  This halves the number
+  // of blocks cached and calculated, for label sets closed under
+  // conjugation.  Code retrieving blocks directly (GetBlock) sees the
+  // labels it requests, and may canonicalize with CanonicalUCoefLabels
+  // and UConjugationPhase.
+  //
+  // Only conjugation is used, so the saving is at most a factor of
+  // two.  The permutation symmetries of U and Z (the SU(3) analogues
+  // of the tetrahedral symmetries of the 6-j symbol, which act on the
+  // multiplicity indices through Phi matrices rather than a phase)
+  // are not implemented.
+  //
+  // The symmetry is disabled by default.  It should be enabled through
+  // EnableUSymmetry, which first checks the relation against the
+  // current backend on a grid of small irreps including blocks with
+  // outer multiplicity (CheckUConjugationSymmetry), rather than by
+  // setting g_u_symmetry_enabled directly.  The full check over a
+  // larger grid is made by u3coef_symmetry_test.
+
+  extern bool g_u_symmetry_enabled;
+
+  inline u3::UCoefLabels CanonicalUCoefLabels(const u3::UCoefLabels& labels, bool& conjugated)
+  // Return canonical labels for U or Z coefficient block, under
+  // conjugation.
+  //
+  // Arguments:
+  //   labels (u3::UCoefLabels): labels
+  //   conjugated (bool, output): whether canonical labels are the
+  //     conjugate of the given labels
+  //
+  // Returns:
+  //   (u3::UCoefLabels): canonical labels
+  {
+    u3::UCoefLabels conjugate_labels = labels.Conjugate();
+    conjugated = (conjugate_labels<labels);
+    return conjugated ? conjugate_labels : labels;
+  }
+
+  inline int UConjugationPhase(
+      const u3::UMultiplicityTuple& multiplicities,
+      int r12, int r12_3, int r23, int r1_23
+    )
+  // Return phase relating U (or Z) coefficient to that with
+  // conjugate labels.
+  //
+  // Arguments:
+  //   multiplicities (u3::UMultiplicityTuple): block multiplicities
+  //     (as given by UCoefBlock::Key())
+  //   r12, ...: multiplicity indices
+  {
+    int r12_max, r12_3_max, r23_max, r1_23_max;
+    std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = multiplicities;
+    return ParitySign((r12_max-r12)+(r12_3_max-r12_3)+(r23_max-r23)+(r1_23_max-r1_23));
+  }
+
+  bool CheckUConjugationSymmetry(int lm_max = 2, std::ostream* log = nullptr);
+  // Check conjugation relation for U and Z coefficient blocks, as
+  // calculated by the current backend.
+  //
+  // All allowed labels with x1, x2, and x3 having lambda,mu<=lm_max
+  // are checked (lm_max>=1 is needed to include blocks with outer
+  // multiplicity, and lm_max=2 reaches multiplicity 3).
+  //
+  // Arguments:
+  //   lm_max (int, optional): maximum lambda and mu of x1, x2, x3
+  //   log (std::ostream*, optional): stream for listing mismatched
+  //     labels and summary
+  //
+  // Returns:
+  //   (bool): whether all blocks satisfy the relation
+
+  void EnableUSymmetry(int lm_max = 2);
+  // Enable conjugation-symmetric caching of U and Z coefficients (set
+  // g_u_symmetry_enabled), after checking the relation with
+  // CheckUConjugationSymmetry.
+  //
+  // Aborts if the check fails.
+
 
   class WCoefLabels
   // Class to gather and provide hashing for U coefficient labels
@@ -351,6 +1004,12 @@ namespace u3
       return KeyType(x1_, L1_, x2_, L2_, x3_,  L3_);
     }
 
+    inline WCoefLabels Exchange() const
+    // Return labels with coupled irreps 1 and 2 exchanged.
+    {
+      return WCoefLabels(x2_,L2_,x1_,L1_,x3_,L3_);
+    }
+
     ////////////////////////////////////////////////////////////////
     // validation
     ////////////////////////////////////////////////////////////////
@@ -369,7 +1028,9 @@ namespace u3
     ////////////////////////////////////////////////////////////////
     inline friend bool operator == (const WCoefLabels& coef1, const WCoefLabels& coef2)
     {
-      return coef1.Key() == coef2.Key();
+      return (coef1.x1_==coef2.x1_) && (coef1.L1_==coef2.L1_)
+        && (coef1.x2_==coef2.x2_) && (coef1.L2_==coef2.L2_)
+        && (coef1.x3_==coef2.x3_) && (coef1.L3_==coef2.L3_);
     }
 
     inline friend bool operator < (const WCoefLabels& coef1, const WCoefLabels& coef2)
@@ -378,9 +1039,19 @@ namespace u3
     }
 
     inline friend std::size_t hash_value(WCoefLabels const& wcoef_labels)
+    // Hash by combining packed keys of SU(3) labels, with each L
+    // folded in by a separate combination step.
+    //
+    // The SU(3) packed key fills all 64 bits, so L cannot simply be
+    // xored into it without colliding with the mu field.
     {
-      boost::hash<WCoefLabels::KeyType> hasher;
-      return hasher(wcoef_labels.Key());
+      std::size_t seed = PackedHash(wcoef_labels.x1_.PackedKey());
+      seed = PackedHashCombine(seed,uint64_t(wcoef_labels.L1_));
+      seed = PackedHashCombine(seed,wcoef_labels.x2_.PackedKey());
+      seed = PackedHashCombine(seed,uint64_t(wcoef_labels.L2_));
+      seed = PackedHashCombine(seed,wcoef_labels.x3_.PackedKey());
+      seed = PackedHashCombine(seed,uint64_t(wcoef_labels.L3_));
+      return seed;
     }
     ////////////////////////////////////////////////////////////////
     // string conversion
@@ -425,6 +1096,10 @@ namespace u3
 
     WCoefBlock(const u3::WCoefLabels& labels);
 
+    WCoefBlock(const KeyType& multiplicities, const double* coefs);
+    // Construct from given multiplicities and coefficient values
+    // (e.g., as retrieved from a CoefStore).
+
     ////////////////////////////////////////////////////////////////
     // accessors
     ////////////////////////////////////////////////////////////////
@@ -440,9 +1115,41 @@ namespace u3
 
     double GetCoef(int kappa1, int kappa2, int kappa3, int rho) const;
 
+    inline int Index(int kappa1, int kappa2, int kappa3, int rho) const
+    // Calculate position of coefficient in block (see data()).
+    {
+      int index = (rho-1);
+      index = index * kappa2_max_ + (kappa2-1);
+      index = index * kappa1_max_ + (kappa1-1);
+      index = index * kappa3_max_ + (kappa3-1);
+      return index;
+    }
+
     inline std::vector<double> GetCoefBlock() const
     {
-      return coefs_;
+      return std::vector<double>(coefs_.data(),coefs_.data()+coefs_.size());
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // contiguous view
+    ////////////////////////////////////////////////////////////////
+
+    inline const double* data() const
+    // Return pointer to coefficients, with kappa3 varying fastest,
+    // then kappa1, kappa2, and rho slowest (see Index).
+    {
+      return coefs_.data();
+    }
+
+    inline std::size_t size() const
+    {
+      return coefs_.size();
+    }
+
+    inline void MoveToArena(u3::CoefArena& arena)
+    // Move coefficient storage into cache arena (see CoefPayload).
+    {
+      coefs_.MoveToArena(arena);
     }
 
     ////////////////////////////////////////////////////////////////
@@ -461,7 +1168,7 @@ namespace u3
    
 
     // coefficient values
-    std::vector<double> coefs_;// May need to be changed...
+    u3::CoefPayload coefs_;
 
   };
 
@@ -469,10 +1176,7 @@ namespace u3
   // W coefficient caching
   ////////////////////////////////////////////////////////////////
 
-  typedef std::unordered_map<
-    u3::WCoefLabels,
-    u3::WCoefBlock,
-    boost::hash<u3::WCoefLabels> > WCoefCache;
+  typedef u3::CoefCache<u3::WCoefLabels,u3::WCoefBlock> WCoefCache;
 
   extern bool g_u_cache_enabled;
   double WCached(
@@ -534,7 +1238,7 @@ namespace u3
     ////////////////////////////////////////////////////////////////
     inline friend bool operator == (const PhiCoefLabels& coef1, const PhiCoefLabels& coef2)
     {
-      return coef1.Key() == coef2.Key();
+      return (coef1.x1_==coef2.x1_) && (coef1.x2_==coef2.x2_) && (coef1.x3_==coef2.x3_);
     }
 
     inline friend bool operator < (const PhiCoefLabels& coef1, const PhiCoefLabels& coef2)
@@ -543,9 +1247,12 @@ namespace u3
     }
 
     inline friend std::size_t hash_value(PhiCoefLabels const& coef_labels)
+    // Hash by combining packed keys of SU(3) labels.
     {
-      boost::hash<PhiCoefLabels::KeyType> hasher;
-      return hasher(coef_labels.Key());
+      std::size_t seed = PackedHash(coef_labels.x1_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x2_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x3_.PackedKey());
+      return seed;
     }
     ////////////////////////////////////////////////////////////////
     // string conversion
@@ -570,6 +1277,13 @@ namespace u3
   {
   public:
 
+    ////////////////////////////////////////////////////////////////
+    // type definitions
+    ////////////////////////////////////////////////////////////////
+
+    typedef std::tuple<int> KeyType;
+    // tuple of multiplicities (rho_max)
+
     ////////////////////////////////////////////////////////////////
     // constructors
     ////////////////////////////////////////////////////////////////
@@ -579,6 +1293,19 @@ namespace u3
     // Construct and store multiplicites and coefficient values
 
     PhiCoefBlock(const u3::PhiCoefLabels& labels);
+
+    PhiCoefBlock(const KeyType& multiplicities, const double* coefs);
+    // Construct from given multiplicities and coefficient values
+    // (e.g., as retrieved from a CoefStore).
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    inline KeyType Key() const
+    {
+      return KeyType(rho_max_);
+    }
  
     ////////////////////////////////////////////////////////////////
     // entry lookup
@@ -586,9 +1313,42 @@ namespace u3
 
     double GetCoef(int rho1, int rho2) const;
 
+    inline int Index(int rho1, int rho2) const
+    // Calculate position of coefficient in block (see data()).
+    {
+      return (rho2-1)*rho_max_ + (rho1-1);
+    }
+
     inline std::vector<double> GetCoefBlock() const
     {
-      return cache_;
+      return std::vector<double>(cache_.data(),cache_.data()+cache_.size());
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // contiguous view
+    ////////////////////////////////////////////////////////////////
+
+    inline int rho_max() const
+    {
+      return rho_max_;
+    }
+
+    inline const double* data() const
+    // Return pointer to coefficients, with rho1 varying fastest (see
+    // Index).
+    {
+      return cache_.data();
+    }
+
+    inline std::size_t size() const
+    {
+      return cache_.size();
+    }
+
+    inline void MoveToArena(u3::CoefArena& arena)
+    // Move coefficient storage into cache arena (see CoefPayload).
+    {
+      cache_.MoveToArena(arena);
     }
 
     ////////////////////////////////////////////////////////////////
@@ -606,14 +1366,10 @@ namespace u3
     int rho_max_;
    
     // coefficient values
-    std::vector<double> cache_;
+    u3::CoefPayload cache_;
   };
 
-  typedef std::unordered_map<
-    u3::PhiCoefLabels,
-    u3::PhiCoefBlock,
-    boost::hash<u3::PhiCoefLabels> 
-    > PhiCoefCache;
+  typedef u3::CoefCache<u3::PhiCoefLabels,u3::PhiCoefBlock> PhiCoefCache;
 
   double PhiCached(
                  PhiCoefCache& cache, 
@@ -634,7 +1390,455 @@ namespace u3
   // Returns;
   //   (double): single coefficient value
 
+  ////////////////////////////////////////////////////////////////
+  // W coefficient exchange symmetry
+  ////////////////////////////////////////////////////////////////
+
+  // Exchanging the coupled irreps of a reduced SU(3)>SO(3) Wigner
+  // coefficient gives
+  //
+  //   W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho)
+  //     = (-1)^(L1+L2-L3) sum_rho' Phi(x1,x2,x3,rho,rho')
+  //       * W(x2,kappa2,L2,x1,kappa1,L1,x3,kappa3,L3,rho')
+  //
+  // that is, the SO(3) exchange phase, the permutation of the kappa
+  // indices, and the SU(3) coupling-order matrix Phi acting on the
+  // outer multiplicity index (which reduces to a phase if rho_max=1).
+  //
+  // SymmetricWCoefCache stores only the W block for the canonical
+  // labels (the lesser of the labels and their exchange), together
+  // with the Phi blocks needed to recover the other orientation.  The
+  // Phi blocks depend only on the SU(3) labels, so they are far fewer
+  // than the W blocks they serve.  This roughly halves the W blocks
+  // stored and calculated, for label sets closed under exchange.
+  //
+  // SymmetricWCoefCache checks the exchange relation against the
+  // current backend when it is constructed, on a small grid including
+  // blocks with outer multiplicity (CheckWExchangeSymmetry), and
+  // aborts if the relation fails.  The full check over a larger grid
+  // is made by u3coef_symmetry_test.
+  //
+  // Only exchange is used, so the saving is at most a factor of two.
+  // Conjugation is not used, since the SO(3) branching multiplicity
+  // labels of conjugate irreps do not correspond one-to-one under a
+  // phase, and neither are the symmetries relating W to coefficients
+  // with x3 moved into a coupled position (as in TestWSymmetries13 of
+  // u3coef_test), which carry dimension factors and conjugate irreps.
+
+  bool CheckWExchangeSymmetry(int lm_max = 2, std::ostream* log = nullptr);
+  // Check exchange relation for W coefficient blocks, as calculated
+  // (with Phi) by the current backend.
+  //
+  // All allowed labels with x1 and x2 having lambda,mu<=lm_max are
+  // checked (lm_max>=1 is needed to include blocks with outer
+  // multiplicity).  Each exchanged pair is checked from both
+  // orientations, including the non-canonical orientation, from which
+  // SymmetricWCoefCache applies the relation.
+  //
+  // Arguments:
+  //   lm_max (int, optional): maximum lambda and mu of x1, x2
+  //   log (std::ostream*, optional): stream for listing mismatched
+  //     labels and summary
+  //
+  // Returns:
+  //   (bool): whether all blocks satisfy the relation
+
+  inline u3::WCoefLabels CanonicalWCoefLabels(const u3::WCoefLabels& labels, bool& exchanged)
+  // Return canonical labels for W coefficient block, under exchange.
+  //
+  // Arguments:
+  //   labels (u3::WCoefLabels): labels
+  //   exchanged (bool, output): whether canonical labels are the
+  //     exchange of the given labels
+  //
+  // Returns:
+  //   (u3::WCoefLabels): canonical labels
+  {
+    u3::WCoefLabels exchanged_labels = labels.Exchange();
+    exchanged = (exchanged_labels<labels);
+    return exchanged ? exchanged_labels : labels;
+  }
+
+  class SymmetricWCoefCache
+  // Cache of W coefficient blocks, stored for canonical labels under
+  // exchange of coupled irreps.
+  //
+  // Not thread-safe.
+  //
+  // EX:
+  //   u3::SymmetricWCoefCache cache;
+  //   double coef = u3::WCached(cache,x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    explicit SymmetricWCoefCache(bool validate = true);
+    // Construct empty cache.
+    //
+    // Unless validate is false, first checks the exchange relation
+    // against the current backend, with CheckWExchangeSymmetry for
+    // lm_max=kValidationLmMax, and aborts if it fails.  This takes a
+    // few hundred block calculations, which may be skipped (with
+    // validate=false) for further caches once the backend has been
+    // checked.
+
+    static constexpr int kValidationLmMax = 1;
+
+    ////////////////////////////////////////////////////////////////
+    // retrieval
+    ////////////////////////////////////////////////////////////////
+
+    double GetCoef(const u3::WCoefLabels& labels, int kappa1, int kappa2, int kappa3, int rho);
+    // Retrieve coefficient, constructing blocks as needed.
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    std::size_t size() const
+    // Return number of W blocks.
+    {
+      return w_cache_.size();
+    }
+
+    const u3::WCoefCache& w_cache() const
+    {
+      return w_cache_;
+    }
+
+    const u3::PhiCoefCache& phi_cache() const
+    {
+      return phi_cache_;
+    }
+
+    u3::CoefCacheStats Stats() const
+    // Return snapshot of W cache statistics.
+    {
+      return w_cache_.Stats();
+    }
+
+    void clear()
+    {
+      w_cache_.clear();
+      phi_cache_.clear();
+    }
+
+  private:
+    // W blocks, for canonical labels
+    u3::WCoefCache w_cache_;
+
+    // Phi blocks, for exchanged lookups
+    u3::PhiCoefCache phi_cache_;
+  };
+
+  double WCached(
+                 SymmetricWCoefCache& cache, 
+                 const u3::SU3& x1, int kappa1, int L1, const u3::SU3& x2, int kappa2, int L2, 
+                 const u3::SU3& x3, int kappa3, int L3, int rho
+                 );
+  // Cached SU(3) Wigner coupling coefficient, with exchange-symmetric
+  // storage.  See WCached above.
+
+  ////////////////////////////////////////////////////////////////
+  // 9-(lambda,mu) symbol caching
+  ////////////////////////////////////////////////////////////////
+
+  class NineLMCoefLabels
+  // Class to gather and provide hashing for unitary 9-(lambda,mu)
+  // symbol labels
+  //
+  // Labels are ordered as the array
+  //
+  //   x1  x2  x12
+  //   x3  x4  x34
+  //   x13 x24 x
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // type definitions
+    ////////////////////////////////////////////////////////////////
+
+    typedef std::tuple<u3::SU3,u3::SU3,u3::SU3,u3::SU3,u3::SU3,u3::SU3,u3::SU3,u3::SU3,u3::SU3> KeyType;
+    // tuple of SU(3) labels
+
+    ////////////////////////////////////////////////////////////////
+    // constructors
+    ////////////////////////////////////////////////////////////////
+
+    inline NineLMCoefLabels(
+        const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+        const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+        const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x
+      )
+      : x1_(x1), x2_(x2), x12_(x12), x3_(x3), x4_(x4), x34_(x34),
+        x13_(x13), x24_(x24), x_(x) {}
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+ 
+    inline KeyType Key() const
+    {
+      return KeyType(x1_,x2_,x12_,x3_,x4_,x34_,x13_,x24_,x_);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // validation
+    ////////////////////////////////////////////////////////////////
+    
+    inline bool Allowed() const
+    // Checks if labels satisfy coupling constraints.
+    {
+      return (u3::OuterMultiplicity(x1_,x2_,x12_)>0)
+        && (u3::OuterMultiplicity(x3_,x4_,x34_)>0)
+        && (u3::OuterMultiplicity(x12_,x34_,x_)>0)
+        && (u3::OuterMultiplicity(x1_,x3_,x13_)>0)
+        && (u3::OuterMultiplicity(x2_,x4_,x24_)>0)
+        && (u3::OuterMultiplicity(x13_,x24_,x_)>0);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // hashing
+    ////////////////////////////////////////////////////////////////
+    inline friend bool operator == (const NineLMCoefLabels& coef1, const NineLMCoefLabels& coef2)
+    {
+      return (coef1.x1_==coef2.x1_) && (coef1.x2_==coef2.x2_) && (coef1.x12_==coef2.x12_)
+        && (coef1.x3_==coef2.x3_) && (coef1.x4_==coef2.x4_) && (coef1.x34_==coef2.x34_)
+        && (coef1.x13_==coef2.x13_) && (coef1.x24_==coef2.x24_) && (coef1.x_==coef2.x_);
+    }
 
+    inline friend bool operator < (const NineLMCoefLabels& coef1, const NineLMCoefLabels& coef2)
+    {
+      return coef1.Key() < coef2.Key();
+    }
+
+    inline friend std::size_t hash_value(NineLMCoefLabels const& coef_labels)
+    // Hash by combining packed keys of SU(3) labels.
+    {
+      std::size_t seed = PackedHash(coef_labels.x1_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x2_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x12_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x3_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x4_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x34_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x13_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x24_.PackedKey());
+      seed = PackedHashCombine(seed,coef_labels.x_.PackedKey());
+      return seed;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // string conversion
+    ////////////////////////////////////////////////////////////////
+  
+    std::string Str() const;
+
+    ////////////////////////////////////////////////////////////////
+    // labels
+    ////////////////////////////////////////////////////////////////
+
+  private:
+    u3::SU3 x1_, x2_, x12_, x3_, x4_, x34_, x13_, x24_, x_;
+  };
+
+
+  class NineLMCoefBlock
+  // Class to store and retrieve block of unitary 9-(lambda,mu)
+  // symbols sharing same SU(3) labels but with different multiplicity
+  // indices
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // type definitions
+    ////////////////////////////////////////////////////////////////
+
+    typedef u3::NineLMMultiplicityTuple KeyType;
+    // tuple of multiplicities (r12_max,r34_max,r12_34_max,r13_max,r24_max,r13_24_max)
+
+    ////////////////////////////////////////////////////////////////
+    // constructors
+    ////////////////////////////////////////////////////////////////
+
+    inline NineLMCoefBlock()
+      : multiplicities_(0,0,0,0,0,0) {}
+    // Construct and store multiplicites and coefficient values
+
+    NineLMCoefBlock(const u3::NineLMCoefLabels& labels);
+
+    NineLMCoefBlock(const KeyType& multiplicities, const double* coefs);
+    // Construct from given multiplicities and coefficient values
+    // (e.g., as retrieved from a CoefStore).
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    inline const KeyType& Key() const
+    {
+      return multiplicities_;
+    }
+ 
+    ////////////////////////////////////////////////////////////////
+    // entry lookup
+    ////////////////////////////////////////////////////////////////
+
+    double GetCoef(int r12, int r34, int r12_34, int r13, int r24, int r13_24) const;
+
+    inline int Index(int r12, int r34, int r12_34, int r13, int r24, int r13_24) const
+    // Calculate position of coefficient in block (see data()).
+    {
+      return Unitary9LambdaMuBlockIndex(multiplicities_,r12,r34,r12_34,r13,r24,r13_24);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // contiguous view
+    ////////////////////////////////////////////////////////////////
+
+    inline const double* data() const
+    // Return pointer to coefficients, in su3lib order, with r12
+    // varying fastest and r13_24 slowest (see Index).
+    {
+      return coefs_.data();
+    }
+
+    inline std::size_t size() const
+    {
+      return coefs_.size();
+    }
+
+    inline void MoveToArena(u3::CoefArena& arena)
+    // Move coefficient storage into cache arena (see CoefPayload).
+    {
+      coefs_.MoveToArena(arena);
+    }
+
+  private:
+    // multiplicities
+    KeyType multiplicities_;
+
+    // coefficient values
+    u3::CoefPayload coefs_;
+  };
+
+  typedef u3::CoefCache<u3::NineLMCoefLabels,u3::NineLMCoefBlock> NineLMCoefCache;
+
+  extern bool g_nine_lm_cache_enabled;
+  double Unitary9LambdaMuCached(
+      NineLMCoefCache& cache,
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+      int r13,     int r24,     int r12_34
+    );
+  // Cached SU(3) unitary 9-(lambda,mu) symbol.
+  //
+  // Arguments are in the same order as for Unitary9LambdaMu.
+  //
+  // Global:
+  //
+  //   u3::g_nine_lm_cache_enabled (bool): mode flag determining
+  //     whether to use caching or calculate on the fly (for debugging
+  //     and profiling)
+  //
+  // Arguments:
+  //   cache (NineLMCoefCache): cache to use for 9-(lambda,mu) symbols
+  //   x1, ...: standard 9-(lambda,mu) SU(3) and multiplicity labels
+  //
+  // Returns;
+  //   (double): single coefficient value
+
+  ////////////////////////////////////////////////////////////////
+  // concurrent caching
+  ////////////////////////////////////////////////////////////////
+
+  // Thread-safe counterparts to UCoefCache, ZCoefCache, WCoefCache,
+  // PhiCoefCache, and NineLMCoefCache, which may be shared among
+  // OpenMP threads.  See ConcurrentCoefCache.
+  //
+  // Hits are lock-free, but misses are computed by su3lib under the
+  // global serialization lock (see "su3lib thread safety" above), so
+  // only one miss is computed at a time across all threads.  Prefill
+  // with PrefillCache when many misses are expected.
+
+  typedef u3::ConcurrentCoefCache<u3::UCoefLabels,u3::UCoefBlock> ConcurrentUCoefCache;
+  typedef u3::ConcurrentCoefCache<u3::ZCoefLabels,u3::ZCoefBlock> ConcurrentZCoefCache;
+  typedef u3::ConcurrentCoefCache<u3::WCoefLabels,u3::WCoefBlock> ConcurrentWCoefCache;
+  typedef u3::ConcurrentCoefCache<u3::PhiCoefLabels,u3::PhiCoefBlock> ConcurrentPhiCoefCache;
+  typedef u3::ConcurrentCoefCache<u3::NineLMCoefLabels,u3::NineLMCoefBlock> ConcurrentNineLMCoefCache;
+
+  double UCached(
+                 ConcurrentUCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 );
+  double ZCached(
+                 ConcurrentZCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 );
+  double WCached(
+                 ConcurrentWCoefCache& cache, 
+                 const u3::SU3& x1, int kappa1, int L1, const u3::SU3& x2, int kappa2, int L2, 
+                 const u3::SU3& x3, int kappa3, int L3, int rho
+                 );
+  double PhiCached(
+                 ConcurrentPhiCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, 
+                 const u3::SU3& x3, int rho1, int rho2);
+  double Unitary9LambdaMuCached(
+      ConcurrentNineLMCoefCache& cache,
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+      int r13,     int r24,     int r12_34
+    );
+  // Overloaded for concurrent caches.  Thread-safe.
+
+  ////////////////////////////////////////////////////////////////
+  // memory-bounded caching
+  ////////////////////////////////////////////////////////////////
+
+  // Counterparts to UCoefCache, etc., with a byte budget, beyond
+  // which blocks are evicted.  See BoundedCoefCache.
+
+  typedef u3::BoundedCoefCache<u3::UCoefLabels,u3::UCoefBlock> BoundedUCoefCache;
+  typedef u3::BoundedCoefCache<u3::ZCoefLabels,u3::ZCoefBlock> BoundedZCoefCache;
+  typedef u3::BoundedCoefCache<u3::WCoefLabels,u3::WCoefBlock> BoundedWCoefCache;
+  typedef u3::BoundedCoefCache<u3::PhiCoefLabels,u3::PhiCoefBlock> BoundedPhiCoefCache;
+  typedef u3::BoundedCoefCache<u3::NineLMCoefLabels,u3::NineLMCoefBlock> BoundedNineLMCoefCache;
+
+  double UCached(
+                 BoundedUCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 );
+  double ZCached(
+                 BoundedZCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3, const u3::SU3& x12,
+                 int r12, int r12_3, const u3::SU3& x23, int r23, int r1_23
+                 );
+  double WCached(
+                 BoundedWCoefCache& cache, 
+                 const u3::SU3& x1, int kappa1, int L1, const u3::SU3& x2, int kappa2, int L2, 
+                 const u3::SU3& x3, int kappa3, int L3, int rho
+                 );
+  double PhiCached(
+                 BoundedPhiCoefCache& cache, 
+                 const u3::SU3& x1, const u3::SU3& x2, 
+                 const u3::SU3& x3, int rho1, int rho2);
+  double Unitary9LambdaMuCached(
+      BoundedNineLMCoefCache& cache,
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12, int r12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34, int r34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,   int r13_24,
+      int r13,     int r24,     int r12_34
+    );
+  // Overloaded for memory-bounded caches.
 
 } //namespace 
 
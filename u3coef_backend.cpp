@@ -0,0 +1,391 @@
+/****************************************************************
+  u3coef_backend.cpp
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+****************************************************************/
+
+#include "sp3rlib/u3coef_backend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "fmt/format.h"
+#include "sp3rlib/u3coef_native.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // backend selection
+  ////////////////////////////////////////////////////////////////
+
+  // The selected backend is held by g_coef_backend_holder, and
+  // accessed on the dispatch path through the plain pointer
+  // g_coef_backend (nullptr for the default su3lib backend).
+  static std::shared_ptr<CoefBackend> g_coef_backend_holder;
+  static std::atomic<CoefBackend*> g_coef_backend(nullptr);
+
+  static CoefBackend& DefaultCoefBackend()
+  {
+    static Su3libCoefBackend backend;
+    return backend;
+  }
+
+  CoefBackend& CurrentCoefBackend()
+  {
+    CoefBackend* backend = g_coef_backend.load(std::memory_order_acquire);
+    return backend ? *backend : DefaultCoefBackend();
+  }
+
+  std::shared_ptr<CoefBackend> GetCoefBackend()
+  {
+    return g_coef_backend_holder;
+  }
+
+  void SetCoefBackend(std::shared_ptr<CoefBackend> backend)
+  {
+    g_coef_backend.store(backend.get(),std::memory_order_release);
+    g_coef_backend_holder = std::move(backend);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // su3lib backend
+  ////////////////////////////////////////////////////////////////
+
+  void Su3libCoefBackend::Report(std::ostream& os) const
+  {
+    u3::Su3libReport(os);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // native backend
+  ////////////////////////////////////////////////////////////////
+
+  u3::UMultiplicityTuple NativeUZCoefBackend::UZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      u3::UZMode mode,
+      std::vector<double>& block
+    )
+  {
+    return u3::native::UZBlock(x1,x2,x,x3,x12,x23,mode,block,u3::native::WSource::kSu3lib);
+  }
+
+  void NativeUZCoefBackend::Report(std::ostream& os) const
+  {
+    u3::Su3libReport(os);
+    u3::native::CacheReport(os);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // store backend
+  ////////////////////////////////////////////////////////////////
+
+  StoreCoefBackend::StoreCoefBackend(std::shared_ptr<CoefBackend> fallback)
+    : fallback_(fallback ? fallback : std::make_shared<Su3libCoefBackend>()),
+      hits_(0), misses_(0)
+  {}
+
+  bool StoreCoefBackend::Open(u3::CoefStoreKind kind, const std::string& filename)
+  {
+    switch (kind)
+      {
+      case CoefStoreKind::kU:
+        return u_store_.Open(filename);
+      case CoefStoreKind::kZ:
+        return z_store_.Open(filename);
+      case CoefStoreKind::kW:
+        return w_store_.Open(filename);
+      case CoefStoreKind::kPhi:
+        return phi_store_.Open(filename);
+      case CoefStoreKind::kNineLM:
+        return nine_lm_store_.Open(filename);
+      }
+    return false;
+  }
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I==sizeof...(tElements)),std::size_t>::type
+    MultiplicityProduct(const std::tuple<tElements...>&)
+  {
+    return 1;
+  }
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I<sizeof...(tElements)),std::size_t>::type
+    MultiplicityProduct(const std::tuple<tElements...>& multiplicities)
+  // Return block size, as product of multiplicities.
+  {
+    return std::get<I>(multiplicities)*MultiplicityProduct<I+1>(multiplicities);
+  }
+
+  template <typename tStore, typename tLabels>
+    bool StoreCoefBackend::Find(
+        const tStore& store, const tLabels& labels,
+        typename tStore::MultiplicityType& multiplicities, std::vector<double>& block
+      )
+  {
+    const double* coefs = store.Find(labels,multiplicities);
+    if (!coefs)
+      return false;
+    hits_.fetch_add(1,std::memory_order_relaxed);
+    block.assign(coefs,coefs+MultiplicityProduct(multiplicities));
+    return true;
+  }
+
+  u3::WMultiplicityTuple StoreCoefBackend::WBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    )
+  {
+    u3::WMultiplicityTuple multiplicities;
+    if (Find(w_store_,u3::WCoefLabels(x1,L1,x2,L2,x3,L3),multiplicities,block))
+      return multiplicities;
+    misses_.fetch_add(1,std::memory_order_relaxed);
+    return fallback_->WBlock(x1,L1,x2,L2,x3,L3,block);
+  }
+
+  u3::UMultiplicityTuple StoreCoefBackend::UZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      u3::UZMode mode,
+      std::vector<double>& block
+    )
+  {
+    u3::UMultiplicityTuple multiplicities;
+    const u3::UCoefLabels labels(x1,x2,x,x3,x12,x23);
+    if (mode==UZMode::kU)
+      {
+        if (Find(u_store_,labels,multiplicities,block))
+          return multiplicities;
+      }
+    else
+      {
+        // Phi(x1,x3,x) is Z(x1,(0,0),x,x3;x1,1,rho;x3,1,rho')
+        if ((x2==u3::SU3(0,0)) && (x12==x1) && (x23==x3))
+          {
+            std::tuple<int> phi_multiplicities;
+            if (Find(phi_store_,u3::PhiCoefLabels(x1,x3,x),phi_multiplicities,block))
+              {
+                int rho_max = std::get<0>(phi_multiplicities);
+                return u3::UMultiplicityTuple(1,rho_max,1,rho_max);
+              }
+          }
+        if (Find(z_store_,labels,multiplicities,block))
+          return multiplicities;
+      }
+    misses_.fetch_add(1,std::memory_order_relaxed);
+    return fallback_->UZBlock(x1,x2,x,x3,x12,x23,mode,block);
+  }
+
+  u3::NineLMMultiplicityTuple StoreCoefBackend::Unitary9LambdaMuBlock(
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+      std::vector<double>& block
+    )
+  {
+    u3::NineLMMultiplicityTuple multiplicities;
+    if (Find(nine_lm_store_,u3::NineLMCoefLabels(x1,x2,x12,x3,x4,x34,x13,x24,x),multiplicities,block))
+      return multiplicities;
+    misses_.fetch_add(1,std::memory_order_relaxed);
+    return fallback_->Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,block);
+  }
+
+  void StoreCoefBackend::Report(std::ostream& os) const
+  {
+    os << fmt::format(
+        "backend store stored u {} z {} w {} phi {} nine_lm {}",
+        u_store_.num_stored(),z_store_.num_stored(),w_store_.num_stored(),
+        phi_store_.num_stored(),nine_lm_store_.num_stored()
+      )
+       << std::endl;
+    os << fmt::format("backend store hits {} misses {} fallback {}",hits(),misses(),fallback_->Name())
+       << std::endl;
+    fallback_->Report(os);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // shadow backend
+  ////////////////////////////////////////////////////////////////
+
+  ShadowCoefBackend::ShadowCoefBackend(
+      std::shared_ptr<CoefBackend> primary,
+      std::shared_ptr<CoefBackend> shadow,
+      double fraction,
+      u3::ShadowComparison comparison,
+      double tolerance,
+      std::size_t max_records
+    )
+    : primary_(primary), shadow_(shadow),
+      fraction_(std::min(std::max(fraction,0.),1.)),
+      comparison_(comparison), tolerance_(tolerance), max_records_(max_records),
+      calls_(0), samples_(0), num_discrepancies_(0), max_deviation_(0.)
+  {
+    if (!(primary_&&shadow_))
+      {
+        std::cerr << "ERROR: ShadowCoefBackend requires primary and shadow backends" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+  }
+
+  std::string ShadowCoefBackend::Name() const
+  {
+    return fmt::format("shadow({},{})",primary_->Name(),shadow_->Name());
+  }
+
+  bool ShadowCoefBackend::Sample()
+  {
+    // sample call n if floor((n+1)*fraction) exceeds floor(n*fraction),
+    // i.e., at evenly spaced calls
+    long n = calls_.fetch_add(1,std::memory_order_relaxed);
+    return std::floor((n+1)*fraction_)>std::floor(n*fraction_);
+  }
+
+  double ShadowCoefBackend::Deviation(
+      bool same_shape,
+      const std::vector<double>& block,
+      const std::vector<double>& shadow_block
+    ) const
+  {
+    if (!same_shape || (block.size()!=shadow_block.size()))
+      return HUGE_VAL;
+    double deviation = 0.;
+    if (comparison_==ShadowComparison::kCoefficients)
+      {
+        for (std::size_t i=0; i<block.size(); ++i)
+          deviation = std::max(deviation,std::abs(block[i]-shadow_block[i]));
+      }
+    else
+      {
+        double norm_squared = 0., shadow_norm_squared = 0.;
+        for (std::size_t i=0; i<block.size(); ++i)
+          {
+            norm_squared += block[i]*block[i];
+            shadow_norm_squared += shadow_block[i]*shadow_block[i];
+          }
+        deviation = std::abs(std::sqrt(norm_squared)-std::sqrt(shadow_norm_squared));
+      }
+    return deviation;
+  }
+
+  bool ShadowCoefBackend::Check(double deviation)
+  {
+    samples_.fetch_add(1,std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      max_deviation_ = std::max(max_deviation_,deviation);
+    }
+    if (!(deviation>tolerance_))
+      return false;
+    num_discrepancies_.fetch_add(1,std::memory_order_relaxed);
+    return true;
+  }
+
+  void ShadowCoefBackend::Record(const std::string& labels, double deviation)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (discrepancies_.size()<max_records_)
+      discrepancies_.push_back(CoefDiscrepancy{labels,deviation});
+  }
+
+  u3::WMultiplicityTuple ShadowCoefBackend::WBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    )
+  {
+    u3::WMultiplicityTuple multiplicities = primary_->WBlock(x1,L1,x2,L2,x3,L3,block);
+    if (!Sample())
+      return multiplicities;
+
+    std::vector<double> shadow_block;
+    u3::WMultiplicityTuple shadow_multiplicities = shadow_->WBlock(x1,L1,x2,L2,x3,L3,shadow_block);
+    double deviation = Deviation(shadow_multiplicities==multiplicities,block,shadow_block);
+    if (Check(deviation))
+      Record("W"+u3::WCoefLabels(x1,L1,x2,L2,x3,L3).Str(),deviation);
+    return multiplicities;
+  }
+
+  u3::UMultiplicityTuple ShadowCoefBackend::UZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      u3::UZMode mode,
+      std::vector<double>& block
+    )
+  {
+    u3::UMultiplicityTuple multiplicities = primary_->UZBlock(x1,x2,x,x3,x12,x23,mode,block);
+    if (!Sample())
+      return multiplicities;
+
+    std::vector<double> shadow_block;
+    u3::UMultiplicityTuple shadow_multiplicities = shadow_->UZBlock(x1,x2,x,x3,x12,x23,mode,shadow_block);
+    double deviation = Deviation(shadow_multiplicities==multiplicities,block,shadow_block);
+    if (Check(deviation))
+      Record(((mode==UZMode::kU) ? "U" : "Z")+u3::UCoefLabels(x1,x2,x,x3,x12,x23).Str(),deviation);
+    return multiplicities;
+  }
+
+  u3::NineLMMultiplicityTuple ShadowCoefBackend::Unitary9LambdaMuBlock(
+      const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+      const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+      const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+      std::vector<double>& block
+    )
+  {
+    u3::NineLMMultiplicityTuple multiplicities
+      = primary_->Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,block);
+    if (!Sample())
+      return multiplicities;
+
+    std::vector<double> shadow_block;
+    u3::NineLMMultiplicityTuple shadow_multiplicities
+      = shadow_->Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,shadow_block);
+    double deviation = Deviation(shadow_multiplicities==multiplicities,block,shadow_block);
+    if (Check(deviation))
+      Record("NineLM"+u3::NineLMCoefLabels(x1,x2,x12,x3,x4,x34,x13,x24,x).Str(),deviation);
+    return multiplicities;
+  }
+
+  double ShadowCoefBackend::max_deviation() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_deviation_;
+  }
+
+  std::vector<CoefDiscrepancy> ShadowCoefBackend::discrepancies() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return discrepancies_;
+  }
+
+  void ShadowCoefBackend::ClearDiscrepancies()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    calls_.store(0,std::memory_order_relaxed);
+    samples_.store(0,std::memory_order_relaxed);
+    num_discrepancies_.store(0,std::memory_order_relaxed);
+    max_deviation_ = 0.;
+    discrepancies_.clear();
+  }
+
+  void ShadowCoefBackend::Report(std::ostream& os) const
+  {
+    os << fmt::format(
+        "backend shadow calls {} samples {} discrepancies {} max_deviation {:.3e} ({} {} {:.1e})",
+        num_calls(),num_samples(),num_discrepancies(),max_deviation(),
+        primary_->Name(),shadow_->Name(),tolerance_
+      )
+       << std::endl;
+    for (const CoefDiscrepancy& discrepancy : discrepancies())
+      os << fmt::format("backend shadow discrepancy {} {:.3e}",discrepancy.labels,discrepancy.deviation)
+         << std::endl;
+    primary_->Report(os);
+    shadow_->Report(os);
+  }
+
+}  // namespace
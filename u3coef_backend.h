@@ -0,0 +1,505 @@
+/****************************************************************
+  u3coef_backend.h
+
+  Pluggable backends for evaluation of SU(3) coupling coefficient
+  blocks.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Add NativeUZCoefBackend.
+  10/16/26 (mac): Abort on 9-(lambda,mu) symbols in NativeCoefBackend.
+  10/16/26 (mac): Describe NativeUZCoefBackend as sum over su3lib W.
+  10/16/26 (mac): Remove NativeCoefBackend, pending agreement of native W with
+    su3lib.
+
+****************************************************************/
+
+#ifndef U3COEF_BACKEND_H_
+#define U3COEF_BACKEND_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sp3rlib/u3coef.h"
+#include "sp3rlib/u3coef_store.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // backend interface
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  class CoefBackend
+  // Source of SU(3) coefficient blocks.
+  //
+  // The block functions u3::WBlock, u3::UZBlock, and
+  // u3::Unitary9LambdaMuBlock dispatch to the current backend (see
+  // SetCoefBackend), and so all coefficient evaluation (W, U, Z, Phi,
+  // Unitary9LambdaMu, and the coefficient caches) goes through it.
+  // Phi is evaluated as a Z block with x2=(0,0) (see PhiCoefBlock).
+  //
+  // Each function has the same interface and block layout as the
+  // corresponding u3 block function.  Implementations must be
+  // thread-safe, since the concurrent caches call them from multiple
+  // threads.
+  {
+  public:
+
+    virtual ~CoefBackend() {}
+
+    virtual std::string Name() const = 0;
+    // Return short name of backend, for reports.
+
+    virtual u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      ) = 0;
+
+    virtual u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block
+      ) = 0;
+
+    virtual u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+        const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+        const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+        const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+        std::vector<double>& block
+      ) = 0;
+
+    virtual void Report(std::ostream&) const {}
+    // Write statistics for backend, as lines of "backend name
+    // keyword value ...".
+  };
+
+  ////////////////////////////////////////////////////////////////
+  // backend selection
+  ////////////////////////////////////////////////////////////////
+
+  CoefBackend& CurrentCoefBackend();
+  // Return backend to which block functions currently dispatch.
+
+  std::shared_ptr<u3::CoefBackend> GetCoefBackend();
+  // Return current backend, or nullptr if the default (su3lib)
+  // backend is in use.
+
+  void SetCoefBackend(std::shared_ptr<u3::CoefBackend> backend);
+  // Select backend for block functions.
+  //
+  // A nullptr restores the default (su3lib) backend.  The backend
+  // is retained until replaced.
+  //
+  // Not thread-safe: The backend must not be changed while
+  // coefficients are being evaluated, nor while caches hold blocks
+  // from another backend (see "coefficient backend selection" in
+  // u3coef.h).
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // su3lib backend
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  class Su3libCoefBackend
+    : public CoefBackend
+  // Backend evaluating all blocks with su3lib (the default).
+  //
+  // Calls are serialized as described under "su3lib thread safety"
+  // in u3coef.h.
+  {
+  public:
+
+    std::string Name() const override
+    {
+      return "su3lib";
+    }
+
+    u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      ) override
+    {
+      return u3::Su3libWBlock(x1,L1,x2,L2,x3,L3,block);
+    }
+
+    u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block
+      ) override
+    {
+      return u3::Su3libUZBlock(x1,x2,x,x3,x12,x23,mode,block);
+    }
+
+    u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+        const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+        const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+        const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+        std::vector<double>& block
+      ) override
+    {
+      return u3::Su3libUnitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,block);
+    }
+
+    void Report(std::ostream& os) const override;
+    // Write su3lib call counts and times (see u3::Su3libReport).
+  };
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // native backend
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  class NativeUZCoefBackend
+    : public CoefBackend
+  // Backend evaluating U, Z, and Phi blocks by the sum over su3lib W
+  // coefficients (see u3::native::UZBlock with WSource::kSu3lib), and
+  // W and 9-(lambda,mu) blocks with su3lib.
+  //
+  // All coefficients are thus in su3lib conventions, so this backend
+  // may be used in place of the su3lib backend, once validated
+  // against it by a ShadowCoefBackend with
+  // ShadowComparison::kCoefficients (see the example there).  This is
+  // the migration path from su3lib to the native engine.  (A backend
+  // taking W from the native engine as well is used only in
+  // u3coef_native_test, until the native W coefficients have been
+  // confirmed against su3lib.)  However, since every
+  // W coefficient entering the sum comes from a su3lib call, U and Z
+  // are serialized on su3lib just as with the su3lib backend, and are
+  // in general slower than the su3lib U and Z (see u3coef_native.h).
+  {
+  public:
+
+    std::string Name() const override
+    {
+      return "native-uz";
+    }
+
+    u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      ) override
+    {
+      return u3::Su3libWBlock(x1,L1,x2,L2,x3,L3,block);
+    }
+
+    u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block
+      ) override;
+
+    u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+        const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+        const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+        const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+        std::vector<double>& block
+      ) override
+    {
+      return u3::Su3libUnitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,block);
+    }
+
+    void Report(std::ostream& os) const override;
+    // Write su3lib call counts and times, and native memo table
+    // statistics.
+  };
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // store backend
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  class StoreCoefBackend
+    : public CoefBackend
+  // Backend serving blocks from precomputed coefficient store files
+  // (see u3coef_store.h), with fallback to another backend.
+  //
+  // A store file may be opened for each kind of coefficient (U, Z,
+  // W, Phi, 9-lm).  Blocks found in a store are copied from the
+  // mapped file.  Other blocks are obtained from the fallback backend
+  // (su3lib by default), and are not added to the store.  Phi blocks
+  // (Z blocks with x2=(0,0), x12=x1, and x23=x3) are looked up first
+  // in the Phi store and then in the Z store.
+  //
+  // Lookup is thread-safe, since the mappings are read-only, but
+  // Open is not.
+  //
+  // EX:
+  //   auto backend = std::make_shared<u3::StoreCoefBackend>();
+  //   backend->Open(u3::CoefStoreKind::kU,"u_coefs.bin");
+  //   backend->Open(u3::CoefStoreKind::kW,"w_coefs.bin");
+  //   u3::SetCoefBackend(backend);
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    explicit StoreCoefBackend(std::shared_ptr<u3::CoefBackend> fallback = nullptr);
+    // Construct backend with no stores open.
+    //
+    // Arguments:
+    //   fallback (std::shared_ptr<u3::CoefBackend>, optional): backend
+    //     for blocks not in stores (default su3lib)
+
+    bool Open(u3::CoefStoreKind kind, const std::string& filename);
+    // Map store file for given kind of coefficient.
+    //
+    // Returns false if the file does not exist (see CoefStore::Open).
+
+    ////////////////////////////////////////////////////////////////
+    // backend interface
+    ////////////////////////////////////////////////////////////////
+
+    std::string Name() const override
+    {
+      return "store";
+    }
+
+    u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      ) override;
+
+    u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block
+      ) override;
+
+    u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+        const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+        const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+        const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+        std::vector<double>& block
+      ) override;
+
+    void Report(std::ostream& os) const override;
+    // Write number of blocks served from each store and from the
+    // fallback, followed by the fallback's own report.
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    long hits() const
+    // Return number of blocks served from stores.
+    {
+      return hits_.load(std::memory_order_relaxed);
+    }
+
+    long misses() const
+    // Return number of blocks obtained from fallback.
+    {
+      return misses_.load(std::memory_order_relaxed);
+    }
+
+  private:
+
+    template <typename tStore, typename tLabels>
+      bool Find(
+          const tStore& store, const tLabels& labels,
+          typename tStore::MultiplicityType& multiplicities, std::vector<double>& block
+        );
+    // Copy block from store, if present, and tally hit.
+
+    std::shared_ptr<u3::CoefBackend> fallback_;
+    u3::UCoefStore u_store_;
+    u3::ZCoefStore z_store_;
+    u3::WCoefStore w_store_;
+    u3::PhiCoefStore phi_store_;
+    u3::NineLMCoefStore nine_lm_store_;
+    std::atomic<long> hits_, misses_;
+  };
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // shadow backend
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  enum class ShadowComparison {kCoefficients, kNorms};
+  // Criterion for agreement of primary and shadow blocks:
+  //
+  //   kCoefficients: all coefficients agree (requires backends with
+  //     the same phase and multiplicity conventions)
+  //
+  //   kNorms: block Frobenius norms agree (independent of
+  //     conventions)
+  //
+  // Only kCoefficients validates a backend as a replacement for
+  // another.  Since block norms are invariant under changes of phase
+  // and multiplicity conventions, kNorms cannot detect errors in
+  // these, and so only screens for gross errors.
+
+  struct CoefDiscrepancy
+  // Record of block for which shadow backend disagreed with primary.
+  {
+    std::string labels;  // e.g., "W[...]"
+    double deviation;  // maximum deviation (HUGE_VAL if block shapes differ)
+  };
+
+  class ShadowCoefBackend
+    : public CoefBackend
+  // Backend which returns blocks from a primary backend, while
+  // evaluating a sample of them on a second (shadow) backend as
+  // well, and recording any discrepancies.
+  //
+  // This permits a new backend to be validated on production
+  // calculations, either as shadow (to check it against the trusted
+  // backend before switching) or as primary (with the trusted backend
+  // as shadow, to spot-check it after switching).
+  //
+  // Calls are sampled deterministically, as the fraction of calls
+  // given (e.g., every hundredth call for a fraction of 0.01).
+  // Sampled calls incur the cost of both backends.
+  //
+  // Thread-safe, if both backends are.
+  //
+  // EX:
+  //   auto shadow = std::make_shared<u3::ShadowCoefBackend>(
+  //       std::make_shared<u3::Su3libCoefBackend>(),
+  //       std::make_shared<u3::NativeUZCoefBackend>(),
+  //       0.01,u3::ShadowComparison::kCoefficients
+  //     );
+  //   u3::SetCoefBackend(shadow);
+  //   ...
+  //   shadow->Report(std::cout);
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    ShadowCoefBackend(
+        std::shared_ptr<u3::CoefBackend> primary,
+        std::shared_ptr<u3::CoefBackend> shadow,
+        double fraction,
+        u3::ShadowComparison comparison = u3::ShadowComparison::kCoefficients,
+        double tolerance = 1e-8,
+        std::size_t max_records = 100
+      );
+    // Arguments:
+    //   primary (std::shared_ptr<u3::CoefBackend>): backend for
+    //     returned blocks
+    //   shadow (std::shared_ptr<u3::CoefBackend>): backend for
+    //     comparison
+    //   fraction (double): fraction of calls to sample (0 to 1)
+    //   comparison (u3::ShadowComparison, optional): agreement
+    //     criterion
+    //   tolerance (double, optional): maximum allowed deviation
+    //   max_records (std::size_t, optional): maximum number of
+    //     discrepancies to retain (all are counted)
+
+    ////////////////////////////////////////////////////////////////
+    // backend interface
+    ////////////////////////////////////////////////////////////////
+
+    std::string Name() const override;
+    // Return name as "shadow(primary,shadow)".
+
+    u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      ) override;
+
+    u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block
+      ) override;
+
+    u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+        const u3::SU3& x1,  const u3::SU3& x2,  const u3::SU3& x12,
+        const u3::SU3& x3,  const u3::SU3& x4,  const u3::SU3& x34,
+        const u3::SU3& x13, const u3::SU3& x24, const u3::SU3& x,
+        std::vector<double>& block
+      ) override;
+
+    void Report(std::ostream& os) const override;
+    // Write sampling and discrepancy counts, and the retained
+    // discrepancies, followed by the reports of both backends.
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    long num_calls() const
+    {
+      return calls_.load(std::memory_order_relaxed);
+    }
+
+    long num_samples() const
+    {
+      return samples_.load(std::memory_order_relaxed);
+    }
+
+    long num_discrepancies() const
+    {
+      return num_discrepancies_.load(std::memory_order_relaxed);
+    }
+
+    double max_deviation() const;
+    // Return maximum deviation over sampled blocks.
+
+    std::vector<u3::CoefDiscrepancy> discrepancies() const;
+    // Return (copy of) retained discrepancies.
+
+    void ClearDiscrepancies();
+    // Reset counts and discard retained discrepancies.
+
+  private:
+
+    bool Sample();
+    // Count call, and determine whether it is to be sampled.
+
+    double Deviation(
+        bool same_shape,
+        const std::vector<double>& block,
+        const std::vector<double>& shadow_block
+      ) const;
+    // Evaluate deviation of shadow block from primary block, by the
+    // selected comparison.
+
+    bool Check(double deviation);
+    // Tally sampled block, returning true if it is a discrepancy.
+
+    void Record(const std::string& labels, double deviation);
+    // Retain discrepancy (up to max_records).
+
+    std::shared_ptr<u3::CoefBackend> primary_, shadow_;
+    double fraction_;
+    u3::ShadowComparison comparison_;
+    double tolerance_;
+    std::size_t max_records_;
+
+    std::atomic<long> calls_, samples_, num_discrepancies_;
+    mutable std::mutex mutex_;  // protects max_deviation_ and discrepancies_
+    double max_deviation_;
+    std::vector<u3::CoefDiscrepancy> discrepancies_;
+  };
+
+}  // namespace
+
+#endif
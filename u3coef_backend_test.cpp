@@ -0,0 +1,323 @@
+/****************************************************************
+  u3coef_backend_test.cpp
+
+  Test coefficient backend dispatch, store backend, and shadow
+  backend.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+
+****************************************************************/
+
+#include "sp3rlib/u3coef_backend.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// label generation
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::UCoefLabels> GenerateULabels(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+// Generate allowed U coefficient labels for given x1, x2, x3.
+{
+  std::vector<u3::UCoefLabels> label_set;
+  for (const MultiplicityTagged<u3::SU3>& x12_tagged : u3::KroneckerProduct(x1,x2))
+    for (const MultiplicityTagged<u3::SU3>& x23_tagged : u3::KroneckerProduct(x2,x3))
+      for (const MultiplicityTagged<u3::SU3>& x_tagged : u3::KroneckerProduct(x12_tagged.irrep,x3))
+        {
+          u3::UCoefLabels labels(x1,x2,x_tagged.irrep,x3,x12_tagged.irrep,x23_tagged.irrep);
+          if (labels.Allowed())
+            label_set.push_back(labels);
+        }
+  return label_set;
+}
+
+std::vector<u3::WCoefLabels> GenerateWLabels(const u3::SU3& x1, const u3::SU3& x2)
+// Generate allowed W coefficient labels for given x1, x2.
+{
+  std::vector<u3::WCoefLabels> label_set;
+  for (const MultiplicityTagged<u3::SU3>& x3_tagged : u3::KroneckerProduct(x1,x2))
+    for (int L1=0; L1<=x1.lambda()+x1.mu(); ++L1)
+      for (int L2=0; L2<=x2.lambda()+x2.mu(); ++L2)
+        for (int L3=std::abs(L1-L2); L3<=L1+L2; ++L3)
+          {
+            if ((u3::BranchingMultiplicitySO3(x1,L1)==0)
+                || (u3::BranchingMultiplicitySO3(x2,L2)==0)
+                || (u3::BranchingMultiplicitySO3(x3_tagged.irrep,L3)==0))
+              continue;
+            label_set.push_back(u3::WCoefLabels(x1,L1,x2,L2,x3_tagged.irrep,L3));
+          }
+  return label_set;
+}
+
+////////////////////////////////////////////////////////////////
+// test backend
+////////////////////////////////////////////////////////////////
+
+class PerturbedCoefBackend
+  : public u3::Su3libCoefBackend
+// su3lib backend with W coefficients scaled by a factor, to provide
+// discrepancies for the shadow backend.
+{
+public:
+
+  explicit PerturbedCoefBackend(double factor) : factor_(factor) {}
+
+  std::string Name() const override
+  {
+    return "perturbed";
+  }
+
+  u3::WMultiplicityTuple WBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    ) override
+  {
+    u3::WMultiplicityTuple multiplicities = u3::Su3libWBlock(x1,L1,x2,L2,x3,L3,block);
+    for (double& coef : block)
+      coef *= factor_;
+    return multiplicities;
+  }
+
+private:
+  double factor_;
+};
+
+////////////////////////////////////////////////////////////////
+// dispatch tests
+////////////////////////////////////////////////////////////////
+
+bool DispatchTest(const std::vector<u3::WCoefLabels>& w_label_set)
+// Check default backend and dispatch of W through selected backend.
+{
+  bool pass = (u3::CurrentCoefBackend().Name()=="su3lib") && !u3::GetCoefBackend();
+
+  u3::SU3 x1,x2,x3;
+  int L1,L2,L3;
+  std::tie(x1,L1,x2,L2,x3,L3) = w_label_set[0].Key();
+  std::vector<double> reference_block, block;
+  u3::WBlock(x1,L1,x2,L2,x3,L3,reference_block);
+
+  u3::SetCoefBackend(std::make_shared<PerturbedCoefBackend>(2.));
+  pass &= (u3::CurrentCoefBackend().Name()=="perturbed");
+  u3::WBlock(x1,L1,x2,L2,x3,L3,block);
+  pass &= (block.size()==reference_block.size()) && (block[0]==2.*reference_block[0]);
+
+  u3::SetCoefBackend(nullptr);
+  u3::WBlock(x1,L1,x2,L2,x3,L3,block);
+  pass &= (block==reference_block) && (u3::CurrentCoefBackend().Name()=="su3lib");
+
+  std::cout << fmt::format("dispatch: {}",(pass ? "ok" : "FAIL")) << std::endl;
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// store backend tests
+////////////////////////////////////////////////////////////////
+
+template <typename tLabels, typename tBlock>
+std::size_t WriteStore(const std::string& filename, const std::vector<tLabels>& label_set)
+// Write store holding first half of label set, returning number of
+// blocks stored.
+{
+  u3::CoefCache<tLabels,tBlock> cache;
+  for (std::size_t i=0; i<label_set.size()/2; ++i)
+    cache.GetBlock(label_set[i]);
+  u3::CoefStore<tLabels,tBlock>::Write(filename,cache);
+  return cache.size();
+}
+
+template <typename tLabels, typename tBlock>
+int CountMismatches(const std::vector<tLabels>& label_set, const u3::CoefCache<tLabels,tBlock>& reference_cache)
+// Count blocks, calculated through current backend, which differ
+// from reference blocks.
+{
+  int num_mismatches = 0;
+  for (const tLabels& labels : label_set)
+    {
+      tBlock block(labels);
+      const tBlock& reference_block = reference_cache.at(labels);
+      if ((block.Key()!=reference_block.Key())
+          || !std::equal(block.data(),block.data()+block.size(),reference_block.data()))
+        ++num_mismatches;
+    }
+  return num_mismatches;
+}
+
+bool StoreTest(
+    const std::vector<u3::UCoefLabels>& u_label_set,
+    const std::vector<u3::WCoefLabels>& w_label_set,
+    const std::vector<u3::PhiCoefLabels>& phi_label_set
+  )
+// Retrieve blocks through store backend, with half of each label
+// set in store and the rest from the su3lib fallback, and compare
+// with su3lib.
+{
+  // reference blocks from su3lib
+  u3::CoefCache<u3::UCoefLabels,u3::UCoefBlock> u_cache;
+  u3::CoefCache<u3::ZCoefLabels,u3::ZCoefBlock> z_cache;
+  u3::CoefCache<u3::WCoefLabels,u3::WCoefBlock> w_cache;
+  u3::CoefCache<u3::PhiCoefLabels,u3::PhiCoefBlock> phi_cache;
+  for (const u3::UCoefLabels& labels : u_label_set)
+    {
+      u_cache.GetBlock(labels);
+      z_cache.GetBlock(labels);
+    }
+  for (const u3::WCoefLabels& labels : w_label_set)
+    w_cache.GetBlock(labels);
+  for (const u3::PhiCoefLabels& labels : phi_label_set)
+    phi_cache.GetBlock(labels);
+
+  // stores (Z deliberately omitted, to exercise fallback)
+  std::size_t num_stored = 0;
+  num_stored += WriteStore<u3::UCoefLabels,u3::UCoefBlock>("u3coef_backend_test_u.bin",u_label_set);
+  num_stored += WriteStore<u3::WCoefLabels,u3::WCoefBlock>("u3coef_backend_test_w.bin",w_label_set);
+  num_stored += WriteStore<u3::PhiCoefLabels,u3::PhiCoefBlock>("u3coef_backend_test_phi.bin",phi_label_set);
+
+  auto backend = std::make_shared<u3::StoreCoefBackend>();
+  bool pass = true;
+  pass &= backend->Open(u3::CoefStoreKind::kU,"u3coef_backend_test_u.bin");
+  pass &= backend->Open(u3::CoefStoreKind::kW,"u3coef_backend_test_w.bin");
+  pass &= backend->Open(u3::CoefStoreKind::kPhi,"u3coef_backend_test_phi.bin");
+  pass &= !backend->Open(u3::CoefStoreKind::kZ,"u3coef_backend_test_missing.bin");
+  u3::SetCoefBackend(backend);
+
+  int num_mismatches = 0;
+  num_mismatches += CountMismatches(u_label_set,u_cache);
+  num_mismatches += CountMismatches(u_label_set,z_cache);
+  num_mismatches += CountMismatches(w_label_set,w_cache);
+  num_mismatches += CountMismatches(phi_label_set,phi_cache);
+  u3::SetCoefBackend(nullptr);
+
+  std::size_t num_blocks = 2*u_label_set.size()+w_label_set.size()+phi_label_set.size();
+  pass &= (num_mismatches==0)
+    && (std::size_t(backend->hits())==num_stored)
+    && (std::size_t(backend->hits()+backend->misses())==num_blocks);
+  std::cout << fmt::format("store: blocks {} stored {} hits {} misses {} mismatches {} {}",
+                           num_blocks,num_stored,backend->hits(),backend->misses(),num_mismatches,
+                           (pass ? "ok" : "FAIL"))
+            << std::endl;
+  backend->Report(std::cout);
+
+  std::remove("u3coef_backend_test_u.bin");
+  std::remove("u3coef_backend_test_w.bin");
+  std::remove("u3coef_backend_test_phi.bin");
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// shadow backend tests
+////////////////////////////////////////////////////////////////
+
+bool ShadowTest(
+    const std::string& name,
+    std::shared_ptr<u3::CoefBackend> shadow,
+    double fraction,
+    u3::ShadowComparison comparison,
+    const std::vector<u3::UCoefLabels>& u_label_set,
+    const std::vector<u3::WCoefLabels>& w_label_set,
+    bool expect_w_discrepancies
+  )
+// Evaluate U and W blocks through shadow backend (with su3lib
+// primary), and check that the primary blocks are returned, the
+// expected fraction of calls is sampled, and discrepancies are found
+// only in sampled (nonzero) W blocks, if expected.
+{
+  auto backend = std::make_shared<u3::ShadowCoefBackend>(
+      std::make_shared<u3::Su3libCoefBackend>(),shadow,fraction,comparison,1e-8,5
+    );
+  u3::SetCoefBackend(backend);
+  int num_mismatches = 0;
+  long expected_discrepancies = 0;
+  std::vector<double> block, reference_block;
+  for (const u3::UCoefLabels& labels : u_label_set)
+    {
+      u3::SU3 x1,x2,x,x3,x12,x23;
+      std::tie(x1,x2,x,x3,x12,x23) = labels.Key();
+      u3::UBlock(x1,x2,x,x3,x12,x23,block);
+      u3::Su3libUZBlock(x1,x2,x,x3,x12,x23,u3::UZMode::kU,reference_block);
+      num_mismatches += (block!=reference_block);
+    }
+  for (const u3::WCoefLabels& labels : w_label_set)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+      long num_samples = backend->num_samples();
+      u3::WBlock(x1,L1,x2,L2,x3,L3,block);
+      bool sampled = (backend->num_samples()>num_samples);
+      u3::Su3libWBlock(x1,L1,x2,L2,x3,L3,reference_block);
+      num_mismatches += (block!=reference_block);
+
+      // scaling only gives a discrepancy for a nonzero block
+      double max_coef = 0.;
+      for (double coef : reference_block)
+        max_coef = std::max(max_coef,std::abs(coef));
+      expected_discrepancies += (expect_w_discrepancies && sampled && (max_coef>1e-6));
+    }
+  u3::SetCoefBackend(nullptr);
+
+  long num_calls = u_label_set.size()+w_label_set.size();
+  long expected_samples = long(num_calls*fraction);
+  bool pass = (num_mismatches==0)
+    && (backend->num_calls()==num_calls)
+    && (backend->num_samples()==expected_samples)
+    && (backend->num_discrepancies()==expected_discrepancies)
+    && (backend->discrepancies().size()==std::min<std::size_t>(expected_discrepancies,5));
+  std::cout << fmt::format("shadow {}: calls {} samples {} discrepancies {} max deviation {:.2e} {}",
+                           name,backend->num_calls(),backend->num_samples(),backend->num_discrepancies(),
+                           backend->max_deviation(),(pass ? "ok" : "FAIL"))
+            << std::endl;
+  for (const u3::CoefDiscrepancy& discrepancy : backend->discrepancies())
+    std::cout << fmt::format("  {} {:.2e}",discrepancy.labels,discrepancy.deviation) << std::endl;
+
+  backend->ClearDiscrepancies();
+  pass &= (backend->num_samples()==0) && backend->discrepancies().empty();
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  u3::U3CoefInit();
+
+  std::vector<u3::UCoefLabels> u_label_set = GenerateULabels(u3::SU3(2,1),u3::SU3(1,1),u3::SU3(2,0));
+  std::vector<u3::WCoefLabels> w_label_set = GenerateWLabels(u3::SU3(2,2),u3::SU3(1,1));
+  std::vector<u3::PhiCoefLabels> phi_label_set;
+  for (const MultiplicityTagged<u3::SU3>& x3_tagged : u3::KroneckerProduct(u3::SU3(2,2),u3::SU3(2,2)))
+    phi_label_set.push_back(u3::PhiCoefLabels(u3::SU3(2,2),u3::SU3(2,2),x3_tagged.irrep));
+
+  bool pass = true;
+  pass &= DispatchTest(w_label_set);
+  pass &= StoreTest(u_label_set,w_label_set,phi_label_set);
+  pass &= ShadowTest(
+      "su3lib",std::make_shared<u3::Su3libCoefBackend>(),0.25,u3::ShadowComparison::kCoefficients,
+      u_label_set,w_label_set,false
+    );
+  pass &= ShadowTest(
+      "perturbed",std::make_shared<PerturbedCoefBackend>(1.5),1.,u3::ShadowComparison::kCoefficients,
+      u_label_set,w_label_set,true
+    );
+  pass &= ShadowTest(
+      "perturbed (norms)",std::make_shared<PerturbedCoefBackend>(1.5),0.5,u3::ShadowComparison::kNorms,
+      u_label_set,w_label_set,true
+    );
+
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,115 @@
+/****************************************************************
+  u3coef_benchmark.cpp
+
+  Timing of SU(3) coupling coefficient caches.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created, with concurrent cache scaling benchmark.
+
+****************************************************************/
+
+#include "sp3rlib/u3coef.h"
+
+#include <omp.h>
+#include <iostream>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// label generation
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::UCoefLabels> GenerateULabels(int lm_max)
+// Generate allowed U coefficient labels (x1,x2,x,x3,x12,x23), for
+// x1,x2,x3 with lambda,mu<=lm_max, and x12, x23, x drawn from the
+// Kronecker products.
+{
+  std::vector<u3::SU3> irreps;
+  for (int lambda=0; lambda<=lm_max; ++lambda)
+    for (int mu=0; mu<=lm_max; ++mu)
+      irreps.push_back(u3::SU3(lambda,mu));
+
+  std::vector<u3::UCoefLabels> label_set;
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      for (const u3::SU3& x3 : irreps)
+        for (const MultiplicityTagged<u3::SU3>& x12_rho : u3::KroneckerProduct(x1,x2))
+          for (const MultiplicityTagged<u3::SU3>& x_rho : u3::KroneckerProduct(x12_rho.irrep,x3))
+            for (const MultiplicityTagged<u3::SU3>& x23_rho : u3::KroneckerProduct(x2,x3))
+              if (u3::OuterMultiplicity(x1,x23_rho.irrep,x_rho.irrep)>0)
+                label_set.push_back(u3::UCoefLabels(x1,x2,x_rho.irrep,x3,x12_rho.irrep,x23_rho.irrep));
+  return label_set;
+}
+
+////////////////////////////////////////////////////////////////
+// concurrent cache scaling
+////////////////////////////////////////////////////////////////
+
+void RetrieveCoefficients(
+    u3::ConcurrentUCoefCache& cache, const std::vector<u3::UCoefLabels>& label_set,
+    std::vector<double>& values
+  )
+// Retrieve (1,1,1,1) entries of U coefficient blocks over label set,
+// in parallel.
+{
+  values.resize(label_set.size());
+  #pragma omp parallel for schedule(dynamic,64)
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    values[i] = cache.GetBlock(label_set[i]).GetCoef(1,1,1,1);
+}
+
+void ConcurrentCacheScaling(int lm_max, int num_passes, int max_threads)
+// Measure throughput of concurrent U coefficient cache for 1, 2, 4,
+// ..., max_threads threads, for both cold (populating) and hot
+// (lookup only) passes.
+{
+  std::vector<u3::UCoefLabels> label_set = GenerateULabels(lm_max);
+  std::cout << fmt::format("Concurrent U cache: lm_max {} labels {} passes {}",
+                           lm_max,label_set.size(),num_passes)
+            << std::endl;
+
+  std::vector<double> reference_values, values;
+  for (int num_threads=1; num_threads<=max_threads; num_threads*=2)
+    {
+      omp_set_num_threads(num_threads);
+      u3::ConcurrentUCoefCache cache;
+
+      // cold pass: populate cache
+      double start_time = omp_get_wtime();
+      RetrieveCoefficients(cache,label_set,values);
+      double time_cold = omp_get_wtime()-start_time;
+      if (num_threads==1)
+        reference_values = values;
+      bool values_ok = (values==reference_values);
+
+      // hot passes: lookups only
+      start_time = omp_get_wtime();
+      for (int pass=0; pass<num_passes; ++pass)
+        RetrieveCoefficients(cache,label_set,values);
+      double time_hot = omp_get_wtime()-start_time;
+      values_ok &= (values==reference_values);
+
+      double num_lookups = double(label_set.size())*num_passes;
+      std::cout << fmt::format("  threads {:2d} entries {} cold {:.3f} s hot {:.3f} s ({:.1f} Mlookup/s) values {}",
+                               num_threads,cache.size(),time_cold,time_hot,
+                               num_lookups/time_hot/1e6,(values_ok ? "ok" : "MISMATCH"))
+                << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  u3::U3CoefInit();
+
+  ConcurrentCacheScaling(2,20,64);
+
+}
@@ -0,0 +1,1724 @@
+/****************************************************************
+  u3coef_native.cpp
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+****************************************************************/
+
+#include "sp3rlib/u3coef_native.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "am/wigner_gsl.h"
+#include "fmt/format.h"
+
+namespace u3
+{
+  namespace native
+  {
+
+    ////////////////////////////////////////////////////////////////
+    // dense linear algebra
+    ////////////////////////////////////////////////////////////////
+
+    // Matrices are stored row-major in std::vector<double>.
+
+    static void SymmetricEigensystem(
+        int n, std::vector<double>& matrix,
+        std::vector<double>& eigenvalues, std::vector<double>& eigenvectors
+      )
+    // Diagonalize real symmetric matrix by cyclic Jacobi rotations.
+    //
+    // Arguments:
+    //   n (int): dimension
+    //   matrix (std::vector<double>, input/output): matrix
+    //     (overwritten)
+    //   eigenvalues (std::vector<double>, output): eigenvalues
+    //   eigenvectors (std::vector<double>, output): eigenvectors, as
+    //     columns
+    {
+      std::vector<double>& a = matrix;
+      std::vector<double>& v = eigenvectors;
+      v.assign(n*n,0.);
+      for (int i=0; i<n; ++i)
+        v[i*n+i] = 1.;
+
+      for (int sweep=0; sweep<100; ++sweep)
+        {
+          double diagonal = 0., off_diagonal = 0.;
+          for (int i=0; i<n; ++i)
+            {
+              diagonal += a[i*n+i]*a[i*n+i];
+              for (int j=i+1; j<n; ++j)
+                off_diagonal += a[i*n+j]*a[i*n+j];
+            }
+          if (off_diagonal<=1e-30*diagonal)
+            break;
+
+          for (int p=0; p<n-1; ++p)
+            for (int q=p+1; q<n; ++q)
+              {
+                const double apq = a[p*n+q];
+                if (std::abs(apq)<=1e-300)
+                  continue;
+                const double theta = (a[q*n+q]-a[p*n+p])/(2*apq);
+                const double t = ((theta>=0) ? 1. : -1.)/(std::abs(theta)+std::sqrt(theta*theta+1.));
+                const double c = 1./std::sqrt(t*t+1.);
+                const double s = t*c;
+                for (int k=0; k<n; ++k)
+                  {
+                    const double akp = a[k*n+p], akq = a[k*n+q];
+                    a[k*n+p] = c*akp-s*akq;
+                    a[k*n+q] = s*akp+c*akq;
+                  }
+                for (int k=0; k<n; ++k)
+                  {
+                    const double apk = a[p*n+k], aqk = a[q*n+k];
+                    a[p*n+k] = c*apk-s*aqk;
+                    a[q*n+k] = s*apk+c*aqk;
+                  }
+                for (int k=0; k<n; ++k)
+                  {
+                    const double vkp = v[k*n+p], vkq = v[k*n+q];
+                    v[k*n+p] = c*vkp-s*vkq;
+                    v[k*n+q] = s*vkp+c*vkq;
+                  }
+              }
+        }
+
+      eigenvalues.resize(n);
+      for (int i=0; i<n; ++i)
+        eigenvalues[i] = a[i*n+i];
+    }
+
+    static bool CholeskySolve(
+        int n, std::vector<double>& matrix, int m, std::vector<double>& rhs
+      )
+    // Solve positive definite linear system, for multiple right hand
+    // sides.
+    //
+    // Arguments:
+    //   n (int): dimension
+    //   matrix (std::vector<double>, input/output): n x n matrix
+    //     (overwritten by Cholesky factor)
+    //   m (int): number of right hand sides
+    //   rhs (std::vector<double>, input/output): n x m right hand
+    //     sides (overwritten by solutions)
+    //
+    // Returns:
+    //   (bool): false if matrix is (numerically) singular
+    {
+      std::vector<double>& a = matrix;
+      for (int j=0; j<n; ++j)
+        {
+          double d = a[j*n+j];
+          for (int k=0; k<j; ++k)
+            d -= a[j*n+k]*a[j*n+k];
+          if (!(d>1e-12))
+            return false;
+          d = std::sqrt(d);
+          a[j*n+j] = d;
+          for (int i=j+1; i<n; ++i)
+            {
+              double sum = a[i*n+j];
+              for (int k=0; k<j; ++k)
+                sum -= a[i*n+k]*a[j*n+k];
+              a[i*n+j] = sum/d;
+            }
+        }
+      for (int column=0; column<m; ++column)
+        {
+          for (int i=0; i<n; ++i)
+            {
+              double sum = rhs[i*m+column];
+              for (int k=0; k<i; ++k)
+                sum -= a[i*n+k]*rhs[k*m+column];
+              rhs[i*m+column] = sum/a[i*n+i];
+            }
+          for (int i=n-1; i>=0; --i)
+            {
+              double sum = rhs[i*m+column];
+              for (int k=i+1; k<n; ++k)
+                sum -= a[k*n+i]*rhs[k*m+column];
+              rhs[i*m+column] = sum/a[i*n+i];
+            }
+        }
+      return true;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // SU(2) Clebsch-Gordan coefficients
+    ////////////////////////////////////////////////////////////////
+
+    // Angular momenta and projections are given doubled, so that the
+    // same functions serve for the SU(2) quasi-spin Lambda of the
+    // U(2) subgroup and for SO(3) angular momentum L.
+
+    static double ClebschGordan(int tj1, int tm1, int tj2, int tm2, int tj3, int tm3)
+    // Calculate Clebsch-Gordan coefficient <j1 m1; j2 m2|j3 m3>, by
+    // the Racah formula, from doubled arguments.
+    {
+      if ((tm1+tm2!=tm3)||(std::abs(tm1)>tj1)||(std::abs(tm2)>tj2)||(std::abs(tm3)>tj3))
+        return 0.;
+      if (((tj1+tm1)%2)||((tj2+tm2)%2)||((tj3+tm3)%2)||((tj1+tj2+tj3)%2))
+        return 0.;
+      if ((tj3<std::abs(tj1-tj2))||(tj3>tj1+tj2))
+        return 0.;
+      auto lf = [](int n) {return std::lgamma(n+1.);};
+      const int j12_3 = (tj1+tj2-tj3)/2, j13_2 = (tj1-tj2+tj3)/2, j23_1 = (-tj1+tj2+tj3)/2;
+      const int j1_plus = (tj1+tm1)/2, j1_minus = (tj1-tm1)/2;
+      const int j2_plus = (tj2+tm2)/2, j2_minus = (tj2-tm2)/2;
+      const int j3_plus = (tj3+tm3)/2, j3_minus = (tj3-tm3)/2;
+      const double log_prefactor = 0.5*(
+          std::log(tj3+1.)
+          +lf(j12_3)+lf(j13_2)+lf(j23_1)-lf((tj1+tj2+tj3)/2+1)
+          +lf(j1_plus)+lf(j1_minus)+lf(j2_plus)+lf(j2_minus)+lf(j3_plus)+lf(j3_minus)
+        );
+      const int k_min = std::max({0,(tj2-tj3-tm1)/2,(tj1-tj3+tm2)/2});
+      const int k_max = std::min({j12_3,j1_minus,j2_plus});
+      double sum = 0.;
+      for (int k=k_min; k<=k_max; ++k)
+        {
+          const double term = std::exp(
+              log_prefactor
+              -lf(k)-lf(j12_3-k)-lf(j1_minus-k)-lf(j2_plus-k)
+              -lf((tj3-tj2+tm1)/2+k)-lf((tj3-tj1-tm2)/2+k)
+            );
+          sum += (k%2) ? -term : term;
+        }
+      return sum;
+    }
+
+    struct CGLabels
+    // Doubled angular momenta (j1,j2,j3) for table of Clebsch-Gordan
+    // coefficients.
+    {
+      CGLabels(int tj1_, int tj2_, int tj3_)
+        : tj1(tj1_), tj2(tj2_), tj3(tj3_)
+      {}
+
+      inline friend bool operator == (const CGLabels& labels1, const CGLabels& labels2)
+      {
+        return (labels1.tj1==labels2.tj1) && (labels1.tj2==labels2.tj2) && (labels1.tj3==labels2.tj3);
+      }
+
+      inline friend std::size_t hash_value(const CGLabels& labels)
+      {
+        return PackedHash((PackLabel(labels.tj1,16)<<32)|(PackLabel(labels.tj2,16)<<16)|PackLabel(labels.tj3,16));
+      }
+
+      int tj1, tj2, tj3;
+    };
+
+    struct CGTable
+    // Clebsch-Gordan coefficients <j1 m1; j2 m3-m1|j3 m3>, for all m1
+    // and m3.
+    {
+      CGTable() : tj1(0), tj3(0) {}
+
+      explicit CGTable(const CGLabels& labels)
+        : tj1(labels.tj1), tj3(labels.tj3)
+      {
+        coefs.resize((tj1+1)*(tj3+1));
+        for (int tm1=-tj1; tm1<=tj1; tm1+=2)
+          for (int tm3=-tj3; tm3<=tj3; tm3+=2)
+            coefs[((tm1+tj1)/2)*(tj3+1)+(tm3+tj3)/2]
+              = ClebschGordan(tj1,tm1,labels.tj2,tm3-tm1,tj3,tm3);
+      }
+
+      double operator()(int tm1, int tm3) const
+      // Return coefficient, for doubled projections.
+      {
+        return coefs[((tm1+tj1)/2)*(tj3+1)+(tm3+tj3)/2];
+      }
+
+      std::size_t size() const
+      {
+        return coefs.size();
+      }
+
+      int tj1, tj3;
+      std::vector<double> coefs;
+    };
+
+    ////////////////////////////////////////////////////////////////
+    // Gelfand-Tsetlin basis of irrep
+    ////////////////////////////////////////////////////////////////
+
+    typedef std::vector<std::pair<int,double>> SparseColumn;
+    // nonzero matrix elements (row,value) of a column of an operator
+
+    static SparseColumn ComposeColumns(
+        const std::vector<SparseColumn>& left, const std::vector<SparseColumn>& right, int column
+      )
+    // Calculate column of product of operators (left)(right).
+    {
+      std::map<int,double> result;
+      for (const auto& middle_value : right[column])
+        for (const auto& row_value : left[middle_value.first])
+          result[row_value.first] += row_value.second*middle_value.second;
+      return SparseColumn(result.begin(),result.end());
+    }
+
+    static std::vector<SparseColumn> Transpose(const std::vector<SparseColumn>& columns)
+    {
+      std::vector<SparseColumn> transpose(columns.size());
+      for (int column=0; column<int(columns.size()); ++column)
+        for (const auto& row_value : columns[column])
+          transpose[row_value.first].emplace_back(column,row_value.second);
+      return transpose;
+    }
+
+    struct GTIrrep
+    // Gelfand-Tsetlin basis for SU(3) irrep, with generators and
+    // SO(3) (Vergados) basis.
+    //
+    // The irrep (lambda,mu) is represented by the U(3) irrep [f1,f2,0]
+    // = [lambda+mu,mu,0], with GT patterns (m12,m22,m11).  Patterns
+    // are enumerated in decreasing lexicographic order, so the highest
+    // weight pattern is first.
+    {
+      GTIrrep() : f1(0), f2(0), extremal_m12(0), extremal_m22(0) {}
+
+      explicit GTIrrep(const u3::SU3& x);
+
+      // top row of patterns
+      int f1, f2;
+
+      // U(2) irrep [m12,m22] of extremal states, which are the Elliott
+      // intrinsic states: [mu,0] (maximal n_0) for lambda>=mu, or
+      // [lambda+mu,mu] (minimal n_0, including the highest weight
+      // state) for lambda<mu
+      int extremal_m12, extremal_m22;
+
+      // patterns (m12,m22,m11) and weights (n_+1,n_-1,n_0)
+      std::vector<std::array<int,3>> patterns, weights;
+
+      // generators E12, E21, E23, E32, E31, indexed by column
+      std::vector<SparseColumn> e12, e21, e23, e32, e31;
+
+      // patterns of each M, indexed by M+f1, and position of each
+      // pattern within its M subspace
+      std::vector<std::vector<int>> m_patterns;
+      std::vector<int> m_position;
+
+      // Vergados basis states |kappa L M>, as vectors on the patterns
+      // of M, indexed by state_offset[L]+(kappa-1)*(2L+1)+(M+L)
+      std::vector<int> kappa_max, state_offset;
+      std::vector<std::vector<double>> states;
+
+      // left inverse of overlaps <kappa L K|E K> of Vergados states
+      // with extremal states (see ExtremalPattern), indexed by
+      // [L][(kappa-1)*(t+1)+(K+t)/2], where t is extremal_t() (zero for
+      // |K|>L)
+      std::vector<std::vector<double>> extremal_inverse;
+
+      int dim() const
+      {
+        return patterns.size();
+      }
+
+      int M(int pattern) const
+      // Return SO(3) projection of pattern.
+      {
+        return weights[pattern][0]-weights[pattern][1];
+      }
+
+      int PatternIndex(int m12, int m22, int m11) const
+      {
+        return pattern_index_[((m12-f2)*(f2+1)+m22)*(f1+1)+m11];
+      }
+
+      int PatternIndexM(int m12, int m22, int M) const
+      // Return index of pattern in U(2) irrep [m12,m22] with given
+      // SO(3) projection M (twice the U(2) quasi-spin projection).
+      {
+        return PatternIndex(m12,m22,(M+m12+m22)/2);
+      }
+
+      int extremal_t() const
+      // Return twice quasi-spin of extremal states.
+      {
+        return extremal_m12-extremal_m22;
+      }
+
+      int ExtremalPattern(int K) const
+      // Return index of extremal pattern with M=K.
+      {
+        return PatternIndexM(extremal_m12,extremal_m22,K);
+      }
+
+      const std::vector<double>& State(int L, int kappa, int M) const
+      // Return Vergados basis state.
+      {
+        return states[state_offset[L]+(kappa-1)*(2*L+1)+(M+L)];
+      }
+
+      std::size_t size() const
+      // Return approximate storage, in doubles.
+      {
+        std::size_t count = 0;
+        for (const std::vector<double>& state : states)
+          count += state.size();
+        for (const std::vector<double>& inverse : extremal_inverse)
+          count += inverse.size();
+        for (const std::vector<SparseColumn>* op : {&e12,&e21,&e23,&e32,&e31})
+          for (const SparseColumn& column : *op)
+            count += 2*column.size();
+        return count;
+      }
+
+    private:
+
+      void ConstructPatterns();
+      void ConstructGenerators();
+      void ConstructSO3Basis(const u3::SU3& x);
+      void ConstructExtremalInverse(const u3::SU3& x);
+
+      std::vector<int> pattern_index_;
+    };
+
+    GTIrrep::GTIrrep(const u3::SU3& x)
+      : f1(x.lambda()+x.mu()), f2(x.mu()),
+        extremal_m12((x.lambda()>=x.mu()) ? x.mu() : x.lambda()+x.mu()),
+        extremal_m22((x.lambda()>=x.mu()) ? 0 : x.mu())
+    {
+      ConstructPatterns();
+      ConstructGenerators();
+      ConstructSO3Basis(x);
+      ConstructExtremalInverse(x);
+    }
+
+    void GTIrrep::ConstructPatterns()
+    {
+      pattern_index_.assign((f1-f2+1)*(f2+1)*(f1+1),-1);
+      for (int m12=f1; m12>=f2; --m12)
+        for (int m22=f2; m22>=0; --m22)
+          for (int m11=m12; m11>=m22; --m11)
+            {
+              pattern_index_[((m12-f2)*(f2+1)+m22)*(f1+1)+m11] = patterns.size();
+              patterns.push_back({m12,m22,m11});
+              weights.push_back({m11,m12+m22-m11,f1+f2-m12-m22});
+            }
+    }
+
+    void GTIrrep::ConstructGenerators()
+    // Construct raising generators from GT formulas, in terms of the
+    // shifted labels l_ij = m_ij - i, lowering generators as their
+    // transposes, and E31 = [E32,E21].
+    {
+      e12.resize(dim());
+      e23.resize(dim());
+      const int l13 = f1-1, l23 = f2-2, l33 = -3;
+      for (int pattern=0; pattern<dim(); ++pattern)
+        {
+          const int m12 = patterns[pattern][0], m22 = patterns[pattern][1], m11 = patterns[pattern][2];
+          const int l12 = m12-1, l22 = m22-2, l11 = m11-1;
+
+          // E12: m11 -> m11+1
+          if (m11+1<=m12)
+            e12[pattern].emplace_back(
+                PatternIndex(m12,m22,m11+1),
+                std::sqrt(double(m12-m11)*(m11-m22+1))
+              );
+
+          // E23: m12 -> m12+1
+          if (m12+1<=f1)
+            {
+              const double numerator = double(l13-l12)*(l23-l12)*(l33-l12)*(l11-l12-1);
+              const double denominator = double(l22-l12)*(l22-l12-1);
+              e23[pattern].emplace_back(PatternIndex(m12+1,m22,m11),std::sqrt(std::abs(numerator/denominator)));
+            }
+
+          // E23: m22 -> m22+1
+          if ((m22+1<=f2)&&(m22+1<=m11))
+            {
+              const double numerator = double(l13-l22)*(l23-l22)*(l33-l22)*(l11-l22-1);
+              const double denominator = double(l12-l22)*(l12-l22-1);
+              e23[pattern].emplace_back(PatternIndex(m12,m22+1,m11),std::sqrt(std::abs(numerator/denominator)));
+            }
+        }
+      e21 = Transpose(e12);
+      e32 = Transpose(e23);
+
+      e31.resize(dim());
+      for (int pattern=0; pattern<dim(); ++pattern)
+        {
+          std::map<int,double> column;
+          for (const auto& row_value : ComposeColumns(e32,e21,pattern))
+            column[row_value.first] += row_value.second;
+          for (const auto& row_value : ComposeColumns(e21,e32,pattern))
+            column[row_value.first] -= row_value.second;
+          for (const auto& row_value : column)
+            if (std::abs(row_value.second)>1e-12)
+              e31[pattern].push_back(row_value);
+        }
+    }
+
+    void GTIrrep::ConstructSO3Basis(const u3::SU3& x)
+    // Construct Vergados basis.
+    //
+    // For lambda<mu, the states carry the phase (-1)^(L+(lambda-K)/2)
+    // of Draayer and Akiyama, relative to the projected intrinsic
+    // states.
+    //
+    // With quanta ordered (+1,-1,0), L+ = sqrt(2)(E13+E32) and L- =
+    // sqrt(2)(E31+E23), where E13 = [E12,E23].
+    {
+      // SO(3) generators
+      std::vector<SparseColumn> l_plus(dim());
+      for (int pattern=0; pattern<dim(); ++pattern)
+        {
+          std::map<int,double> column;
+          for (const auto& row_value : ComposeColumns(e12,e23,pattern))
+            column[row_value.first] += std::sqrt(2.)*row_value.second;
+          for (const auto& row_value : ComposeColumns(e23,e12,pattern))
+            column[row_value.first] -= std::sqrt(2.)*row_value.second;
+          for (const auto& row_value : e32[pattern])
+            column[row_value.first] += std::sqrt(2.)*row_value.second;
+          for (const auto& row_value : column)
+            if (row_value.second!=0.)
+              l_plus[pattern].push_back(row_value);
+        }
+      const std::vector<SparseColumn> l_minus = Transpose(l_plus);
+
+      // M subspaces
+      m_patterns.resize(2*f1+1);
+      m_position.resize(dim());
+      for (int pattern=0; pattern<dim(); ++pattern)
+        {
+          std::vector<int>& subspace = m_patterns[M(pattern)+f1];
+          m_position[pattern] = subspace.size();
+          subspace.push_back(pattern);
+        }
+
+      // apply ladder operator to vector on M subspace (where an empty
+      // vector represents an M outside the irrep)
+      auto ladder = [this](const std::vector<SparseColumn>& op, int M, int dM, const std::vector<double>& vector)
+        {
+          if (std::abs(M+dM)>f1)
+            return std::vector<double>();
+          std::vector<double> result(m_patterns[M+dM+f1].size(),0.);
+          if (vector.empty())
+            return result;
+          const std::vector<int>& subspace = m_patterns[M+f1];
+          for (int position=0; position<int(subspace.size()); ++position)
+            for (const auto& row_value : op[subspace[position]])
+              result[m_position[row_value.first]] += row_value.second*vector[position];
+          return result;
+        };
+
+      // Elliott intrinsic states (K = 2 m11 - m12 - m22)
+      const int lambda = x.lambda(), mu = x.mu();
+      const bool prolate = (lambda>=mu);
+      const int K_max = std::min(lambda,mu);
+      const int max_lm = std::max(lambda,mu);
+      auto intrinsic_pattern = [&](int K)
+        {
+          return prolate
+            ? PatternIndex(mu,0,(K+mu)/2)
+            : PatternIndex(lambda+mu,mu,(K+lambda+2*mu)/2);
+        };
+
+      // allocate states
+      const int L_max = lambda+mu;
+      kappa_max.assign(L_max+1,0);
+      state_offset.assign(L_max+1,0);
+      int num_states = 0;
+      for (int L=0; L<=L_max; ++L)
+        {
+          kappa_max[L] = u3::BranchingMultiplicitySO3(x,L);
+          state_offset[L] = num_states;
+          num_states += kappa_max[L]*(2*L+1);
+        }
+      states.resize(num_states);
+
+      // projectors onto L, on M=K subspaces, from eigensystem of L^2
+      std::vector<std::vector<double>> eigenvalues(K_max+1), eigenvectors(K_max+1);
+      for (int K=K_max%2; K<=K_max; K+=2)
+        {
+          const int n = m_patterns[K+f1].size();
+          std::vector<double> l_squared(n*n,0.);
+          for (int column=0; column<n; ++column)
+            {
+              std::vector<double> unit(n,0.);
+              unit[column] = 1.;
+              const std::vector<double> result = ladder(l_minus,K+1,-1,ladder(l_plus,K,+1,unit));
+              for (int row=0; row<n; ++row)
+                l_squared[row*n+column] = result[row];
+              l_squared[column*n+column] += K*(K+1);
+            }
+          SymmetricEigensystem(n,l_squared,eigenvalues[K],eigenvectors[K]);
+        }
+
+      for (int L=0; L<=L_max; ++L)
+        {
+          std::vector<std::vector<double>> top_states;  // orthonormalized states at M=L
+          for (int K=K_max%2; K<=std::min(K_max,L); K+=2)
+            {
+              // Elliott allowed (K,L)
+              if ((K==0)&&((L>max_lm)||((max_lm-L)%2)))
+                continue;
+              if (L>K+max_lm)
+                continue;
+
+              // project intrinsic state onto L
+              const int n = m_patterns[K+f1].size();
+              const int position = m_position[intrinsic_pattern(K)];
+              std::vector<double> state(n,0.);
+              for (int k=0; k<n; ++k)
+                if (std::abs(eigenvalues[K][k]-L*(L+1))<0.5)
+                  for (int row=0; row<n; ++row)
+                    state[row] += eigenvectors[K][row*n+k]*eigenvectors[K][position*n+k];
+
+              // raise to M=L
+              for (int M=K; M<L; ++M)
+                {
+                  state = ladder(l_plus,M,+1,state);
+                  const double factor = 1./std::sqrt(double(L*(L+1)-M*(M+1)));
+                  for (double& value : state)
+                    value *= factor;
+                }
+
+              // orthonormalize
+              for (const std::vector<double>& previous : top_states)
+                {
+                  double overlap = 0.;
+                  for (int i=0; i<int(state.size()); ++i)
+                    overlap += previous[i]*state[i];
+                  for (int i=0; i<int(state.size()); ++i)
+                    state[i] -= overlap*previous[i];
+                }
+              double norm = 0.;
+              for (double value : state)
+                norm += value*value;
+              norm = std::sqrt(norm);
+              if (norm<1e-8)
+                {
+                  std::cerr << "ERROR: u3::native: dependent Elliott state for "
+                            << x.Str() << " K " << K << " L " << L << std::endl;
+                  std::exit(EXIT_FAILURE);
+                }
+              const double phase = (!prolate&&((L+(lambda-K)/2)%2)) ? -1. : 1.;
+              for (double& value : state)
+                value *= phase/norm;
+              top_states.push_back(std::move(state));
+            }
+          if (int(top_states.size())!=kappa_max[L])
+            {
+              std::cerr << "ERROR: u3::native: SO(3) multiplicity mismatch for "
+                        << x.Str() << " L " << L << std::endl;
+              std::exit(EXIT_FAILURE);
+            }
+
+          // lower to all M
+          for (int kappa=1; kappa<=kappa_max[L]; ++kappa)
+            {
+              std::vector<double> state = top_states[kappa-1];
+              for (int M=L; M>=-L; --M)
+                {
+                  if (M<L)
+                    {
+                      state = ladder(l_minus,M+1,-1,state);
+                      const double factor = 1./std::sqrt(double(L*(L+1)-(M+1)*M));
+                      for (double& value : state)
+                        value *= factor;
+                    }
+                  states[state_offset[L]+(kappa-1)*(2*L+1)+(M+L)] = state;
+                }
+            }
+        }
+    }
+
+
+    void GTIrrep::ConstructExtremalInverse(const u3::SU3& x)
+    // Construct left inverse of the overlaps A_{K kappa} = <kappa L
+    // K|E K> of the Vergados states with the extremal states, as
+    // (A^T A)^(-1) A^T.
+    {
+      const int t = extremal_t();
+      const int num_K = t+1;
+      extremal_inverse.resize(kappa_max.size());
+      for (int L=0; L<int(kappa_max.size()); ++L)
+        {
+          const int n = kappa_max[L];
+          if (n==0)
+            continue;
+          std::vector<double> overlaps(n*num_K,0.);  // A^T
+          for (int kappa=1; kappa<=n; ++kappa)
+            for (int K=-t; K<=t; K+=2)
+              if (std::abs(K)<=L)
+                overlaps[(kappa-1)*num_K+(K+t)/2]
+                  = State(L,kappa,K)[m_position[ExtremalPattern(K)]];
+          std::vector<double> normal(n*n,0.);
+          for (int kappa=0; kappa<n; ++kappa)
+            for (int kappap=0; kappap<n; ++kappap)
+              for (int k=0; k<num_K; ++k)
+                normal[kappa*n+kappap] += overlaps[kappa*num_K+k]*overlaps[kappap*num_K+k];
+          if (!CholeskySolve(n,normal,num_K,overlaps))
+            {
+              std::cerr << "ERROR: u3::native: extremal states do not span SO(3) states of "
+                        << x.Str() << " L " << L << std::endl;
+              std::exit(EXIT_FAILURE);
+            }
+          extremal_inverse[L] = std::move(overlaps);
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // memo tables
+    ////////////////////////////////////////////////////////////////
+
+    // Memo tables are kept per thread, so that lookups need no
+    // locking, each in a BoundedCoefCache with the byte budget set by
+    // SetCacheBudget.  Tables are held by shared pointer, so that a
+    // table in use remains valid if it is evicted by a subsequent
+    // lookup.
+    //
+    // ClearCaches advances a generation count, and each thread
+    // releases its tables at its next lookup in a later generation.
+    // Statistics are accumulated over all threads.
+
+    static const std::size_t kDefaultCacheBudget = std::size_t(64)<<20;  // 64 MiB
+    static std::atomic<std::size_t> g_cache_budget(kDefaultCacheBudget);
+    static std::atomic<long> g_cache_generation(0);
+
+    struct MemoTableCounters
+    // Statistics for memo table, over all threads.
+    {
+      MemoTableCounters()
+        : hits(0), misses(0), evictions(0), entries(0), bytes(0)
+      {}
+
+      std::atomic<long> hits, misses, evictions, entries, bytes;
+    };
+
+    template <typename tLabels, typename tTable>
+    class MemoTable
+    // Per-thread memo table, for tables of type tTable, which must be
+    // constructible from tLabels and provide size() (approximate
+    // storage in doubles).
+    {
+    public:
+
+      static std::shared_ptr<const tTable> Get(const tLabels& labels)
+      // Retrieve table, constructing it if not already memoized.
+      {
+        Local& local = GetLocal();
+        local.Synchronize();
+        const long misses = local.cache.misses(), evictions = local.cache.evictions();
+        const long entries = local.cache.size(), bytes = local.cache.bytes();
+        std::shared_ptr<const tTable> table = local.cache.GetBlock(labels).table;
+        MemoTableCounters& counters = Counters();
+        if (local.cache.misses()==misses)
+          counters.hits.fetch_add(1,std::memory_order_relaxed);
+        else
+          {
+            counters.misses.fetch_add(1,std::memory_order_relaxed);
+            counters.evictions.fetch_add(local.cache.evictions()-evictions,std::memory_order_relaxed);
+            counters.entries.fetch_add(long(local.cache.size())-entries,std::memory_order_relaxed);
+            counters.bytes.fetch_add(long(local.cache.bytes())-bytes,std::memory_order_relaxed);
+          }
+        return table;
+      }
+
+      static void Synchronize()
+      // Apply any change in generation or budget to calling thread's
+      // table.
+      {
+        GetLocal().Synchronize();
+      }
+
+      static void Report(std::ostream& os, const char* name)
+      {
+        const MemoTableCounters& counters = Counters();
+        os << fmt::format(
+            "native {} entries {} hits {} misses {} evictions {} bytes {}",
+            name,counters.entries.load(),counters.hits.load(),counters.misses.load(),
+            counters.evictions.load(),counters.bytes.load()
+          )
+           << std::endl;
+      }
+
+    private:
+
+      struct Entry
+      {
+        Entry() {}
+
+        explicit Entry(const tLabels& labels)
+          : table(std::make_shared<const tTable>(labels))
+        {}
+
+        std::size_t size() const
+        {
+          return table ? table->size() : 0;
+        }
+
+        std::shared_ptr<const tTable> table;
+      };
+
+      struct Local
+      {
+        Local()
+          : cache(g_cache_budget.load()), generation(g_cache_generation.load())
+        {
+          Counters();  // construct before, and so destroy after, thread-local table
+        }
+
+        ~Local()
+        {
+          Release();
+        }
+
+        void Release()
+        // Release tables, and remove them from statistics.
+        {
+          MemoTableCounters& counters = Counters();
+          counters.entries.fetch_sub(cache.size(),std::memory_order_relaxed);
+          counters.bytes.fetch_sub(cache.bytes(),std::memory_order_relaxed);
+          cache.clear();
+        }
+
+        void Synchronize()
+        {
+          const long current_generation = g_cache_generation.load(std::memory_order_relaxed);
+          if (generation!=current_generation)
+            {
+              Release();
+              generation = current_generation;
+            }
+          const std::size_t budget = g_cache_budget.load(std::memory_order_relaxed);
+          if (cache.byte_budget()!=budget)
+            {
+              MemoTableCounters& counters = Counters();
+              const long evictions = cache.evictions(), entries = cache.size(), bytes = cache.bytes();
+              cache.set_byte_budget(budget);
+              counters.evictions.fetch_add(cache.evictions()-evictions,std::memory_order_relaxed);
+              counters.entries.fetch_add(long(cache.size())-entries,std::memory_order_relaxed);
+              counters.bytes.fetch_add(long(cache.bytes())-bytes,std::memory_order_relaxed);
+            }
+        }
+
+        u3::BoundedCoefCache<tLabels,Entry> cache;
+        long generation;
+      };
+
+      static Local& GetLocal()
+      {
+        static thread_local Local local;
+        return local;
+      }
+
+      static MemoTableCounters& Counters()
+      {
+        static MemoTableCounters counters;
+        return counters;
+      }
+    };
+
+    struct SU3CouplingLabels
+    {
+      SU3CouplingLabels(const u3::SU3& x1_, const u3::SU3& x2_, const u3::SU3& x3_)
+        : x1(x1_), x2(x2_), x3(x3_)
+      {}
+
+      inline friend bool operator == (const SU3CouplingLabels& labels1, const SU3CouplingLabels& labels2)
+      {
+        return (labels1.x1==labels2.x1) && (labels1.x2==labels2.x2) && (labels1.x3==labels2.x3);
+      }
+
+      inline friend std::size_t hash_value(const SU3CouplingLabels& labels)
+      {
+        std::size_t seed = PackedHash(labels.x1.PackedKey());
+        seed = PackedHashCombine(seed,labels.x2.PackedKey());
+        seed = PackedHashCombine(seed,labels.x3.PackedKey());
+        return seed;
+      }
+
+      u3::SU3 x1, x2, x3;
+    };
+
+    struct ExtremalCoupling;
+    template <WSource tSource> struct WCoefs;
+
+    typedef MemoTable<u3::SU3,GTIrrep> IrrepTable;
+    typedef MemoTable<CGLabels,CGTable> CGMemoTable;
+    typedef MemoTable<SU3CouplingLabels,ExtremalCoupling> ExtremalTable;
+    typedef MemoTable<u3::WCoefLabels,WCoefs<WSource::kSu3lib>> Su3libWTable;
+    typedef MemoTable<u3::WCoefLabels,WCoefs<WSource::kNative>> NativeWTable;
+
+    static std::shared_ptr<const GTIrrep> GetIrrep(const u3::SU3& x)
+    {
+      return IrrepTable::Get(x);
+    }
+
+    static std::shared_ptr<const CGTable> GetCG(int tj1, int tj2, int tj3)
+    {
+      return CGMemoTable::Get(CGLabels(tj1,tj2,tj3));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // extremal states of coupled irrep
+    ////////////////////////////////////////////////////////////////
+
+    // The extremal state of x3 rho in x1 x x2, in a given U(2) irrep
+    // [m12,m22] of x3 (the state of maximal M within that irrep), is
+    // expanded as
+    //
+    //   |x3 rho; E> = sum_{u1,u2} X_rho(u1,u2) [|x1 u1> x |x2 u2>]^(Lambda3)
+    //
+    // over pairs of U(2) irreps u1 of x1 and u2 of x2, with n_0
+    // adding to that of the extremal state of x3 (shifted to the
+    // same U(3) irrep), coupled by SU(2) Clebsch-Gordan coefficients.
+    //
+    // Two such U(2) irreps of x3 are used: the U(2) irrep of maximal
+    // n_0, [mu3,0], and that of minimal n_0, [lambda3+mu3,mu3], which
+    // contains the highest weight state.  Terms are stored in order of
+    // n_0 of x1, starting from the same extremal n_0 for x1 (decreasing
+    // for maximal n_0, increasing for minimal n_0), then decreasing
+    // lexicographic order of [m12,m22] of x1 and then x2.  For minimal
+    // n_0, the first terms are thus those with x1 in its highest
+    // weight U(2) irrep [lambda1+mu1,mu1], in order of decreasing
+    // Lambda2.
+
+    typedef std::vector<std::array<int,4>> ExtremalTerms;
+
+    static void ExtremalSolutions(
+        const SU3CouplingLabels& labels, bool maximal,
+        ExtremalTerms& terms, std::vector<double>& basis
+      )
+    // Find orthonormal basis for extremal coefficients X.
+    //
+    // The extremal coefficients are determined by the condition that
+    // the coupled state be annihilated by E31, for the maximal n_0
+    // extremal state, or by E23, for the minimal n_0 extremal state
+    // (which, for a U(2) highest weight state, implies annihilation
+    // by E32 or E13, respectively).  The condition operator shifts n_0
+    // of one factor by one, so the condition on the components of
+    // given n_0 of x1 connects two adjacent layers of terms.  The
+    // solutions are therefore found by recursion over these layers,
+    // in order of storage, maintaining an orthonormal basis for the
+    // solutions of the conditions imposed so far.
+    //
+    // Arguments:
+    //   labels (SU3CouplingLabels): (x1,x2,x3)
+    //   maximal (bool): whether to expand extremal state of maximal
+    //     (or else minimal) n_0
+    //   terms (ExtremalTerms, output): U(2) irreps [m12,m22] of x1 and
+    //     x2 for each term
+    //   basis (std::vector<double>, output): basis, indexed by
+    //     term*rho_max+(solution-1)
+    //
+    // Aborts if the number of solutions is not the outer multiplicity.
+    {
+      const int rho_max = u3::OuterMultiplicity(labels.x1,labels.x2,labels.x3);
+      std::shared_ptr<const GTIrrep> irrep1 = GetIrrep(labels.x1);
+      std::shared_ptr<const GTIrrep> irrep2 = GetIrrep(labels.x2);
+      std::shared_ptr<const GTIrrep> irrep3 = GetIrrep(labels.x3);
+      const int dim2 = irrep2->dim();
+
+      // condition operator, and its shift of n_0
+      const std::vector<SparseColumn>& op1 = maximal ? irrep1->e31 : irrep1->e23;
+      const std::vector<SparseColumn>& op2 = maximal ? irrep2->e31 : irrep2->e23;
+      const int step = maximal ? 1 : -1;
+
+      // U(3) shift of x3, so that x3 lies in the U(3) product
+      const int N1 = irrep1->f1+irrep1->f2, N2 = irrep2->f1+irrep2->f2;
+      const int N3 = irrep3->f1+irrep3->f2;
+      const int shift = (N1+N2-N3)/3;
+      const int m12_3 = maximal ? irrep3->f2 : irrep3->f1;
+      const int m22_3 = maximal ? 0 : irrep3->f2;
+      const int t3 = m12_3-m22_3;
+      const int n0 = N3-m12_3-m22_3+shift;
+
+      // enumerate terms, by layer
+      terms.clear();
+      std::vector<int> layer_begin;
+      for (int n01=(maximal ? irrep1->f1 : 0); (n01>=0)&&(n01<=irrep1->f1); n01-=step)
+        {
+          layer_begin.push_back(terms.size());
+          const int n02 = n0-n01;
+          if ((n02<0)||(n02>irrep2->f1))
+            continue;
+          for (int m12_1=irrep1->f1; m12_1>=irrep1->f2; --m12_1)
+            {
+              const int m22_1 = N1-n01-m12_1;
+              if ((m22_1<0)||(m22_1>irrep1->f2))
+                continue;
+              for (int m12_2=irrep2->f1; m12_2>=irrep2->f2; --m12_2)
+                {
+                  const int m22_2 = N2-n02-m12_2;
+                  if ((m22_2<0)||(m22_2>irrep2->f2))
+                    continue;
+                  const int t1 = m12_1-m22_1, t2 = m12_2-m22_2;
+                  if ((t3<std::abs(t1-t2))||(t3>t1+t2))
+                    continue;
+                  terms.push_back({m12_1,m22_1,m12_2,m22_2});
+                }
+            }
+        }
+      const int num_layers = layer_begin.size();
+      layer_begin.push_back(terms.size());
+
+      // image of term under condition operator acting on factor 1 or 2, as
+      // (product state,value), with product states keyed by
+      // pattern1*dim2+pattern2
+      auto image = [&](int term, int factor)
+        {
+          std::vector<std::pair<long,double>> result;
+          const std::array<int,4>& u = terms[term];
+          const int t1 = u[0]-u[1], t2 = u[2]-u[3];
+          std::shared_ptr<const CGTable> cg = GetCG(t1,t2,t3);
+          for (int M1=-t1; M1<=t1; M1+=2)
+            {
+              const int M2 = t3-M1;
+              if (std::abs(M2)>t2)
+                continue;
+              const double coef = (*cg)(M1,t3);
+              const int pattern1 = irrep1->PatternIndexM(u[0],u[1],M1);
+              const int pattern2 = irrep2->PatternIndexM(u[2],u[3],M2);
+              if (factor==1)
+                for (const auto& row_value : op1[pattern1])
+                  result.emplace_back(long(row_value.first)*dim2+pattern2,coef*row_value.second);
+              else
+                for (const auto& row_value : op2[pattern2])
+                  result.emplace_back(long(pattern1)*dim2+row_value.first,coef*row_value.second);
+            }
+          return result;
+        };
+
+      // recursion over layers
+      //
+      // At each step, the conditions are imposed on the components
+      // with n_0 of x1 equal to that of the previous layer, which
+      // involve the previous layer (through the operator on x2) and
+      // the new layer (through the operator on x1).  The unknowns are the coefficients
+      // c of the solutions found so far (basis, with num_solutions
+      // columns, on the terms of earlier layers) and the coefficients
+      // y of the terms of the new layer.  The orthonormal null space
+      // of the conditions, in (c,y), then gives an orthonormal basis
+      // for the solutions on the terms up to the new layer.
+      basis.clear();  // num_processed x num_solutions
+      int num_solutions = 0;
+      for (int layer=0; layer<=num_layers; ++layer)
+        {
+          const int previous_begin = (layer>0) ? layer_begin[layer-1] : 0;
+          const int new_begin = layer_begin[layer];
+          const int new_end = (layer<num_layers) ? layer_begin[layer+1] : new_begin;
+          const int num_new = new_end-new_begin;
+          const int num_unknowns = num_solutions+num_new;
+          if (num_unknowns==0)
+            continue;
+
+          // conditions, as dense rows on unknowns, keyed by component
+          std::unordered_map<long,std::vector<double>> conditions;
+          for (int term=previous_begin; term<new_begin; ++term)
+            for (const auto& key_value : image(term,2))
+              {
+                std::vector<double>& row = conditions[key_value.first];
+                row.resize(num_unknowns,0.);
+                for (int solution=0; solution<num_solutions; ++solution)
+                  row[solution] += key_value.second*basis[term*num_solutions+solution];
+              }
+          for (int term=new_begin; term<new_end; ++term)
+            for (const auto& key_value : image(term,1))
+              {
+                std::vector<double>& row = conditions[key_value.first];
+                row.resize(num_unknowns,0.);
+                row[num_solutions+(term-new_begin)] += key_value.second;
+              }
+
+          // null space, from eigensystem of A^T A
+          std::vector<double> gram(num_unknowns*num_unknowns,0.);
+          for (const auto& key_row : conditions)
+            {
+              const std::vector<double>& row = key_row.second;
+              for (int i=0; i<num_unknowns; ++i)
+                if (row[i]!=0.)
+                  for (int j=0; j<num_unknowns; ++j)
+                    gram[i*num_unknowns+j] += row[i]*row[j];
+            }
+          std::vector<double> eigenvalues, eigenvectors;
+          SymmetricEigensystem(num_unknowns,gram,eigenvalues,eigenvectors);
+          const double scale = std::max(1.,*std::max_element(eigenvalues.begin(),eigenvalues.end()));
+          std::vector<int> null_columns;
+          for (int k=0; k<num_unknowns; ++k)
+            if (std::abs(eigenvalues[k])<1e-9*scale)
+              null_columns.push_back(k);
+
+          // extend basis to new layer
+          const int num_null = null_columns.size();
+          std::vector<double> new_basis(new_end*num_null,0.);
+          for (int term=0; term<new_begin; ++term)
+            for (int k=0; k<num_null; ++k)
+              for (int solution=0; solution<num_solutions; ++solution)
+                new_basis[term*num_null+k]
+                  += basis[term*num_solutions+solution]*eigenvectors[solution*num_unknowns+null_columns[k]];
+          for (int term=new_begin; term<new_end; ++term)
+            for (int k=0; k<num_null; ++k)
+              new_basis[term*num_null+k]
+                = eigenvectors[(num_solutions+(term-new_begin))*num_unknowns+null_columns[k]];
+          basis = std::move(new_basis);
+          num_solutions = num_null;
+        }
+      if (num_solutions!=rho_max)
+        {
+          std::cerr << "ERROR: u3::native: extremal space of dimension " << num_solutions
+                    << " for outer multiplicity " << rho_max << " in "
+                    << labels.x1.Str() << " x " << labels.x2.Str() << " -> " << labels.x3.Str() << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+    }
+
+    static std::vector<double> ResolveMultiplicity(
+        int num_terms, int rho_max, const std::vector<double>& basis
+      )
+    // Resolve outer multiplicity, by Gram-Schmidt on projections of
+    // terms onto solution space, in order of terms, with the phase
+    // such that the coefficient of the first contributing term is
+    // positive.
+    //
+    // In solution space coordinates, the projection of a term is its
+    // row of the basis.
+    //
+    // Arguments:
+    //   num_terms, rho_max (int): dimensions of basis
+    //   basis (std::vector<double>): basis, as from ExtremalSolutions
+    //
+    // Returns:
+    //   (std::vector<double>): coefficients X, indexed by
+    //     (rho-1)*num_terms+term
+    {
+      std::vector<std::vector<double>> solutions;
+      for (int term=0; (term<num_terms)&&(int(solutions.size())<rho_max); ++term)
+        {
+          std::vector<double> solution(basis.begin()+term*rho_max,basis.begin()+(term+1)*rho_max);
+          for (const std::vector<double>& previous : solutions)
+            {
+              double overlap = 0.;
+              for (int k=0; k<rho_max; ++k)
+                overlap += previous[k]*solution[k];
+              for (int k=0; k<rho_max; ++k)
+                solution[k] -= overlap*previous[k];
+            }
+          double norm = 0.;
+          for (double value : solution)
+            norm += value*value;
+          norm = std::sqrt(norm);
+          if (norm<1e-6)
+            continue;
+          for (double& value : solution)
+            value /= norm;
+          solutions.push_back(std::move(solution));
+        }
+      std::vector<double> coefs(rho_max*num_terms,0.);
+      for (int rho=1; rho<=rho_max; ++rho)
+        for (int term=0; term<num_terms; ++term)
+          for (int k=0; k<rho_max; ++k)
+            coefs[(rho-1)*num_terms+term] += basis[term*rho_max+k]*solutions[rho-1][k];
+      return coefs;
+    }
+
+    static void ExtremalOverlaps(
+        const GTIrrep& irrep1, int L1, const GTIrrep& irrep2, int L2, int L3,
+        int m12_3, int m22_3, const ExtremalTerms& terms, const std::vector<double>& coefs, int rho_max,
+        std::vector<double>& overlaps
+      )
+    // Calculate overlaps of SO(3) coupled product states with
+    // extremal states of x3 (in U(2) irrep [m12_3,m22_3]), for M=K,
+    //
+    //   G_K(k1,k2)_rho = <(x1 k1 L1; x2 k2 L2) L3 K|x3 rho; E K>
+    //     = sum <L1 M1; L2 M2|L3 K> <x1 k1 L1 M1|x1 u1 M1> <x2 k2 L2 M2|x2 u2 M2>
+    //         <Lambda1 M1/2; Lambda2 M2/2|Lambda3 K/2> X_rho(u1,u2)
+    //
+    // Arguments:
+    //   irrep1, L1, irrep2, L2, L3: SO(3) coupled product states
+    //   m12_3, m22_3 (int): U(2) irrep of extremal states
+    //   terms, coefs, rho_max: expansion of extremal states (coefs
+    //     indexed by (rho-1)*terms.size()+term)
+    //   overlaps (std::vector<double>, output): overlaps, indexed by
+    //     (((K+t3)/2*rho_max+(rho-1))*kappa2_max+(kappa2-1))*kappa1_max+(kappa1-1)
+    {
+      const int kappa1_max = irrep1.kappa_max[L1], kappa2_max = irrep2.kappa_max[L2];
+      const int t3 = m12_3-m22_3;
+      const int num_K = t3+1;
+      const int num_terms = terms.size();
+      std::shared_ptr<const CGTable> so3_cg = GetCG(2*L1,2*L2,2*L3);
+      overlaps.assign(num_K*rho_max*kappa2_max*kappa1_max,0.);
+      for (int term=0; term<num_terms; ++term)
+        {
+          const std::array<int,4>& u = terms[term];
+          const int t1 = u[0]-u[1], t2 = u[2]-u[3];
+          std::shared_ptr<const CGTable> su2_cg = GetCG(t1,t2,t3);
+          for (int M1=-std::min(t1,L1); M1<=std::min(t1,L1); ++M1)
+            {
+              if ((M1+t1)%2)
+                continue;
+              const int position1 = irrep1.m_position[irrep1.PatternIndexM(u[0],u[1],M1)];
+              for (int M2=-std::min(t2,L2); M2<=std::min(t2,L2); ++M2)
+                {
+                  const int K = M1+M2;
+                  if (((M2+t2)%2)||(std::abs(K)>std::min(t3,L3)))
+                    continue;
+                  const double coef = (*su2_cg)(M1,K)*(*so3_cg)(2*M1,2*K);
+                  if (coef==0.)
+                    continue;
+                  const int position2 = irrep2.m_position[irrep2.PatternIndexM(u[2],u[3],M2)];
+                  for (int rho=1; rho<=rho_max; ++rho)
+                    {
+                      const double factor = coef*coefs[(rho-1)*num_terms+term];
+                      if (factor==0.)
+                        continue;
+                      double* overlap = &overlaps[(((K+t3)/2)*rho_max+(rho-1))*kappa2_max*kappa1_max];
+                      for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+                        {
+                          const double factor2 = factor*irrep2.State(L2,kappa2,M2)[position2];
+                          for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+                            overlap[(kappa2-1)*kappa1_max+(kappa1-1)]
+                              += factor2*irrep1.State(L1,kappa1,M1)[position1];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    static void SolveW(
+        const GTIrrep& irrep3, int L3, const std::vector<double>& overlaps,
+        const u3::WMultiplicityTuple& multiplicities, std::vector<double>& block
+      )
+    // Obtain W coefficients from overlaps with the extremal states of
+    // x3 (in its Vergados extremal U(2) irrep).
+    //
+    // Expanding the extremal states in the Vergados basis of x3,
+    //
+    //   G_K(k1,k2)_rho = sum_k3 <x3 k3 L3 K|x3 E K> W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho,
+    //
+    // which is solved for W by the left inverse of the overlaps.
+    {
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+      const int num_K = irrep3.extremal_t()+1;
+      const std::vector<double>& inverse = irrep3.extremal_inverse[L3];
+      block.assign(kappa1_max*kappa2_max*kappa3_max*rho_max,0.);
+      for (int rho=1; rho<=rho_max; ++rho)
+        for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+          for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+            for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+              {
+                double coef = 0.;
+                for (int k=0; k<num_K; ++k)
+                  coef += inverse[(kappa3-1)*num_K+k]
+                    *overlaps[((k*rho_max+(rho-1))*kappa2_max+(kappa2-1))*kappa1_max+(kappa1-1)];
+                block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)] = coef;
+              }
+    }
+
+    struct ExtremalCoupling
+    // Extremal states of x3 rho in x1 x x2, in the Vergados extremal
+    // U(2) irrep of x3 (see GTIrrep), with the outer multiplicity
+    // resolved following Draayer and Akiyama.
+    //
+    // For lambda3<mu3, the copies of x3 are defined by their highest
+    // weight states, which are also the Vergados extremal states, by
+    // ResolveMultiplicity on the expansion of the minimal n_0
+    // extremal state.  Otherwise, the expansion of the maximal n_0
+    // extremal state is found for an arbitrary orthonormal basis of
+    // copies, which is then rotated onto the copies defined either
+    // through the conjugate coupling or by their highest weight
+    // states (see the conventions in u3coef_native.h).  The rotation
+    // is found by least squares, from the W coefficients of the
+    // conjugate coupling, or from the overlaps of the highest weight
+    // extremal states with SO(3) coupled product states (see
+    // ExtremalOverlaps), which for the same copy are related through
+    // the Vergados states of x3.
+    {
+      ExtremalCoupling() : rho_max(0) {}
+
+      explicit ExtremalCoupling(const SU3CouplingLabels& labels);
+
+      int rho_max;
+
+      // U(2) irreps [m12,m22] of x1 and x2 for each term
+      ExtremalTerms terms;
+
+      // coefficients X, indexed by (rho-1)*terms.size()+term
+      std::vector<double> coefs;
+
+      std::size_t size() const
+      {
+        return coefs.size()+2*terms.size();
+      }
+    };
+
+    ExtremalCoupling::ExtremalCoupling(const SU3CouplingLabels& labels)
+    {
+      rho_max = u3::OuterMultiplicity(labels.x1,labels.x2,labels.x3);
+      if (rho_max==0)
+        return;
+      const bool maximal = (labels.x3.lambda()>=labels.x3.mu());
+      std::vector<double> basis;
+      ExtremalSolutions(labels,maximal,terms,basis);
+      const int num_terms = terms.size();
+      if (!maximal)
+        {
+          coefs = ResolveMultiplicity(num_terms,rho_max,basis);
+          return;
+        }
+
+      // arbitrary copies, in coefficient layout
+      std::vector<double> basis_coefs(rho_max*num_terms);
+      for (int term=0; term<num_terms; ++term)
+        for (int k=0; k<rho_max; ++k)
+          basis_coefs[k*num_terms+term] = basis[term*rho_max+k];
+
+      // target copies
+      //
+      // For lambda3>mu3, the copies are defined through the conjugate
+      // coupling (with lambda3<mu3), by the conjugation relation
+      //
+      //   W(x1~ k1 L1; x2~ k2 L2 || x3~ k3 L3)_rho
+      //     = (-1)^(lambda1+mu1+lambda2+mu2-lambda3-mu3+L1+L2-L3+rho_max-rho)
+      //       W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho,
+      //
+      // imposed on blocks in which no irrep is self-conjugate with
+      // SO(3) multiplicity.  For
+      // lambda3=mu3, the same applies if (x1~,x2~) precedes (x1,x2),
+      // so that the conjugate coupling is not itself so defined, and
+      // otherwise the copies are defined by their highest weight
+      // states.
+      const u3::SU3 conjugate_x1 = u3::Conjugate(labels.x1), conjugate_x2 = u3::Conjugate(labels.x2);
+      const bool by_highest_weight
+        = (labels.x3.lambda()==labels.x3.mu())
+        &&!(std::tie(conjugate_x1,conjugate_x2)<std::tie(labels.x1,labels.x2));
+      ExtremalTerms hw_terms;
+      std::vector<double> hw_coefs;
+      if (by_highest_weight)
+        {
+          std::vector<double> hw_basis;
+          ExtremalSolutions(labels,false,hw_terms,hw_basis);
+          hw_coefs = ResolveMultiplicity(hw_terms.size(),rho_max,hw_basis);
+        }
+      std::unique_ptr<ExtremalCoupling> conjugate;
+      std::shared_ptr<const GTIrrep> conjugate_irrep1, conjugate_irrep2, conjugate_irrep3;
+      if (!by_highest_weight)
+        {
+          const SU3CouplingLabels conjugate_labels(conjugate_x1,conjugate_x2,u3::Conjugate(labels.x3));
+          conjugate.reset(new ExtremalCoupling(conjugate_labels));
+          conjugate_irrep1 = GetIrrep(conjugate_labels.x1);
+          conjugate_irrep2 = GetIrrep(conjugate_labels.x2);
+          conjugate_irrep3 = GetIrrep(conjugate_labels.x3);
+        }
+      auto ambiguous = [](const u3::SU3& x, int kappa_max)
+        {
+          return (x.lambda()==x.mu())&&(kappa_max>1);
+        };
+      const int phase_base = labels.x1.lambda()+labels.x1.mu()+labels.x2.lambda()+labels.x2.mu()
+        -labels.x3.lambda()-labels.x3.mu()+rho_max;
+
+      // least squares for rotation R, from
+      //
+      //   target_rho = sum_rho' predicted_rho' R_{rho' rho},
+      //
+      // with predicted values for the arbitrary copies, accumulated
+      // over (L1,L2,L3) until the normal equations are well
+      // conditioned
+      std::shared_ptr<const GTIrrep> irrep1 = GetIrrep(labels.x1);
+      std::shared_ptr<const GTIrrep> irrep2 = GetIrrep(labels.x2);
+      std::shared_ptr<const GTIrrep> irrep3 = GetIrrep(labels.x3);
+      const int t_hw = irrep3->f1-irrep3->f2;
+      std::vector<double> normal(rho_max*rho_max,0.), rhs(rho_max*rho_max,0.);
+      std::vector<double> overlaps, hw_overlaps, block, conjugate_block;
+      std::vector<double> predicted(rho_max), target(rho_max), eigenvalues, eigenvectors;
+      auto accumulate = [&]()
+        {
+          for (int rhop=0; rhop<rho_max; ++rhop)
+            for (int rho=0; rho<rho_max; ++rho)
+              {
+                normal[rhop*rho_max+rho] += predicted[rhop]*predicted[rho];
+                rhs[rhop*rho_max+rho] += predicted[rhop]*target[rho];
+              }
+        };
+      bool conditioned = false;
+      for (const MultiplicityTagged<int>& L3_kappa : u3::BranchingSO3(labels.x3))
+        for (const MultiplicityTagged<int>& L1_kappa : u3::BranchingSO3(labels.x1))
+          for (const MultiplicityTagged<int>& L2_kappa : u3::BranchingSO3(labels.x2))
+            {
+              const int L1 = L1_kappa.irrep, L2 = L2_kappa.irrep, L3 = L3_kappa.irrep;
+              if (conditioned||(L3<std::abs(L1-L2))||(L3>L1+L2))
+                continue;
+              const int kappa1_max = L1_kappa.tag, kappa2_max = L2_kappa.tag, kappa3_max = L3_kappa.tag;
+              if (
+                  !by_highest_weight
+                  &&(ambiguous(labels.x1,kappa1_max)||ambiguous(labels.x2,kappa2_max)||ambiguous(labels.x3,kappa3_max))
+                )
+                continue;
+              const u3::WMultiplicityTuple multiplicities(kappa1_max,kappa2_max,kappa3_max,rho_max);
+              ExtremalOverlaps(
+                  *irrep1,L1,*irrep2,L2,L3,
+                  irrep3->extremal_m12,irrep3->extremal_m22,terms,basis_coefs,rho_max,overlaps
+                );
+              SolveW(*irrep3,L3,overlaps,multiplicities,block);
+              if (by_highest_weight)
+                {
+                  ExtremalOverlaps(
+                      *irrep1,L1,*irrep2,L2,L3,
+                      irrep3->f1,irrep3->f2,hw_terms,hw_coefs,rho_max,hw_overlaps
+                    );
+                  for (int K=-std::min(t_hw,L3); K<=std::min(t_hw,L3); ++K)
+                    {
+                      if ((K+t_hw)%2)
+                        continue;
+                      const int position = irrep3->m_position[irrep3->PatternIndexM(irrep3->f1,irrep3->f2,K)];
+                      for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+                        for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+                          {
+                            for (int rho=1; rho<=rho_max; ++rho)
+                              {
+                                double value = 0.;
+                                for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+                                  value += irrep3->State(L3,kappa3,K)[position]
+                                    *block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)];
+                                predicted[rho-1] = value;
+                                target[rho-1] = hw_overlaps[
+                                    ((((K+t_hw)/2)*rho_max+(rho-1))*kappa2_max+(kappa2-1))*kappa1_max+(kappa1-1)
+                                  ];
+                              }
+                            accumulate();
+                          }
+                    }
+                }
+              else
+                {
+                  ExtremalOverlaps(
+                      *conjugate_irrep1,L1,*conjugate_irrep2,L2,L3,
+                      conjugate_irrep3->extremal_m12,conjugate_irrep3->extremal_m22,
+                      conjugate->terms,conjugate->coefs,rho_max,overlaps
+                    );
+                  SolveW(*conjugate_irrep3,L3,overlaps,multiplicities,conjugate_block);
+                  for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+                    for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+                      for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+                        {
+                          for (int rho=1; rho<=rho_max; ++rho)
+                            {
+                              const int index = u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho);
+                              const double phase = ((phase_base+L1+L2-L3-rho)%2) ? -1. : 1.;
+                              predicted[rho-1] = block[index];
+                              target[rho-1] = phase*conjugate_block[index];
+                            }
+                          accumulate();
+                        }
+                }
+              std::vector<double> matrix = normal;
+              SymmetricEigensystem(rho_max,matrix,eigenvalues,eigenvectors);
+              const double eigenvalue_min = *std::min_element(eigenvalues.begin(),eigenvalues.end());
+              const double eigenvalue_max = *std::max_element(eigenvalues.begin(),eigenvalues.end());
+              conditioned = (eigenvalue_min>1e-2*eigenvalue_max)&&(eigenvalue_min>1e-6);
+            }
+
+      // rotate copies, after checking that rotation is orthogonal
+      bool orthogonal = CholeskySolve(rho_max,normal,rho_max,rhs);
+      for (int rho=0; orthogonal&&(rho<rho_max); ++rho)
+        for (int rhop=0; rhop<rho_max; ++rhop)
+          {
+            double product = 0.;
+            for (int k=0; k<rho_max; ++k)
+              product += rhs[k*rho_max+rho]*rhs[k*rho_max+rhop];
+            orthogonal &= (std::abs(product-((rho==rhop) ? 1. : 0.))<1e-8);
+          }
+      if (!orthogonal)
+        {
+          std::cerr << "ERROR: u3::native: failed to relate extremal states to highest weight states in "
+                    << labels.x1.Str() << " x " << labels.x2.Str() << " -> " << labels.x3.Str() << std::endl;
+          std::exit(EXIT_FAILURE);
+        }
+      coefs.assign(rho_max*num_terms,0.);
+      for (int rho=0; rho<rho_max; ++rho)
+        for (int term=0; term<num_terms; ++term)
+          for (int k=0; k<rho_max; ++k)
+            coefs[rho*num_terms+term] += basis_coefs[k*num_terms+term]*rhs[k*rho_max+rho];
+    }
+
+    static std::shared_ptr<const ExtremalCoupling> GetExtremalCoupling(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3
+      )
+    {
+      return ExtremalTable::Get(SU3CouplingLabels(x1,x2,x3));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // memo table control
+    ////////////////////////////////////////////////////////////////
+
+    void SetCacheBudget(std::size_t byte_budget)
+    {
+      g_cache_budget.store(byte_budget);
+      IrrepTable::Synchronize();
+      CGMemoTable::Synchronize();
+      ExtremalTable::Synchronize();
+      Su3libWTable::Synchronize();
+      NativeWTable::Synchronize();
+    }
+
+    void ClearCaches()
+    {
+      g_cache_generation.fetch_add(1);
+      IrrepTable::Synchronize();
+      CGMemoTable::Synchronize();
+      ExtremalTable::Synchronize();
+      Su3libWTable::Synchronize();
+      NativeWTable::Synchronize();
+    }
+
+    void CacheReport(std::ostream& os)
+    {
+      IrrepTable::Report(os,"irrep");
+      CGMemoTable::Report(os,"cg");
+      ExtremalTable::Report(os,"extremal");
+      Su3libWTable::Report(os,"su3lib_w");
+      NativeWTable::Report(os,"w");
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Wigner coefficients
+    ////////////////////////////////////////////////////////////////
+
+    u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      )
+    {
+      u3::WMultiplicityTuple multiplicities = u3::WMultiplicity(x1,L1,x2,L2,x3,L3);
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+      block.assign(kappa1_max*kappa2_max*kappa3_max*rho_max,0.);
+      if (block.empty())
+        return multiplicities;
+
+      std::shared_ptr<const GTIrrep> irrep1 = GetIrrep(x1);
+      std::shared_ptr<const GTIrrep> irrep2 = GetIrrep(x2);
+      std::shared_ptr<const GTIrrep> irrep3 = GetIrrep(x3);
+      std::shared_ptr<const ExtremalCoupling> coupling = GetExtremalCoupling(x1,x2,x3);
+      std::vector<double> overlaps;
+      ExtremalOverlaps(
+          *irrep1,L1,*irrep2,L2,L3,
+          irrep3->extremal_m12,irrep3->extremal_m22,coupling->terms,coupling->coefs,rho_max,overlaps
+        );
+      SolveW(*irrep3,L3,overlaps,multiplicities,block);
+      return multiplicities;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // Racah recoupling coefficients
+    ////////////////////////////////////////////////////////////////
+
+    template <WSource tSource>
+    struct WCoefs
+    // Block of W coefficients from given source, memoized for
+    // recoupling.
+    {
+      WCoefs() {}
+
+      explicit WCoefs(const u3::WCoefLabels& labels)
+      {
+        u3::SU3 x1, x2, x3;
+        int L1, L2, L3;
+        std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+        if (tSource==WSource::kSu3lib)
+          multiplicities = u3::Su3libWBlock(x1,L1,x2,L2,x3,L3,coefs);
+        else
+          multiplicities = native::WBlock(x1,L1,x2,L2,x3,L3,coefs);
+      }
+
+      u3::WMultiplicityTuple multiplicities;
+      std::vector<double> coefs;
+
+      std::size_t size() const
+      {
+        return coefs.size();
+      }
+    };
+
+    template <WSource tSource>
+    static std::shared_ptr<const WCoefs<tSource>> GetW(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3
+      )
+    {
+      return MemoTable<u3::WCoefLabels,WCoefs<tSource>>::Get(u3::WCoefLabels(x1,L1,x2,L2,x3,L3));
+    }
+
+    static bool SO3Triangle(int L1, int L2, int L3)
+    {
+      return (L3>=std::abs(L1-L2))&&(L3<=L1+L2);
+    }
+
+    template <WSource tSource>
+    static u3::UMultiplicityTuple UZBlockFromW(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block
+      )
+    // Calculate U or Z block from W coefficients of given source.
+    //
+    // The coefficients are obtained by the standard sum over W
+    // coefficients, for the SO(3) state kappa=1 L of x of lowest L,
+    //
+    //   U = sum W(x1 k1 L1; x2 k2 L2 || x12 k12 L12)_r12 W(x12 k12 L12; x3 k3 L3 || x 1 L)_r12_3
+    //         W(x2 k2 L2; x3 k3 L3 || x23 k23 L23)_r23 W(x1 k1 L1; x23 k23 L23 || x 1 L)_r1_23
+    //         U(L1 L2 L L3; L12 L23),
+    //
+    // or, for Z, with W(x23 k23 L23; x1 k1 L1 || x 1 L)_r1_23 and the
+    // additional SO(3) exchange phase (-)^(L1+L23-L).  The sums over
+    // k12 and k23 are carried out first, for each L1 L2 L3.
+    {
+      int r12_max, r12_3_max, r23_max, r1_23_max;
+      u3::UMultiplicityTuple multiplicities = u3::UMultiplicity(x1,x2,x,x3,x12,x23);
+      std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = multiplicities;
+      block.assign(r12_max*r12_3_max*r23_max*r1_23_max,0.);
+      if (block.empty())
+        return multiplicities;
+
+      const int L = u3::BranchingSO3(x)[0].irrep;
+      const MultiplicityTagged<int>::vector L1_set = u3::BranchingSO3(x1);
+      const MultiplicityTagged<int>::vector L2_set = u3::BranchingSO3(x2);
+      const MultiplicityTagged<int>::vector L3_set = u3::BranchingSO3(x3);
+      const MultiplicityTagged<int>::vector L12_set = u3::BranchingSO3(x12);
+      const MultiplicityTagged<int>::vector L23_set = u3::BranchingSO3(x23);
+      const int num12 = r12_max*r12_3_max, num23 = r23_max*r1_23_max;
+
+      std::vector<std::vector<double>> sums12(L12_set.size()), sums23(L23_set.size());
+      for (const MultiplicityTagged<int>& L1_tagged : L1_set)
+        for (const MultiplicityTagged<int>& L2_tagged : L2_set)
+          for (const MultiplicityTagged<int>& L3_tagged : L3_set)
+            {
+              const int L1 = L1_tagged.irrep, L2 = L2_tagged.irrep, L3 = L3_tagged.irrep;
+              const int kappa1_max = L1_tagged.tag, kappa2_max = L2_tagged.tag, kappa3_max = L3_tagged.tag;
+              const int num_kappa = kappa1_max*kappa2_max*kappa3_max;
+
+              // sums over k12, indexed by
+              // (((k3-1)*k2_max+(k2-1))*k1_max+(k1-1))*num12+(r12_3-1)*r12_max+(r12-1)
+              for (int i12=0; i12<int(L12_set.size()); ++i12)
+                {
+                  const int L12 = L12_set[i12].irrep, kappa12_max = L12_set[i12].tag;
+                  std::vector<double>& sums = sums12[i12];
+                  sums.clear();
+                  if (!(SO3Triangle(L1,L2,L12)&&SO3Triangle(L12,L3,L)))
+                    continue;
+                  std::shared_ptr<const WCoefs<tSource>> w12 = GetW<tSource>(x1,L1,x2,L2,x12,L12);
+                  std::shared_ptr<const WCoefs<tSource>> w12_3 = GetW<tSource>(x12,L12,x3,L3,x,L);
+                  sums.assign(num_kappa*num12,0.);
+                  for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+                    for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+                      for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+                        for (int r12_3=1; r12_3<=r12_3_max; ++r12_3)
+                          for (int r12=1; r12<=r12_max; ++r12)
+                            {
+                              double sum = 0.;
+                              for (int kappa12=1; kappa12<=kappa12_max; ++kappa12)
+                                sum += w12->coefs[u3::WBlockIndex(w12->multiplicities,kappa1,kappa2,kappa12,r12)]
+                                  *w12_3->coefs[u3::WBlockIndex(w12_3->multiplicities,kappa12,kappa3,1,r12_3)];
+                              sums[((((kappa3-1)*kappa2_max+(kappa2-1))*kappa1_max+(kappa1-1))*r12_3_max+(r12_3-1))*r12_max+(r12-1)]
+                                = sum;
+                            }
+                }
+
+              // sums over k23, indexed by
+              // (((k3-1)*k2_max+(k2-1))*k1_max+(k1-1))*num23+(r1_23-1)*r23_max+(r23-1)
+              for (int i23=0; i23<int(L23_set.size()); ++i23)
+                {
+                  const int L23 = L23_set[i23].irrep, kappa23_max = L23_set[i23].tag;
+                  std::vector<double>& sums = sums23[i23];
+                  sums.clear();
+                  if (!(SO3Triangle(L2,L3,L23)&&SO3Triangle(L1,L23,L)))
+                    continue;
+                  std::shared_ptr<const WCoefs<tSource>> w23 = GetW<tSource>(x2,L2,x3,L3,x23,L23);
+                  std::shared_ptr<const WCoefs<tSource>> w1_23
+                    = (mode==u3::UZMode::kU)
+                    ? GetW<tSource>(x1,L1,x23,L23,x,L)
+                    : GetW<tSource>(x23,L23,x1,L1,x,L);
+                  sums.assign(num_kappa*num23,0.);
+                  for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+                    for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+                      for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+                        for (int r1_23=1; r1_23<=r1_23_max; ++r1_23)
+                          for (int r23=1; r23<=r23_max; ++r23)
+                            {
+                              double sum = 0.;
+                              for (int kappa23=1; kappa23<=kappa23_max; ++kappa23)
+                                sum += w23->coefs[u3::WBlockIndex(w23->multiplicities,kappa2,kappa3,kappa23,r23)]
+                                  *w1_23->coefs[
+                                      (mode==u3::UZMode::kU)
+                                      ? u3::WBlockIndex(w1_23->multiplicities,kappa1,kappa23,1,r1_23)
+                                      : u3::WBlockIndex(w1_23->multiplicities,kappa23,kappa1,1,r1_23)
+                                    ];
+                              sums[((((kappa3-1)*kappa2_max+(kappa2-1))*kappa1_max+(kappa1-1))*r1_23_max+(r1_23-1))*r23_max+(r23-1)]
+                                = sum;
+                            }
+                }
+
+              // recouple
+              for (int i12=0; i12<int(L12_set.size()); ++i12)
+                for (int i23=0; i23<int(L23_set.size()); ++i23)
+                  {
+                    if (sums12[i12].empty()||sums23[i23].empty())
+                      continue;
+                    const int L12 = L12_set[i12].irrep, L23 = L23_set[i23].irrep;
+                    double so3_coef = am::Unitary6J(L1,L2,L12,L3,L,L23);
+                    if ((mode==u3::UZMode::kZ)&&((L1+L23-L)%2))
+                      so3_coef = -so3_coef;
+                    if (so3_coef==0.)
+                      continue;
+                    for (int kappa=0; kappa<num_kappa; ++kappa)
+                      {
+                        const double* coefs12 = &sums12[i12][kappa*num12];
+                        const double* coefs23 = &sums23[i23][kappa*num23];
+                        for (int r1_23=1; r1_23<=r1_23_max; ++r1_23)
+                          for (int r23=1; r23<=r23_max; ++r23)
+                            {
+                              const double coef23 = so3_coef*coefs23[(r1_23-1)*r23_max+(r23-1)];
+                              if (coef23==0.)
+                                continue;
+                              for (int r12_3=1; r12_3<=r12_3_max; ++r12_3)
+                                for (int r12=1; r12<=r12_max; ++r12)
+                                  block[u3::UZBlockIndex(multiplicities,r12,r12_3,r23,r1_23)]
+                                    += coef23*coefs12[(r12_3-1)*r12_max+(r12-1)];
+                            }
+                      }
+                  }
+            }
+
+      return multiplicities;
+    }
+
+    u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block,
+        WSource w_source
+      )
+    {
+      if (w_source==WSource::kSu3lib)
+        return UZBlockFromW<WSource::kSu3lib>(x1,x2,x,x3,x12,x23,mode,block);
+      else
+        return UZBlockFromW<WSource::kNative>(x1,x2,x,x3,x12,x23,mode,block);
+    }
+
+  }  // namespace
+}  // namespace
@@ -0,0 +1,202 @@
+/****************************************************************
+  u3coef_native.h
+
+  Native C++ evaluation of SU(3) coupling coefficients, as an
+  alternative to su3lib.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created, with SU(3)>SO(3) Wigner coefficients.
+  10/16/26 (mac): Add U and Z recoupling coefficients.
+  10/16/26 (mac): Compute W by extremal-state method, and U and Z by sum over W,
+    with bounded memo tables.
+  10/16/26 (mac): Compute U and Z from su3lib W by default (WSource).
+  10/16/26 (mac): Follow Draayer-Akiyama phase and outer multiplicity
+    conventions for W.
+  10/16/26 (mac): Document U and Z from su3lib W as serialized on su3lib.
+
+****************************************************************/
+
+#ifndef U3COEF_NATIVE_H_
+#define U3COEF_NATIVE_H_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "sp3rlib/u3coef.h"
+
+namespace u3
+{
+  namespace native
+  {
+
+    ////////////////////////////////////////////////////////////////
+    // construction of coefficients
+    ////////////////////////////////////////////////////////////////
+
+    // Coefficients are obtained from the Gelfand-Tsetlin (GT) bases of
+    // the individual irreps, rather than the su3lib routines:
+    //
+    //   - The SU(3) irrep (lambda,mu) is realized as the U(3) irrep
+    //     [lambda+mu,mu,0], in the GT basis for the chain U(3) > U(2)
+    //     > U(1), with the oscillator quanta ordered as (+1,-1,0) in
+    //     spherical components.  The weights are then the occupations
+    //     (n_+1,n_-1,n_0), so that M = n_+1 - n_-1 and n_z = n_0 are
+    //     diagonal.  The generators have the standard GT matrix
+    //     elements (real, with nonnegative raising matrix elements).
+    //     Within each U(2) irrep [m12,m22], the GT states are the
+    //     standard SU(2) states of quasi-spin Lambda = (m12-m22)/2 and
+    //     projection M/2.
+    //
+    //   - The SO(3) basis is the Vergados basis: Elliott states are
+    //     projected from the intrinsic states of good K (the GT states
+    //     of maximal n_z for lambda>=mu, or minimal n_z for
+    //     lambda<mu), and orthonormalized by Gram-Schmidt for each L,
+    //     in order of increasing K.  For lambda<mu, the states carry
+    //     the additional phase (-1)^(L+(lambda-K)/2), as in the
+    //     conjugation relation of Draayer and Akiyama [J. Math. Phys.
+    //     14, 1904 (1973)].
+    //
+    //   - Wigner coefficients are obtained by the extremal-state
+    //     method.  The extremal state of x3 rho in x1 x x2 (the
+    //     intrinsic state of maximal n_z for lambda3>=mu3, or minimal
+    //     n_z for lambda3<mu3) is expanded in U(2)-coupled products of
+    //     the U(2) irreps of x1 and x2, by SU(2) Clebsch-Gordan
+    //     coefficients.  The extremal coefficients of this expansion
+    //     are found by recursion in n_z of x1, from the condition that
+    //     the state be annihilated by the appropriate generators.
+    //
+    //   - The outer multiplicity is resolved following Draayer and
+    //     Akiyama.  For lambda3<mu3, the copies of x3 are defined on
+    //     the highest weight state, by Gram-Schmidt on the projections
+    //     of the terms of its expansion onto the space of solutions,
+    //     in order of recursion (x1 in its highest weight U(2) irrep
+    //     first), with the phase such that the coefficient of the
+    //     first contributing term is positive.  For lambda3>mu3, the
+    //     copies are instead defined through the conjugate coupling,
+    //     by the conjugation relation
+    //
+    //       W(x1~ k1 L1; x2~ k2 L2 || x3~ k3 L3)_rho
+    //         = (-1)^(lambda1+mu1+lambda2+mu2-lambda3-mu3+L1+L2-L3+rho_max-rho)
+    //           W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho,
+    //
+    //     as are those for lambda3=mu3 when (x1~,x2~) precedes
+    //     (x1,x2).  The remaining couplings with lambda3=mu3 are
+    //     resolved on the highest weight state, as for lambda3<mu3.
+    //
+    //   - The SO(3)-reduced Wigner coefficient is then obtained by
+    //     expanding the coupled extremal states (of all M=K in the
+    //     extremal U(2) irrep) in the product SO(3) basis, and solving
+    //     the relation of these expansions to the Vergados states of
+    //     x3, so that only extremal states of x3 are ever constructed.
+    //
+    //   - The U and Z recoupling coefficients are obtained from the
+    //     standard sum over products of four W coefficients and an
+    //     SO(3) recoupling coefficient, for a single SO(3) state of x.
+    //     The W coefficients are taken either from su3lib or from the
+    //     native WBlock (see WSource).  With W from su3lib (the
+    //     default), this is thus a sum over su3lib W coefficients,
+    //     rather than an independent native evaluation.
+    //
+    // Memo tables: The bases of irreps, the extremal coefficients for
+    // each (x1,x2,x3), the SU(2) (and SO(3)) Clebsch-Gordan
+    // coefficients, and the W blocks entering U and Z are memoized, so
+    // that all blocks sharing them (e.g., all W blocks for the same
+    // (x1,x2,x3)) share the work of constructing them.  The tables
+    // are kept per thread, each limited to a byte budget (see
+    // SetCacheBudget), beyond which tables not recently used are
+    // evicted (see BoundedCoefCache).
+    //
+    // Thread safety: All functions may be called from multiple
+    // threads.  However, each W block taken from su3lib (for U and Z
+    // with WSource::kSu3lib) is obtained by a su3lib call, serialized
+    // as described under "su3lib thread safety" in u3coef.h, so U and
+    // Z from su3lib W are subject to the same serialization as su3lib
+    // U and Z, and are in general slower than these.  Only WBlock, and
+    // U and Z with WSource::kNative, avoid su3lib calls entirely.
+    //
+    // Conventions: The native W coefficients are constructed in the
+    // phase and multiplicity conventions of Draayer and Akiyama, on
+    // which su3lib is based.  They satisfy the conjugation relation
+    // above, except in blocks involving a self-conjugate irrep with
+    // SO(3) multiplicity (whose Vergados basis is not mapped onto
+    // itself under conjugation) and in couplings of self-conjugate
+    // irreps only.  Agreement with su3lib at the level of individual
+    // coefficients is checked by u3coef_native_test, and should be
+    // confirmed there before native W coefficients are substituted
+    // for su3lib coefficients.  The U and Z coefficients follow the
+    // conventions of the W coefficients from which they are obtained.
+    // Those obtained from su3lib W coefficients (the default)
+    // therefore agree with the su3lib U and Z coefficients, and may be
+    // used in their place (see NativeUZCoefBackend in
+    // u3coef_backend.h), while those obtained from native W
+    // coefficients are consistent with native W.
+
+    u3::WMultiplicityTuple WBlock(
+        const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+        std::vector<double>& block
+      );
+    // Calculate block of SU(3) reduced coupling (Wigner) coefficients.
+    //
+    // Same interface and block layout as u3::WBlock.  The block is
+    // resized to exactly the number of coefficients.
+
+    enum class WSource {kSu3lib, kNative};
+    // Source of W coefficients from which U and Z are obtained:
+    //
+    //   kSu3lib: su3lib (u3::Su3libWBlock), giving U and Z in su3lib
+    //     conventions
+    //
+    //   kNative: native WBlock, giving U and Z consistent with native W
+
+    u3::UMultiplicityTuple UZBlock(
+        const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+        const u3::SU3& x12, const u3::SU3& x23,
+        u3::UZMode mode,
+        std::vector<double>& block,
+        WSource w_source = WSource::kSu3lib
+      );
+    // Calculate block of SU(3) Racah recoupling coefficients.
+    //
+    // Same interface and block layout as u3::UZBlock, with the
+    // additional argument w_source selecting the source of the W
+    // coefficients (see WSource).  The coefficients are
+    //
+    //   U = <((x1 x2) x12 r12, x3) x r12_3 | (x1, (x2 x3) x23 r23) x r1_23>
+    //
+    //   Z = <((x1 x2) x12 r12, x3) x r12_3 | ((x2 x3) x23 r23, x1) x r1_23>
+    //
+    // where, for Z, x23 and its multiplicities play the role of x13
+    // in the su3lib notation Z(x2 x1 x x3; x12 r12 r12_3; x13 r13
+    // r13_2).
+
+    ////////////////////////////////////////////////////////////////
+    // memo tables
+    ////////////////////////////////////////////////////////////////
+
+    void SetCacheBudget(std::size_t byte_budget);
+    // Set byte budget for each memo table of each thread (default 64
+    // MiB).
+    //
+    // Takes effect for each thread at its next lookup.  A single table
+    // larger than the budget is still retained, after evicting all
+    // others.
+
+    void ClearCaches();
+    // Release memoized tables.
+    //
+    // The calling thread's tables are released immediately, and those
+    // of other threads at their next lookup.
+
+    void CacheReport(std::ostream& os);
+    // Write statistics for memo tables, as lines of "native table
+    // keyword value ...".
+
+  }  // namespace
+}  // namespace
+
+#endif
@@ -0,0 +1,660 @@
+/****************************************************************
+  u3coef_native_test.cpp
+
+  Validation and timing of native SU(3) coupling coefficients against
+  su3lib.
+
+  Syntax:
+    u3coef_native_test [lm_max [num_threads [uz_lm_max]]]
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created, with Wigner coefficients.
+  10/16/26 (mac): Require agreement of U and Z from su3lib W with su3lib.
+  10/16/26 (mac): Require coefficient agreement of native W with su3lib, check
+    conjugation relation, and extend default grid.
+  10/16/26 (mac): Move fully native backend here from u3coef_backend.
+
+****************************************************************/
+
+#include "sp3rlib/u3coef_native.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "sp3rlib/u3coef_backend.h"
+
+////////////////////////////////////////////////////////////////
+// utilities
+////////////////////////////////////////////////////////////////
+
+template <typename tFunction>
+double Time(tFunction function)
+// Return wall time for call to function.
+{
+  auto start_time = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start_time).count();
+}
+
+double BlockNorm(const std::vector<double>& block)
+// Return Frobenius norm of block.
+//
+// This is invariant under orthogonal transformations of the
+// multiplicity indices, and so is independent of the phase and
+// multiplicity conventions for the coefficients.
+{
+  double sum = 0.;
+  for (double value : block)
+    sum += value*value;
+  return std::sqrt(sum);
+}
+
+double MaxDifference(const std::vector<double>& block1, const std::vector<double>& block2)
+{
+  if (block1.size()!=block2.size())
+    return HUGE_VAL;
+  double difference = 0.;
+  for (std::size_t i=0; i<block1.size(); ++i)
+    difference = std::max(difference,std::abs(block1[i]-block2[i]));
+  return difference;
+}
+
+////////////////////////////////////////////////////////////////
+// native backend
+////////////////////////////////////////////////////////////////
+
+class NativeCoefBackend
+  : public u3::CoefBackend
+// Backend evaluating W, U, Z, and Phi blocks with the native engine,
+// with U, Z, and Phi obtained from native W, for validation of the
+// native engine against su3lib.
+//
+// The native engine does not provide 9-(lambda,mu) symbols, and
+// these are not taken from su3lib, since they could then be in
+// conventions inconsistent with the other coefficients.  A request
+// for a 9-(lambda,mu) block is a fatal error.
+{
+public:
+
+  std::string Name() const override
+  {
+    return "native";
+  }
+
+  u3::WMultiplicityTuple WBlock(
+      const u3::SU3& x1, int L1, const u3::SU3& x2, int L2, const u3::SU3& x3, int L3,
+      std::vector<double>& block
+    ) override
+  {
+    return u3::native::WBlock(x1,L1,x2,L2,x3,L3,block);
+  }
+
+  u3::UMultiplicityTuple UZBlock(
+      const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x, const u3::SU3& x3,
+      const u3::SU3& x12, const u3::SU3& x23,
+      u3::UZMode mode,
+      std::vector<double>& block
+    ) override
+  {
+    return u3::native::UZBlock(x1,x2,x,x3,x12,x23,mode,block,u3::native::WSource::kNative);
+  }
+
+  u3::NineLMMultiplicityTuple Unitary9LambdaMuBlock(
+      const u3::SU3&, const u3::SU3&, const u3::SU3&,
+      const u3::SU3&, const u3::SU3&, const u3::SU3&,
+      const u3::SU3&, const u3::SU3&, const u3::SU3&,
+      std::vector<double>&
+    ) override
+  {
+    std::cerr << "ERROR: NativeCoefBackend: 9-(lambda,mu) symbols are not available"
+              << " in native conventions" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  void Report(std::ostream& os) const override
+  {
+    u3::native::CacheReport(os);
+  }
+};
+
+////////////////////////////////////////////////////////////////
+// W coefficients
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::WCoefLabels> GenerateWLabels(int lm_max)
+// Generate distinct allowed W coefficient labels (x1,L1,x2,L2,x3,L3),
+// for x1,x2 with lambda,mu<=lm_max.
+{
+  std::vector<u3::WCoefLabels> label_set;
+  for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+    for (int mu1=0; mu1<=lm_max; ++mu1)
+      for (int lambda2=0; lambda2<=lm_max; ++lambda2)
+        for (int mu2=0; mu2<=lm_max; ++mu2)
+          {
+            u3::SU3 x1(lambda1,mu1), x2(lambda2,mu2);
+            for (const MultiplicityTagged<u3::SU3>& x3_rho : u3::KroneckerProduct(x1,x2))
+              for (const MultiplicityTagged<int>& L1_kappa : u3::BranchingSO3(x1))
+                for (const MultiplicityTagged<int>& L2_kappa : u3::BranchingSO3(x2))
+                  for (const MultiplicityTagged<int>& L3_kappa : u3::BranchingSO3(x3_rho.irrep))
+                    {
+                      int L1 = L1_kappa.irrep, L2 = L2_kappa.irrep, L3 = L3_kappa.irrep;
+                      if ((L3<std::abs(L1-L2))||(L3>L1+L2))
+                        continue;
+                      label_set.push_back(u3::WCoefLabels(x1,L1,x2,L2,x3_rho.irrep,L3));
+                    }
+          }
+  return label_set;
+}
+
+void CalculateWBlocks(
+    const std::vector<u3::WCoefLabels>& label_set,
+    std::vector<std::vector<double>>& blocks,
+    std::size_t start = 0, std::size_t stride = 1
+  )
+// Calculate blocks by WBlock, with the current coefficient backend.
+{
+  for (std::size_t i=start; i<label_set.size(); i+=stride)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = label_set[i].Key();
+      u3::WBlock(x1,L1,x2,L2,x3,L3,blocks[i]);
+    }
+}
+
+bool WOrthogonalityTest(
+    const std::vector<u3::WCoefLabels>& label_set,
+    const std::vector<std::vector<double>>& blocks
+  )
+// Check orthogonality relations of W coefficients:
+//
+//   sum_{x3,rho,kappa3} W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho^2 = 1
+//
+//   sum_{k1,L1,k2,L2} W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho
+//       W(x1 k1 L1; x2 k2 L2 || x3 k3' L3)_rho' = delta_{k3 k3'} delta_{rho rho'}
+{
+  typedef std::tuple<u3::SU3,int,u3::SU3,int,int> SumKey1;
+  typedef std::tuple<u3::SU3,u3::SU3,u3::SU3,int> SumKey2;
+  std::map<SumKey1,std::vector<double>> sums1;
+  std::map<SumKey2,std::vector<double>> sums2;
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = label_set[i].Key();
+      u3::WMultiplicityTuple multiplicities = u3::WMultiplicity(x1,L1,x2,L2,x3,L3);
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+      const std::vector<double>& block = blocks[i];
+
+      std::vector<double>& sum1 = sums1[SumKey1(x1,L1,x2,L2,L3)];
+      sum1.resize(kappa1_max*kappa2_max,0.);
+      std::vector<double>& sum2 = sums2[SumKey2(x1,x2,x3,L3)];
+      const int n = kappa3_max*rho_max;
+      sum2.resize(n*n,0.);
+      for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+        for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+          for (int rho=1; rho<=rho_max; ++rho)
+            for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+              {
+                double coef = block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)];
+                sum1[(kappa1-1)*kappa2_max+(kappa2-1)] += coef*coef;
+                for (int rhop=1; rhop<=rho_max; ++rhop)
+                  for (int kappa3p=1; kappa3p<=kappa3_max; ++kappa3p)
+                    sum2[((rho-1)*kappa3_max+(kappa3-1))*n+((rhop-1)*kappa3_max+(kappa3p-1))]
+                      += coef*block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3p,rhop)];
+              }
+    }
+
+  double deviation1 = 0., deviation2 = 0.;
+  for (const auto& key_sum : sums1)
+    for (double sum : key_sum.second)
+      deviation1 = std::max(deviation1,std::abs(sum-1.));
+  for (const auto& key_sum : sums2)
+    {
+      const int n = std::sqrt(key_sum.second.size()+0.5);
+      for (int i=0; i<n; ++i)
+        for (int j=0; j<n; ++j)
+          deviation2 = std::max(deviation2,std::abs(key_sum.second[i*n+j]-((i==j) ? 1. : 0.)));
+    }
+  bool pass = (deviation1<1e-9) && (deviation2<1e-9);
+  std::cout << fmt::format("  orthogonality: sums {} {} deviation {:.2e} {:.2e} {}",
+                           sums1.size(),sums2.size(),deviation1,deviation2,(pass ? "ok" : "FAIL"))
+            << std::endl;
+  return pass;
+}
+
+bool WComparisonTest(
+    const std::vector<u3::WCoefLabels>& label_set,
+    const std::vector<std::vector<double>>& blocks,
+    const std::vector<std::vector<double>>& reference_blocks
+  )
+// Compare native blocks against su3lib blocks.
+//
+// Agreement of the coefficients themselves, and thus of the phase and
+// multiplicity conventions, is required.  Agreement of block norms,
+// which is independent of these conventions, is also reported, to
+// distinguish convention errors from other errors.
+{
+  long num_norm = 0, num_exact = 0, num_exact_single = 0, num_single = 0;
+  double norm_deviation = 0., coefficient_deviation = 0.;
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    {
+      double deviation = std::abs(BlockNorm(blocks[i])-BlockNorm(reference_blocks[i]));
+      norm_deviation = std::max(norm_deviation,deviation);
+      if (deviation<1e-8)
+        ++num_norm;
+      deviation = MaxDifference(blocks[i],reference_blocks[i]);
+      coefficient_deviation = std::max(coefficient_deviation,deviation);
+      bool exact = (deviation<1e-8);
+      num_exact += exact;
+      if (reference_blocks[i].size()==1)
+        {
+          ++num_single;
+          num_exact_single += exact;
+        }
+    }
+  bool pass = (num_exact==long(label_set.size()));
+  std::cout << fmt::format("  su3lib comparison: blocks {} norm agreement {} (deviation {:.2e})",
+                           label_set.size(),num_norm,norm_deviation)
+            << std::endl;
+  std::cout << fmt::format("  su3lib comparison: identical blocks {} (of which multiplicity-free {} of {}) (deviation {:.2e}) {}",
+                           num_exact,num_exact_single,num_single,coefficient_deviation,(pass ? "ok" : "FAIL"))
+            << std::endl;
+  return pass;
+}
+
+bool WConjugationTest(
+    const std::vector<u3::WCoefLabels>& label_set,
+    const std::vector<std::vector<double>>& blocks
+  )
+// Check conjugation relation of W coefficients (Draayer and Akiyama):
+//
+//   W(x1~ k1 L1; x2~ k2 L2 || x3~ k3 L3)_rho
+//     = (-1)^(lambda1+mu1+lambda2+mu2-lambda3-mu3+L1+L2-L3+rho_max-rho)
+//       W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho
+//
+// Blocks involving a self-conjugate irrep with SO(3) multiplicity, and
+// couplings of self-conjugate irreps only, are skipped (see
+// u3coef_native.h).
+{
+  std::map<u3::WCoefLabels,std::size_t> index;
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    index[label_set[i]] = i;
+  auto ambiguous = [](const u3::SU3& x, int kappa_max)
+    {
+      return (x.lambda()==x.mu())&&(kappa_max>1);
+    };
+
+  long num_checked = 0;
+  double deviation = 0.;
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = label_set[i].Key();
+      u3::WMultiplicityTuple multiplicities = u3::WMultiplicity(x1,L1,x2,L2,x3,L3);
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+      if (ambiguous(x1,kappa1_max)||ambiguous(x2,kappa2_max)||ambiguous(x3,kappa3_max))
+        continue;
+      if ((x1.lambda()==x1.mu())&&(x2.lambda()==x2.mu())&&(x3.lambda()==x3.mu())&&(rho_max>1))
+        continue;
+      auto conjugate = index.find(
+          u3::WCoefLabels(u3::Conjugate(x1),L1,u3::Conjugate(x2),L2,u3::Conjugate(x3),L3)
+        );
+      if (conjugate==index.end())
+        continue;
+      const std::vector<double>& block = blocks[i];
+      const std::vector<double>& conjugate_block = blocks[conjugate->second];
+      const int phase_base = x1.lambda()+x1.mu()+x2.lambda()+x2.mu()-x3.lambda()-x3.mu()+L1+L2-L3+rho_max;
+      for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+        for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+          for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+            for (int rho=1; rho<=rho_max; ++rho)
+              {
+                const int i_coef = u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho);
+                const double phase = ((phase_base-rho)%2) ? -1. : 1.;
+                deviation = std::max(deviation,std::abs(conjugate_block[i_coef]-phase*block[i_coef]));
+              }
+      ++num_checked;
+    }
+  bool pass = (deviation<1e-10);
+  std::cout << fmt::format("  conjugation: blocks {} deviation {:.2e} {}",
+                           num_checked,deviation,(pass ? "ok" : "FAIL"))
+            << std::endl;
+  return pass;
+}
+
+bool WThreadTest(
+    const std::vector<u3::WCoefLabels>& label_set,
+    const std::vector<std::vector<double>>& serial_blocks,
+    int num_threads
+  )
+// Calculate native blocks from several threads, starting from empty
+// memo tables, and compare with serial results.
+{
+  u3::native::ClearCaches();
+  std::vector<std::vector<double>> blocks(label_set.size());
+  double time = Time(
+      [&]()
+      {
+        std::vector<std::thread> threads;
+        for (int thread=0; thread<num_threads; ++thread)
+          threads.emplace_back(CalculateWBlocks,std::cref(label_set),std::ref(blocks),thread,num_threads);
+        for (std::thread& thread : threads)
+          thread.join();
+      }
+    );
+  bool pass = (blocks==serial_blocks);
+  std::cout << fmt::format("  native threads {} time {:.3f} s {}",num_threads,time,(pass ? "ok" : "MISMATCH"))
+            << std::endl;
+  return pass;
+}
+
+bool WTest(int lm_max, int num_threads)
+{
+  std::vector<u3::WCoefLabels> label_set = GenerateWLabels(lm_max);
+  std::cout << fmt::format("W: lm_max {} blocks {}",lm_max,label_set.size()) << std::endl;
+
+  // su3lib
+  u3::SetCoefBackend(nullptr);
+  std::vector<std::vector<double>> reference_blocks(label_set.size());
+  double su3lib_time = Time([&]() {CalculateWBlocks(label_set,reference_blocks);});
+
+  // native (cold and warm memo tables)
+  u3::SetCoefBackend(std::make_shared<NativeCoefBackend>());
+  u3::native::ClearCaches();
+  std::vector<std::vector<double>> blocks(label_set.size());
+  double cold_time = Time([&]() {CalculateWBlocks(label_set,blocks);});
+  double warm_time = Time([&]() {CalculateWBlocks(label_set,blocks);});
+  std::cout << fmt::format("  time: su3lib {:.3f} s native {:.3f} s (cold) {:.3f} s (warm)",
+                           su3lib_time,cold_time,warm_time)
+            << std::endl;
+
+  bool pass = true;
+  pass &= WOrthogonalityTest(label_set,blocks);
+  pass &= WConjugationTest(label_set,blocks);
+  pass &= WComparisonTest(label_set,blocks,reference_blocks);
+  if (num_threads>1)
+    pass &= WThreadTest(label_set,blocks,num_threads);
+  u3::native::CacheReport(std::cout);
+  u3::SetCoefBackend(nullptr);
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// U and Z coefficients
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::UCoefLabels> GenerateUZLabels(int lm_max)
+// Generate distinct allowed U (or Z) coefficient labels
+// (x1,x2,x,x3,x12,x23), for x1,x2,x3 with lambda,mu<=lm_max.
+//
+// For Z, x23 is taken in x2 x x3 and x in x23 x x1, which gives the
+// same multiplicities as for U.
+{
+  std::vector<u3::SU3> irreps;
+  for (int lambda=0; lambda<=lm_max; ++lambda)
+    for (int mu=0; mu<=lm_max; ++mu)
+      irreps.push_back(u3::SU3(lambda,mu));
+
+  std::vector<u3::UCoefLabels> label_set;
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      for (const u3::SU3& x3 : irreps)
+        {
+          std::set<u3::SU3> x_set;
+          for (const MultiplicityTagged<u3::SU3>& x12_r12 : u3::KroneckerProduct(x1,x2))
+            for (const MultiplicityTagged<u3::SU3>& x_r12_3 : u3::KroneckerProduct(x12_r12.irrep,x3))
+              x_set.insert(x_r12_3.irrep);
+          for (const u3::SU3& x : x_set)
+            for (const MultiplicityTagged<u3::SU3>& x12_r12 : u3::KroneckerProduct(x1,x2))
+              for (const MultiplicityTagged<u3::SU3>& x23_r23 : u3::KroneckerProduct(x2,x3))
+                {
+                  u3::UCoefLabels labels(x1,x2,x,x3,x12_r12.irrep,x23_r23.irrep);
+                  if (labels.Allowed())
+                    label_set.push_back(labels);
+                }
+        }
+  return label_set;
+}
+
+void CalculateUZBlocks(
+    const std::vector<u3::UCoefLabels>& label_set,
+    u3::UZMode mode,
+    std::vector<std::vector<double>>& blocks
+  )
+// Calculate blocks by UZBlock, with the current coefficient backend.
+{
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    {
+      u3::SU3 x1,x2,x,x3,x12,x23;
+      std::tie(x1,x2,x,x3,x12,x23) = label_set[i].Key();
+      u3::UZBlock(x1,x2,x,x3,x12,x23,mode,blocks[i]);
+    }
+}
+
+bool UZOrthogonalityTest(
+    const std::vector<u3::UCoefLabels>& label_set,
+    const std::vector<std::vector<double>>& blocks
+  )
+// Check that, for each (x1,x2,x3,x), the U (or Z) coefficients form
+// an orthogonal matrix, with rows labeled by (x12,r12,r12_3) and
+// columns labeled by (x23,r23,r1_23).
+{
+  typedef std::tuple<u3::SU3,u3::SU3,u3::SU3,u3::SU3> GroupKey;
+  typedef std::tuple<u3::SU3,int,int> IndexKey;
+  struct Group
+  {
+    std::map<IndexKey,int> rows, columns;
+    std::vector<std::tuple<int,int,double>> entries;
+  };
+  std::map<GroupKey,Group> groups;
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    {
+      u3::SU3 x1,x2,x,x3,x12,x23;
+      std::tie(x1,x2,x,x3,x12,x23) = label_set[i].Key();
+      u3::UMultiplicityTuple multiplicities = u3::UMultiplicity(x1,x2,x,x3,x12,x23);
+      int r12_max, r12_3_max, r23_max, r1_23_max;
+      std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = multiplicities;
+      Group& group = groups[GroupKey(x1,x2,x3,x)];
+      for (int r12=1; r12<=r12_max; ++r12)
+        for (int r12_3=1; r12_3<=r12_3_max; ++r12_3)
+          for (int r23=1; r23<=r23_max; ++r23)
+            for (int r1_23=1; r1_23<=r1_23_max; ++r1_23)
+              {
+                int row = group.rows.emplace(IndexKey(x12,r12,r12_3),group.rows.size()).first->second;
+                int column = group.columns.emplace(IndexKey(x23,r23,r1_23),group.columns.size()).first->second;
+                group.entries.emplace_back(row,column,blocks[i][u3::UZBlockIndex(multiplicities,r12,r12_3,r23,r1_23)]);
+              }
+    }
+
+  double deviation = 0.;
+  for (const auto& key_group : groups)
+    {
+      const Group& group = key_group.second;
+      const int n = group.rows.size();
+      if (int(group.columns.size())!=n)
+        {
+          deviation = HUGE_VAL;
+          continue;
+        }
+      std::vector<double> matrix(n*n,0.);
+      for (const auto& entry : group.entries)
+        matrix[std::get<0>(entry)*n+std::get<1>(entry)] = std::get<2>(entry);
+      for (int i=0; i<n; ++i)
+        for (int j=0; j<n; ++j)
+          {
+            double row_sum = 0., column_sum = 0.;
+            for (int k=0; k<n; ++k)
+              {
+                row_sum += matrix[i*n+k]*matrix[j*n+k];
+                column_sum += matrix[k*n+i]*matrix[k*n+j];
+              }
+            double delta = (i==j) ? 1. : 0.;
+            deviation = std::max(deviation,std::max(std::abs(row_sum-delta),std::abs(column_sum-delta)));
+          }
+    }
+  bool pass = (deviation<1e-10);
+  std::cout << fmt::format("  orthogonality: matrices {} deviation {:.2e} {}",
+                           groups.size(),deviation,(pass ? "ok" : "FAIL"))
+            << std::endl;
+  return pass;
+}
+
+bool UZComparisonTest(
+    const std::vector<u3::UCoefLabels>& label_set,
+    const std::vector<std::vector<double>>& blocks,
+    const std::vector<std::vector<double>>& reference_blocks
+  )
+// Compare native blocks against su3lib blocks.
+//
+// Agreement of the coefficients themselves is required, as for
+// WComparisonTest.
+{
+  long num_norm = 0, num_exact = 0;
+  double norm_deviation = 0., coefficient_deviation = 0.;
+  for (std::size_t i=0; i<label_set.size(); ++i)
+    {
+      double deviation = std::abs(BlockNorm(blocks[i])-BlockNorm(reference_blocks[i]));
+      norm_deviation = std::max(norm_deviation,deviation);
+      if (deviation<1e-8)
+        ++num_norm;
+      deviation = MaxDifference(blocks[i],reference_blocks[i]);
+      coefficient_deviation = std::max(coefficient_deviation,deviation);
+      if (deviation<1e-8)
+        ++num_exact;
+    }
+  bool pass = (num_exact==long(label_set.size()));
+  std::cout << fmt::format("  su3lib comparison: blocks {} norm agreement {} (deviation {:.2e}) identical {} (deviation {:.2e}) {}",
+                           label_set.size(),num_norm,norm_deviation,num_exact,coefficient_deviation,(pass ? "ok" : "FAIL"))
+            << std::endl;
+  return pass;
+}
+
+bool UZTest(int lm_max, u3::UZMode mode)
+{
+  const char* name = (mode==u3::UZMode::kU) ? "U" : "Z";
+  std::vector<u3::UCoefLabels> label_set = GenerateUZLabels(lm_max);
+  std::cout << fmt::format("{}: lm_max {} blocks {}",name,lm_max,label_set.size()) << std::endl;
+
+  // su3lib
+  u3::SetCoefBackend(nullptr);
+  std::vector<std::vector<double>> reference_blocks(label_set.size());
+  double su3lib_time = Time([&]() {CalculateUZBlocks(label_set,mode,reference_blocks);});
+
+  // native from su3lib W (cold and warm memo tables)
+  u3::SetCoefBackend(std::make_shared<u3::NativeUZCoefBackend>());
+  u3::native::ClearCaches();
+  std::vector<std::vector<double>> su3lib_w_blocks(label_set.size());
+  double cold_time = Time([&]() {CalculateUZBlocks(label_set,mode,su3lib_w_blocks);});
+  double warm_time = Time([&]() {CalculateUZBlocks(label_set,mode,su3lib_w_blocks);});
+  std::cout << fmt::format("  time: su3lib {:.3f} s native from su3lib W {:.3f} s (cold) {:.3f} s (warm)",
+                           su3lib_time,cold_time,warm_time)
+            << std::endl;
+
+  bool pass = true;
+  pass &= UZComparisonTest(label_set,su3lib_w_blocks,reference_blocks);
+
+  // native from native W
+  u3::SetCoefBackend(std::make_shared<NativeCoefBackend>());
+  u3::native::ClearCaches();
+  std::vector<std::vector<double>> blocks(label_set.size());
+  cold_time = Time([&]() {CalculateUZBlocks(label_set,mode,blocks);});
+  warm_time = Time([&]() {CalculateUZBlocks(label_set,mode,blocks);});
+  std::cout << fmt::format("  time: native from native W {:.3f} s (cold) {:.3f} s (warm)",
+                           cold_time,warm_time)
+            << std::endl;
+
+  pass &= UZOrthogonalityTest(label_set,blocks);
+  pass &= UZComparisonTest(label_set,blocks,reference_blocks);
+  u3::SetCoefBackend(nullptr);
+  return pass;
+}
+
+bool ExchangeTest(int lm_max)
+// Check exchange symmetry of native W coefficients, with native Phi:
+//
+//   W(x1 k1 L1; x2 k2 L2 || x3 k3 L3)_rho
+//     = (-)^(L1+L2-L3) sum_rho' Phi(x1,x2,x3)_{rho rho'} W(x2 k2 L2; x1 k1 L1 || x3 k3 L3)_rho'
+//
+// This relates W coefficients for the two coupling orders, which are
+// constructed independently, through Z coefficients, and so checks that
+// the native engines are mutually consistent, as required by
+// SymmetricWCoefCache.
+{
+  u3::SetCoefBackend(std::make_shared<NativeCoefBackend>());
+  std::vector<u3::WCoefLabels> label_set = GenerateWLabels(lm_max);
+  double deviation = 0.;
+  for (const u3::WCoefLabels& labels : label_set)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+      std::vector<double> block, exchanged_block, phi_block;
+      u3::WMultiplicityTuple multiplicities = u3::WBlock(x1,L1,x2,L2,x3,L3,block);
+      u3::WMultiplicityTuple exchanged_multiplicities = u3::WBlock(x2,L2,x1,L1,x3,L3,exchanged_block);
+      u3::UMultiplicityTuple phi_multiplicities = u3::ZBlock(x1,u3::SU3(0,0),x3,x2,x1,x2,phi_block);
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+      const double phase = ((L1+L2-L3)%2) ? -1. : 1.;
+      for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+        for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+          for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+            for (int rho=1; rho<=rho_max; ++rho)
+              {
+                double value = 0.;
+                for (int rhop=1; rhop<=rho_max; ++rhop)
+                  value += phi_block[u3::UZBlockIndex(phi_multiplicities,1,rho,1,rhop)]
+                    *exchanged_block[u3::WBlockIndex(exchanged_multiplicities,kappa2,kappa1,kappa3,rhop)];
+                value *= phase;
+                deviation = std::max(
+                    deviation,
+                    std::abs(value-block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)])
+                  );
+              }
+    }
+  bool pass = (deviation<1e-10);
+  std::cout << fmt::format("W exchange (native W and Phi): blocks {} deviation {:.2e} {}",
+                           label_set.size(),deviation,(pass ? "ok" : "FAIL"))
+            << std::endl;
+  u3::SetCoefBackend(nullptr);
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  u3::U3CoefInit();
+
+  int lm_max = (argc>1) ? std::atoi(argv[1]) : 4;
+  int num_threads = (argc>2) ? std::atoi(argv[2]) : 4;
+  int uz_lm_max = (argc>3) ? std::atoi(argv[3]) : 2;
+
+  bool pass = true;
+  pass &= WTest(lm_max,num_threads);
+  pass &= UZTest(uz_lm_max,u3::UZMode::kU);
+  pass &= UZTest(uz_lm_max,u3::UZMode::kZ);
+  pass &= ExchangeTest(lm_max);
+
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,87 @@
+/****************************************************************
+  u3coef_prefill.cpp
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+****************************************************************/
+
+#include "sp3rlib/u3coef_prefill.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // shared memory
+  ////////////////////////////////////////////////////////////////
+
+  SharedBuffer::SharedBuffer(std::size_t size)
+    : size_(size ? size : 1)
+  {
+    void* data = mmap(nullptr,size_,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_ANONYMOUS,-1,0);
+    if (data==MAP_FAILED)
+      throw std::bad_alloc();
+    data_ = static_cast<char*>(data);
+  }
+
+  SharedBuffer::~SharedBuffer()
+  {
+    munmap(data_,size_);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // worker pools
+  ////////////////////////////////////////////////////////////////
+
+  bool RunWorkerProcesses(int num_workers, const std::function<void()>& worker)
+  {
+    // flush output so buffered text is not duplicated in children
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> pids;
+    bool success = true;
+    for (int i=0; i<num_workers; ++i)
+      {
+        pid_t pid = fork();
+        if (pid==0)
+          {
+            worker();
+            _exit(EXIT_SUCCESS);  // skip parent's exit handlers
+          }
+        if (pid<0)
+          {
+            success = false;
+            break;
+          }
+        pids.push_back(pid);
+      }
+
+    for (pid_t pid : pids)
+      {
+        int status;
+        if ((waitpid(pid,&status,0)!=pid)||!WIFEXITED(status)||(WEXITSTATUS(status)!=EXIT_SUCCESS))
+          success = false;
+      }
+    return success;
+  }
+
+  void RunWorkerThreads(int num_workers, const std::function<void()>& worker)
+  {
+    std::vector<std::thread> threads;
+    for (int i=0; i<num_workers; ++i)
+      threads.emplace_back(worker);
+    for (std::thread& thread : threads)
+      thread.join();
+  }
+
+}  // namespace
@@ -0,0 +1,323 @@
+/****************************************************************
+  u3coef_prefill.h
+
+  Bulk parallel population of SU(3) coupling coefficient caches.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Canonicalize U and Z labels if symmetry enabled.
+
+****************************************************************/
+
+#ifndef U3COEF_PREFILL_H_
+#define U3COEF_PREFILL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "sp3rlib/u3coef.h"
+#include "sp3rlib/u3coef_store.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // block size
+  ////////////////////////////////////////////////////////////////
+
+  // Number of coefficients in block for given labels, or zero if
+  // labels are not allowed.  This is also used as the cost estimate
+  // for scheduling, since the su3lib work grows with the block size.
+
+  inline std::size_t CoefBlockSize(const u3::UCoefLabels& labels)
+  {
+    u3::SU3 x1,x2,x,x3,x12,x23;
+    std::tie(x1,x2,x,x3,x12,x23) = labels.Key();
+    int r12_max, r12_3_max, r23_max, r1_23_max;
+    std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = UMultiplicity(x1,x2,x,x3,x12,x23);
+    return std::size_t(r12_max)*r12_3_max*r23_max*r1_23_max;
+  }
+
+  inline std::size_t CoefBlockSize(const u3::WCoefLabels& labels)
+  {
+    u3::SU3 x1,x2,x3;
+    int L1,L2,L3;
+    std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+    int kappa1_max, kappa2_max, kappa3_max, rho_max;
+    std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = WMultiplicity(x1,L1,x2,L2,x3,L3);
+    return std::size_t(kappa1_max)*kappa2_max*kappa3_max*rho_max;
+  }
+
+  inline std::size_t CoefBlockSize(const u3::PhiCoefLabels& labels)
+  {
+    u3::SU3 x1,x2,x3;
+    std::tie(x1,x2,x3) = labels.Key();
+    std::size_t rho_max = u3::OuterMultiplicity(x1,x2,x3);
+    return rho_max*rho_max;
+  }
+
+  inline std::size_t CoefBlockSize(const u3::NineLMCoefLabels& labels)
+  {
+    u3::SU3 x1,x2,x12,x3,x4,x34,x13,x24,x;
+    std::tie(x1,x2,x12,x3,x4,x34,x13,x24,x) = labels.Key();
+    return std::size_t(u3::OuterMultiplicity(x1,x2,x12))
+      *u3::OuterMultiplicity(x3,x4,x34)
+      *u3::OuterMultiplicity(x12,x34,x)
+      *u3::OuterMultiplicity(x1,x3,x13)
+      *u3::OuterMultiplicity(x2,x4,x24)
+      *u3::OuterMultiplicity(x13,x24,x);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // worker pools (non-template)
+  ////////////////////////////////////////////////////////////////
+
+  class SharedBuffer
+  // Anonymous memory mapping shared with forked child processes.
+  {
+  public:
+
+    explicit SharedBuffer(std::size_t size);
+    ~SharedBuffer();
+
+    // not copyable (owns mapping)
+    SharedBuffer(const SharedBuffer&) = delete;
+    SharedBuffer& operator=(const SharedBuffer&) = delete;
+
+    char* data() const
+    {
+      return data_;
+    }
+
+  private:
+    char* data_;
+    std::size_t size_;
+  };
+
+  bool RunWorkerProcesses(int num_workers, const std::function<void()>& worker);
+  // Run worker function in num_workers forked child processes, and
+  // wait for them to exit.
+  //
+  // Returns false if any worker could not be started or did not exit
+  // normally.
+
+  void RunWorkerThreads(int num_workers, const std::function<void()>& worker);
+  // Run worker function in num_workers threads, and wait for them to
+  // finish.
+
+  ////////////////////////////////////////////////////////////////
+  // prefill
+  ////////////////////////////////////////////////////////////////
+
+  template <typename tLabels, typename tBlock>
+  std::size_t PrefillCache(
+      u3::CoefCache<tLabels,tBlock>& cache,
+      const std::vector<tLabels>& label_set,
+      int num_workers
+    )
+  // Populate cache with blocks for given labels, in parallel.
+  //
+  // Labels are deduplicated, and labels which are not allowed (i.e.,
+  // give an empty block) or already cached are dropped.  The remaining
+  // blocks are scheduled largest first (by CoefBlockSize), and
+  // workers claim the next block from a shared counter as they become
+  // free, so that the expensive blocks do not straggle at the end.
+  //
+  // The blocks are then moved into the cache's arena (Compact).
+  //
+  // Workers: If su3lib calls are serialized (g_su3lib_serialized),
+  // threads would gain nothing, so the workers are forked child
+  // processes, each with its own copy of the su3lib state, which
+  // write their blocks into a shared memory buffer.  The parent then
+  // merges the blocks into the cache.  Otherwise (su3lib built
+  // reentrant), the workers are threads.  Prefill must therefore be
+  // called from a single-threaded context (e.g., outside any OpenMP
+  // parallel region), after U3CoefInit.
+  //
+  // Arguments:
+  //   cache (u3::CoefCache): cache to populate
+  //   label_set (std::vector<tLabels>): labels of blocks to compute
+  //   num_workers (int): number of worker processes or threads (<=1
+  //     for serial calculation)
+  //
+  // Returns:
+  //   (std::size_t): number of blocks computed
+  {
+    typedef typename tBlock::KeyType MultiplicityType;
+    static constexpr int kNumMultiplicities = std::tuple_size<MultiplicityType>::value;
+
+    // deduplicate and filter labels
+    std::vector<tLabels> pending(label_set);
+    std::sort(pending.begin(),pending.end());
+    pending.erase(std::unique(pending.begin(),pending.end()),pending.end());
+    std::vector<std::pair<std::size_t,tLabels>> tasks;
+    for (const tLabels& labels : pending)
+      {
+        std::size_t size = CoefBlockSize(labels);
+        if ((size>0)&&(cache.find(labels)==cache.end()))
+          tasks.emplace_back(size,labels);
+      }
+    const std::size_t num_tasks = tasks.size();
+
+    // schedule largest blocks first
+    std::stable_sort(
+        tasks.begin(),tasks.end(),
+        [](const std::pair<std::size_t,tLabels>& task1, const std::pair<std::size_t,tLabels>& task2)
+        {return task1.first>task2.first;}
+      );
+
+    // serial calculation
+    if ((num_workers<=1)||(num_tasks<=1))
+      {
+        for (const auto& task : tasks)
+          cache.emplace(task.second,tBlock(task.second));
+        cache.Compact();
+        return num_tasks;
+      }
+
+    // threaded calculation
+    if (!g_su3lib_serialized)
+      {
+        std::vector<tBlock> blocks(num_tasks);
+        std::atomic<std::size_t> next_task(0);
+        RunWorkerThreads(
+            num_workers,
+            [&]()
+            {
+              for (std::size_t task=next_task++; task<num_tasks; task=next_task++)
+                blocks[task] = tBlock(tasks[task].second);
+            }
+          );
+        for (std::size_t task=0; task<num_tasks; ++task)
+          cache.emplace(tasks[task].second,std::move(blocks[task]));
+        cache.Compact();
+        return num_tasks;
+      }
+
+    // multiprocess calculation
+    //
+    // Shared buffer layout: task counter, completion flags,
+    // multiplicities, coefficients (offsets fixed by block sizes).
+    // The atomics must be lock-free to be shared between processes.
+    static_assert(ATOMIC_LONG_LOCK_FREE==2,"prefill requires lock-free atomics");
+    static_assert(ATOMIC_BOOL_LOCK_FREE==2,"prefill requires lock-free atomics");
+    std::vector<std::size_t> offsets(num_tasks+1,0);
+    for (std::size_t task=0; task<num_tasks; ++task)
+      offsets[task+1] = offsets[task]+tasks[task].first;
+    const std::size_t flags_offset = sizeof(std::atomic<std::size_t>);
+    const std::size_t multiplicities_offset
+      = ((flags_offset+num_tasks*sizeof(std::atomic<bool>)+7)/8)*8;
+    const std::size_t coefs_offset
+      = ((multiplicities_offset+num_tasks*kNumMultiplicities*sizeof(std::int32_t)+7)/8)*8;
+    SharedBuffer buffer(coefs_offset+offsets[num_tasks]*sizeof(double));
+    std::atomic<std::size_t>* next_task = new (buffer.data()) std::atomic<std::size_t>(0);
+    std::atomic<bool>* done = reinterpret_cast<std::atomic<bool>*>(buffer.data()+flags_offset);
+    for (std::size_t task=0; task<num_tasks; ++task)
+      new (done+task) std::atomic<bool>(false);
+    std::int32_t* multiplicities = reinterpret_cast<std::int32_t*>(buffer.data()+multiplicities_offset);
+    double* coefs = reinterpret_cast<double*>(buffer.data()+coefs_offset);
+
+    RunWorkerProcesses(
+        num_workers,
+        [&]()
+        {
+          for (std::size_t task=(*next_task)++; task<num_tasks; task=(*next_task)++)
+            {
+              tBlock block(tasks[task].second);
+              PackCoefStoreMultiplicities(block.Key(),multiplicities+task*kNumMultiplicities);
+              std::copy(block.data(),block.data()+block.size(),coefs+offsets[task]);
+              done[task].store(true,std::memory_order_release);
+            }
+        }
+      );
+
+    // merge into cache (recalculating any blocks lost to failed workers)
+    for (std::size_t task=0; task<num_tasks; ++task)
+      {
+        const tLabels& labels = tasks[task].second;
+        if (done[task].load(std::memory_order_acquire))
+          {
+            MultiplicityType block_multiplicities;
+            UnpackCoefStoreMultiplicities(multiplicities+task*kNumMultiplicities,block_multiplicities);
+            cache.emplace(labels,tBlock(block_multiplicities,coefs+offsets[task]));
+          }
+        else
+          cache.emplace(labels,tBlock(labels));
+      }
+    cache.Compact();
+    return num_tasks;
+  }
+
+  inline std::vector<u3::UCoefLabels> CanonicalUCoefLabelSet(const std::vector<u3::UCoefLabels>& label_set)
+  // Replace U or Z coefficient labels by their canonical labels.
+  {
+    std::vector<u3::UCoefLabels> canonical_label_set;
+    canonical_label_set.reserve(label_set.size());
+    bool conjugated;
+    for (const u3::UCoefLabels& labels : label_set)
+      canonical_label_set.push_back(CanonicalUCoefLabels(labels,conjugated));
+    return canonical_label_set;
+  }
+
+  inline std::size_t PrefillUCache(
+      u3::UCoefCache& cache, const std::vector<u3::UCoefLabels>& label_set, int num_workers
+    )
+  // Populate U coefficient cache.  See PrefillCache.
+  //
+  // If g_u_symmetry_enabled is set, the blocks for the canonical
+  // labels are calculated instead (see CanonicalUCoefLabels).
+  {
+    if (!g_u_symmetry_enabled)
+      return PrefillCache(cache,label_set,num_workers);
+    return PrefillCache(cache,CanonicalUCoefLabelSet(label_set),num_workers);
+  }
+
+  inline std::size_t PrefillZCache(
+      u3::ZCoefCache& cache, const std::vector<u3::ZCoefLabels>& label_set, int num_workers
+    )
+  // Populate Z coefficient cache.  See PrefillCache.
+  //
+  // If g_u_symmetry_enabled is set, the blocks for the canonical
+  // labels are calculated instead (see CanonicalUCoefLabels).
+  {
+    if (!g_u_symmetry_enabled)
+      return PrefillCache(cache,label_set,num_workers);
+    return PrefillCache(cache,CanonicalUCoefLabelSet(label_set),num_workers);
+  }
+
+  inline std::size_t PrefillWCache(
+      u3::WCoefCache& cache, const std::vector<u3::WCoefLabels>& label_set, int num_workers
+    )
+  // Populate W coefficient cache.  See PrefillCache.
+  {
+    return PrefillCache(cache,label_set,num_workers);
+  }
+
+  inline std::size_t PrefillPhiCache(
+      u3::PhiCoefCache& cache, const std::vector<u3::PhiCoefLabels>& label_set, int num_workers
+    )
+  // Populate Phi coefficient cache.  See PrefillCache.
+  {
+    return PrefillCache(cache,label_set,num_workers);
+  }
+
+  inline std::size_t PrefillNineLMCache(
+      u3::NineLMCoefCache& cache, const std::vector<u3::NineLMCoefLabels>& label_set, int num_workers
+    )
+  // Populate 9-(lambda,mu) symbol cache.  See PrefillCache.
+  {
+    return PrefillCache(cache,label_set,num_workers);
+  }
+
+}  // namespace
+
+#endif
@@ -0,0 +1,134 @@
+/****************************************************************
+  u3coef_prefill_test.cpp
+
+  Test parallel prefill of coefficient caches.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+
+****************************************************************/
+
+#include "sp3rlib/u3coef_prefill.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// label generation
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::UCoefLabels> GenerateULabels(int lm_max)
+// Generate U coefficient labels (x1,x2,x,x3,x12,x23), for x1,x2,x3
+// with lambda,mu<=lm_max, including disallowed labels and duplicates
+// (as a driver collecting labels from matrix elements might).
+{
+  std::vector<u3::SU3> irreps;
+  for (int lambda=0; lambda<=lm_max; ++lambda)
+    for (int mu=0; mu<=lm_max; ++mu)
+      irreps.push_back(u3::SU3(lambda,mu));
+
+  std::vector<u3::UCoefLabels> label_set;
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      for (const u3::SU3& x3 : irreps)
+        for (const MultiplicityTagged<u3::SU3>& x12_rho : u3::KroneckerProduct(x1,x2))
+          for (const MultiplicityTagged<u3::SU3>& x_rho : u3::KroneckerProduct(x12_rho.irrep,x3))
+            for (const MultiplicityTagged<u3::SU3>& x23_rho : u3::KroneckerProduct(x2,x3))
+              label_set.push_back(u3::UCoefLabels(x1,x2,x_rho.irrep,x3,x12_rho.irrep,x23_rho.irrep));
+  std::size_t num_unique = label_set.size();
+  for (std::size_t i=0; i<num_unique; i+=3)
+    label_set.push_back(label_set[i]);
+  return label_set;
+}
+
+////////////////////////////////////////////////////////////////
+// comparison
+////////////////////////////////////////////////////////////////
+
+template <typename tCache>
+bool CompareCaches(const tCache& cache, const tCache& reference_cache)
+// Check that caches hold same labels with identical blocks.
+{
+  if (cache.size()!=reference_cache.size())
+    return false;
+  for (const auto& labels_block : reference_cache)
+    {
+      auto it = cache.find(labels_block.first);
+      if (it==cache.end())
+        return false;
+      const auto& block = it->second;
+      const auto& reference_block = labels_block.second;
+      if ((block.Key()!=reference_block.Key())||(block.size()!=reference_block.size())
+          ||!std::equal(block.data(),block.data()+block.size(),reference_block.data()))
+        return false;
+    }
+  return true;
+}
+
+template <typename tCache, typename tLabels>
+bool PrefillTest(
+    const std::string& name, const std::vector<tLabels>& label_set,
+    const tCache& reference_cache, int num_workers
+  )
+{
+  tCache cache;
+  auto start_time = std::chrono::steady_clock::now();
+  std::size_t num_computed = u3::PrefillCache(cache,label_set,num_workers);
+  double time = std::chrono::duration<double>(std::chrono::steady_clock::now()-start_time).count();
+
+  // second prefill should find everything cached
+  std::size_t num_recomputed = u3::PrefillCache(cache,label_set,num_workers);
+
+  bool pass = CompareCaches(cache,reference_cache) && (num_computed==reference_cache.size()) && (num_recomputed==0);
+  std::cout << fmt::format("  {:8} workers {} computed {} time {:.3f} s {}",
+                           name,num_workers,num_computed,time,(pass ? "ok" : "MISMATCH"))
+            << std::endl;
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  u3::U3CoefInit();
+
+  std::vector<u3::UCoefLabels> label_set = GenerateULabels(2);
+
+  // reference: serial population by allowed labels
+  u3::UCoefCache reference_cache;
+  for (const u3::UCoefLabels& labels : label_set)
+    if (labels.Allowed())
+      reference_cache.GetBlock(labels);
+  std::cout << fmt::format("U prefill: labels {} distinct allowed {}",label_set.size(),reference_cache.size())
+            << std::endl;
+
+  bool pass = true;
+  pass &= PrefillTest("serial",label_set,reference_cache,1);
+  u3::g_su3lib_serialized = true;
+  for (int num_workers : {2,4})
+    pass &= PrefillTest("process",label_set,reference_cache,num_workers);
+  u3::g_su3lib_serialized = false;
+  for (int num_workers : {2,4})
+    pass &= PrefillTest("thread",label_set,reference_cache,num_workers);
+  u3::g_su3lib_serialized = true;
+
+  // Z coefficients (same labels)
+  u3::ZCoefCache z_reference_cache;
+  for (const u3::ZCoefLabels& labels : label_set)
+    if (labels.Allowed())
+      z_reference_cache.GetBlock(labels);
+  pass &= PrefillTest("Z",label_set,z_reference_cache,4);
+
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
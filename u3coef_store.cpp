@@ -0,0 +1,216 @@
+/****************************************************************
+  u3coef_store.cpp
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+****************************************************************/
+
+#include "sp3rlib/u3coef_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // memory mapping
+  ////////////////////////////////////////////////////////////////
+
+  MappedFile::~MappedFile()
+  {
+    Close();
+  }
+
+  bool MappedFile::Open(const std::string& filename)
+  {
+    Close();
+    int fd = open(filename.c_str(),O_RDONLY);
+    if (fd<0)
+      return false;
+    struct stat file_stat;
+    if ((fstat(fd,&file_stat)!=0)||(file_stat.st_size==0))
+      {
+        close(fd);
+        return false;
+      }
+    void* data = mmap(nullptr,file_stat.st_size,PROT_READ,MAP_SHARED,fd,0);
+    close(fd);  // mapping persists after descriptor is closed
+    if (data==MAP_FAILED)
+      return false;
+
+    // access pattern is binary search and scattered block retrieval,
+    // so disable readahead and let pages be faulted in on demand
+    madvise(data,file_stat.st_size,MADV_RANDOM);
+
+    data_ = static_cast<const char*>(data);
+    size_ = file_stat.st_size;
+    return true;
+  }
+
+  void MappedFile::Close()
+  {
+    if (data_)
+      munmap(const_cast<char*>(data_),size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // file format
+  ////////////////////////////////////////////////////////////////
+
+  static const char kCoefStoreMagic[8] = {'S','U','3','C','O','E','F','\0'};
+  static const std::uint32_t kCoefStoreVersion = 1;
+
+  void WriteCoefStoreFile(const std::string& filename, CoefStoreKind kind, const CoefStoreRecords& records)
+  {
+    const std::size_t num_entries = records.coefs.size();
+    const int record_words = records.num_label_words+2+(records.num_multiplicities+1)/2;
+
+    // sort records by labels
+    std::vector<std::size_t> order(num_entries);
+    std::iota(order.begin(),order.end(),0);
+    const std::uint64_t* label_words = records.label_words.data();
+    const int num_label_words = records.num_label_words;
+    std::sort(
+        order.begin(),order.end(),
+        [label_words,num_label_words](std::size_t i, std::size_t j)
+        {
+          return std::lexicographical_compare(
+              label_words+i*num_label_words,label_words+(i+1)*num_label_words,
+              label_words+j*num_label_words,label_words+(j+1)*num_label_words
+            );
+        }
+      );
+
+    // build index
+    std::vector<std::uint64_t> index(num_entries*record_words,0);
+    std::uint64_t payload_size = 0;
+    for (std::size_t position=0; position<num_entries; ++position)
+      {
+        const std::size_t i = order[position];
+        std::uint64_t* record = index.data()+position*record_words;
+        std::copy(label_words+i*num_label_words,label_words+(i+1)*num_label_words,record);
+        record[num_label_words] = payload_size;
+        record[num_label_words+1] = records.sizes[i];
+        std::memcpy(
+            record+num_label_words+2,
+            records.multiplicities.data()+i*records.num_multiplicities,
+            records.num_multiplicities*sizeof(std::int32_t)
+          );
+        payload_size += records.sizes[i];
+      }
+
+    // header
+    CoefStoreHeader header;
+    std::memset(&header,0,sizeof(header));
+    std::memcpy(header.magic,kCoefStoreMagic,sizeof(header.magic));
+    header.version = kCoefStoreVersion;
+    header.kind = static_cast<std::uint32_t>(kind);
+    header.num_label_words = records.num_label_words;
+    header.num_multiplicities = records.num_multiplicities;
+    header.num_entries = num_entries;
+    header.index_offset = sizeof(header);
+    header.payload_offset = header.index_offset+index.size()*sizeof(std::uint64_t);
+    header.payload_size = payload_size;
+
+    // write to temporary file, then rename into place (so that a
+    // store currently mapped from the same file remains valid)
+    const std::string temp_filename = filename+".tmp";
+    std::ofstream out_stream(temp_filename,std::ios::binary|std::ios::trunc);
+    out_stream.write(reinterpret_cast<const char*>(&header),sizeof(header));
+    out_stream.write(reinterpret_cast<const char*>(index.data()),index.size()*sizeof(std::uint64_t));
+    for (std::size_t position=0; position<num_entries; ++position)
+      {
+        const std::size_t i = order[position];
+        out_stream.write(reinterpret_cast<const char*>(records.coefs[i]),records.sizes[i]*sizeof(double));
+      }
+    out_stream.close();
+    if (!out_stream)
+      {
+        std::cerr << "ERROR: failure writing coefficient store " << temp_filename << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    if (std::rename(temp_filename.c_str(),filename.c_str())!=0)
+      {
+        std::cerr << "ERROR: failure renaming coefficient store to " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+  }
+
+  const char* ValidateCoefStoreFile(
+      const std::string& filename, const MappedFile& file, CoefStoreKind kind,
+      int num_label_words, int num_multiplicities, int multiplicity_power
+    )
+  {
+    bool valid = (file.size()>=sizeof(CoefStoreHeader));
+    const CoefStoreHeader* header = reinterpret_cast<const CoefStoreHeader*>(file.data());
+    valid = valid
+      && (std::memcmp(header->magic,kCoefStoreMagic,sizeof(header->magic))==0)
+      && (header->version==kCoefStoreVersion);
+    if (!valid)
+      {
+        std::cerr << "ERROR: not a coefficient store file (or unsupported version): " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+
+    const int record_words = num_label_words+2+(num_multiplicities+1)/2;
+    valid = (header->kind==static_cast<std::uint32_t>(kind))
+      && (int(header->num_label_words)==num_label_words)
+      && (int(header->num_multiplicities)==num_multiplicities);
+    if (!valid)
+      {
+        std::cerr << "ERROR: coefficient store holds wrong kind of coefficient: " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+
+    const std::size_t record_bytes = record_words*sizeof(std::uint64_t);
+    valid = (header->index_offset==sizeof(CoefStoreHeader))
+      && (header->num_entries<=(file.size()-sizeof(CoefStoreHeader))/record_bytes)
+      && (header->payload_offset==header->index_offset+header->num_entries*record_bytes)
+      && (header->payload_size<=(file.size()-header->payload_offset)/sizeof(double))
+      && (header->payload_offset+header->payload_size*sizeof(double)==file.size());
+
+    // each record's block must lie within payload, and its size must
+    // match its (positive) multiplicities, since blocks are constructed
+    // from the multiplicities alone (checked here, once, so that lookups
+    // and Save may trust the index)
+    const std::uint64_t* index = reinterpret_cast<const std::uint64_t*>(file.data()+sizeof(CoefStoreHeader));
+    for (std::uint64_t i=0; valid && (i<header->num_entries); ++i)
+      {
+        const std::uint64_t* record = index+i*record_words;
+        const std::uint64_t offset = record[num_label_words];
+        const std::uint64_t size = record[num_label_words+1];
+        valid = (offset<=header->payload_size) && (size<=header->payload_size-offset);
+        const std::int32_t* multiplicities = reinterpret_cast<const std::int32_t*>(record+num_label_words+2);
+        std::uint64_t product = 1;
+        for (int j=0; valid && (j<num_multiplicities*multiplicity_power); ++j)
+          {
+            const std::uint64_t multiplicity = multiplicities[j/multiplicity_power];
+            valid = (multiplicities[j/multiplicity_power]>=1) && (multiplicity<=size/product);
+            product *= multiplicity;
+          }
+        valid = valid && (product==size);
+      }
+    if (!valid)
+      {
+        std::cerr << "ERROR: coefficient store is truncated or corrupt: " << filename << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+
+    return file.data();
+  }
+
+}  // namespace
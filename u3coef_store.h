@@ -0,0 +1,533 @@
+/****************************************************************
+  u3coef_store.h
+
+  Persistent (memory-mapped) storage of SU(3) coupling coefficient
+  blocks.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Add Stats.
+  10/16/26 (mac): Validate index record bounds on open.
+  10/16/26 (mac): Validate index record sizes against multiplicities on open.
+
+****************************************************************/
+
+#ifndef U3COEF_STORE_H_
+#define U3COEF_STORE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "sp3rlib/u3coef.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // coefficient store file format
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  // A coefficient store file holds the blocks of one coefficient
+  // cache (U, Z, W, Phi, or 9-lm), in native byte order:
+  //
+  //   header (CoefStoreHeader)
+  //
+  //   index: num_entries fixed-size records, sorted lexicographically
+  //   by label words, each consisting of
+  //
+  //     label words (num_label_words x uint64), as given by the
+  //       packed keys of the SU(3) labels (or the values of integer
+  //       labels)
+  //     payload offset (uint64), in doubles from start of payload
+  //     payload size (uint64), in doubles
+  //     multiplicities (num_multiplicities x int32, padded to a
+  //       multiple of 8 bytes), in the order of the block's Key()
+  //
+  //   payload: coefficient values (double), block by block, in the
+  //   layout of the block's data()
+  //
+  // Lookup is by binary search on the index.  Since the file is
+  // memory mapped, only the pages of the index touched by the search,
+  // and of the blocks actually retrieved, are read from disk.
+
+  enum class CoefStoreKind : std::uint32_t {kU=1, kZ=2, kW=3, kPhi=4, kNineLM=5};
+
+  struct CoefStoreHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t kind;
+    std::uint32_t num_label_words;
+    std::uint32_t num_multiplicities;
+    std::uint64_t num_entries;
+    std::uint64_t index_offset;
+    std::uint64_t payload_offset;
+    std::uint64_t payload_size;
+  };
+
+  template <typename tBlock> struct CoefStoreTraits;
+  // Coefficient kind for each block type, and power to which each
+  // multiplicity enters the block size (Phi blocks are rho_max x
+  // rho_max).
+
+  template <> struct CoefStoreTraits<u3::UCoefBlock>
+  {
+    static constexpr CoefStoreKind kKind = CoefStoreKind::kU;
+    static constexpr int kMultiplicityPower = 1;
+  };
+  template <> struct CoefStoreTraits<u3::ZCoefBlock>
+  {
+    static constexpr CoefStoreKind kKind = CoefStoreKind::kZ;
+    static constexpr int kMultiplicityPower = 1;
+  };
+  template <> struct CoefStoreTraits<u3::WCoefBlock>
+  {
+    static constexpr CoefStoreKind kKind = CoefStoreKind::kW;
+    static constexpr int kMultiplicityPower = 1;
+  };
+  template <> struct CoefStoreTraits<u3::PhiCoefBlock>
+  {
+    static constexpr CoefStoreKind kKind = CoefStoreKind::kPhi;
+    static constexpr int kMultiplicityPower = 2;
+  };
+  template <> struct CoefStoreTraits<u3::NineLMCoefBlock>
+  {
+    static constexpr CoefStoreKind kKind = CoefStoreKind::kNineLM;
+    static constexpr int kMultiplicityPower = 1;
+  };
+
+  ////////////////////////////////////////////////////////////////
+  // label and multiplicity packing
+  ////////////////////////////////////////////////////////////////
+
+  inline std::uint64_t CoefStoreWord(const u3::SU3& x)
+  {
+    return x.PackedKey();
+  }
+
+  inline std::uint64_t CoefStoreWord(int value)
+  {
+    return std::uint64_t(std::uint32_t(value));
+  }
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I==sizeof...(tElements))>::type
+    PackCoefStoreWords(const std::tuple<tElements...>&, std::uint64_t*)
+  {}
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I<sizeof...(tElements))>::type
+    PackCoefStoreWords(const std::tuple<tElements...>& key, std::uint64_t* words)
+  // Pack labels (SU(3) or int) of tuple into words.
+  {
+    words[I] = CoefStoreWord(std::get<I>(key));
+    PackCoefStoreWords<I+1>(key,words);
+  }
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I==sizeof...(tElements))>::type
+    PackCoefStoreMultiplicities(const std::tuple<tElements...>&, std::int32_t*)
+  {}
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I<sizeof...(tElements))>::type
+    PackCoefStoreMultiplicities(const std::tuple<tElements...>& multiplicities, std::int32_t* values)
+  // Pack multiplicities of tuple into int32 values.
+  {
+    values[I] = std::get<I>(multiplicities);
+    PackCoefStoreMultiplicities<I+1>(multiplicities,values);
+  }
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I==sizeof...(tElements))>::type
+    UnpackCoefStoreMultiplicities(const std::int32_t*, std::tuple<tElements...>&)
+  {}
+
+  template <std::size_t I = 0, typename... tElements>
+    inline typename std::enable_if<(I<sizeof...(tElements))>::type
+    UnpackCoefStoreMultiplicities(const std::int32_t* values, std::tuple<tElements...>& multiplicities)
+  // Unpack int32 values into multiplicities tuple.
+  {
+    std::get<I>(multiplicities) = values[I];
+    UnpackCoefStoreMultiplicities<I+1>(values,multiplicities);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // file access (non-template)
+  ////////////////////////////////////////////////////////////////
+
+  class MappedFile
+  // Read-only memory mapping of a file.
+  {
+  public:
+
+    MappedFile() : data_(nullptr), size_(0) {}
+    ~MappedFile();
+
+    // not copyable (owns mapping)
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& filename);
+    // Map file, returning false if it cannot be opened.
+
+    void Close();
+
+    const char* data() const
+    {
+      return data_;
+    }
+
+    std::size_t size() const
+    {
+      return size_;
+    }
+
+  private:
+    const char* data_;
+    std::size_t size_;
+  };
+
+  struct CoefStoreRecords
+  // Coefficient blocks gathered for writing to store.
+  {
+    CoefStoreRecords(int num_label_words_, int num_multiplicities_)
+      : num_label_words(num_label_words_), num_multiplicities(num_multiplicities_)
+    {}
+
+    int num_label_words, num_multiplicities;
+
+    // labels (num_label_words per block)
+    std::vector<std::uint64_t> label_words;
+
+    // multiplicities (num_multiplicities per block)
+    std::vector<std::int32_t> multiplicities;
+
+    // coefficient values (pointer and size per block)
+    std::vector<const double*> coefs;
+    std::vector<std::uint64_t> sizes;
+  };
+
+  void WriteCoefStoreFile(const std::string& filename, CoefStoreKind kind, const CoefStoreRecords& records);
+  // Sort records by labels and write store file.
+  //
+  // Aborts on I/O error.
+
+  const char* ValidateCoefStoreFile(
+      const std::string& filename, const MappedFile& file, CoefStoreKind kind,
+      int num_label_words, int num_multiplicities, int multiplicity_power
+    );
+  // Check header of mapped store file against expected kind and
+  // shape, and check that every index record addresses a block within
+  // the payload, of size equal to the product of its multiplicities
+  // (each at least one, and each raised to multiplicity_power),
+  // returning pointer to header.
+  //
+  // Aborts if file is malformed or of wrong kind.
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // coefficient store
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  template <typename tLabels, typename tBlock>
+  class CoefStore
+  // Memory-mapped store of coefficient blocks, with fallback to su3lib.
+  //
+  // A store is opened from a file written from a populated cache (see
+  // Write).  Blocks may then be retrieved either
+  //
+  //   - zero-copy, with Find, which returns a pointer to the
+  //     coefficients in the mapped file (together with the
+  //     multiplicities), or
+  //
+  //   - as a block object, with GetBlock, for use with code written
+  //     against the block classes (UCoefBlock, etc.).  The block is
+  //     copied from the mapped file on first access, or, if it is not
+  //     in the file, calculated with su3lib.  Either way it is then
+  //     retained in an in-memory cache.
+  //
+  // Save writes the blocks from the file together with any blocks
+  // calculated since, so that a subsequent run can start from the
+  // extended store.
+  //
+  // Find is thread-safe (the mapping is read-only).  GetBlock is not.
+  //
+  // EX:
+  //   u3::UCoefStore store("u_coefs.bin");  // missing file gives empty store
+  //   const u3::UCoefBlock& block = store.GetBlock(labels);
+  //   ...
+  //   store.Save("u_coefs.bin");
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // typedefs
+    ////////////////////////////////////////////////////////////////
+
+    typedef typename tBlock::KeyType MultiplicityType;
+
+    static constexpr int kNumLabelWords = std::tuple_size<typename tLabels::KeyType>::value;
+    static constexpr int kNumMultiplicities = std::tuple_size<MultiplicityType>::value;
+    static constexpr int kRecordWords = kNumLabelWords+2+(kNumMultiplicities+1)/2;
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    CoefStore()
+      : num_entries_(0), index_(nullptr), payload_(nullptr), hits_(0)
+    {}
+
+    explicit CoefStore(const std::string& filename)
+      : CoefStore()
+    // Construct store from file (see Open).
+    {
+      Open(filename);
+    }
+
+    // not copyable (owns mapping)
+    CoefStore(const CoefStore&) = delete;
+    CoefStore& operator=(const CoefStore&) = delete;
+
+    bool Open(const std::string& filename)
+    // Map store file.
+    //
+    // If the file does not exist, the store is left empty (so all
+    // blocks are calculated with su3lib), and false is returned.
+    // Aborts if the file is malformed or holds a different kind of
+    // coefficient.
+    {
+      Close();
+      if (!file_.Open(filename))
+        return false;
+      const CoefStoreHeader* header = reinterpret_cast<const CoefStoreHeader*>(
+          ValidateCoefStoreFile(
+              filename,file_,CoefStoreTraits<tBlock>::kKind,kNumLabelWords,kNumMultiplicities,
+              CoefStoreTraits<tBlock>::kMultiplicityPower
+            )
+        );
+      num_entries_ = header->num_entries;
+      index_ = reinterpret_cast<const std::uint64_t*>(file_.data()+header->index_offset);
+      payload_ = reinterpret_cast<const double*>(file_.data()+header->payload_offset);
+      return true;
+    }
+
+    void Close()
+    // Release mapping and in-memory blocks.
+    {
+      file_.Close();
+      num_entries_ = 0;
+      index_ = nullptr;
+      payload_ = nullptr;
+      blocks_.clear();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // retrieval
+    ////////////////////////////////////////////////////////////////
+
+    const double* Find(const tLabels& labels, MultiplicityType& multiplicities) const
+    // Look up block in mapped file.
+    //
+    // Arguments:
+    //   labels (tLabels): coefficient labels
+    //   multiplicities (MultiplicityType, output): multiplicities of
+    //     block, in order of block's Key(), if found
+    //
+    // Returns:
+    //   (const double*): pointer to coefficients (in layout of
+    //     tBlock::data()), or nullptr if not in file
+    {
+      const std::uint64_t* record = FindRecord(labels);
+      if (!record)
+        return nullptr;
+      UnpackCoefStoreMultiplicities(
+          reinterpret_cast<const std::int32_t*>(record+kNumLabelWords+2),multiplicities
+        );
+      return payload_+record[kNumLabelWords];
+    }
+
+    const tBlock& GetBlock(const tLabels& labels)
+    // Retrieve block, from in-memory cache, mapped file, or su3lib, in
+    // that order of preference.
+    {
+      auto it = blocks_.find(labels);
+      if (it!=blocks_.end())
+        {
+          ++hits_;
+          return it->second;
+        }
+      MultiplicityType multiplicities;
+      const double* coefs = Find(labels,multiplicities);
+      if (coefs)
+        {
+          ++hits_;
+          return blocks_.emplace(labels,tBlock(multiplicities,coefs)).first->second;
+        }
+      computed_.push_back(labels);
+      return blocks_.emplace(labels,tBlock(labels)).first->second;
+    }
+
+    bool Contains(const tLabels& labels) const
+    // Check if block is in mapped file.
+    {
+      return FindRecord(labels)!=nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    std::size_t num_stored() const
+    // Return number of blocks in mapped file.
+    {
+      return num_entries_;
+    }
+
+    std::size_t num_computed() const
+    // Return number of blocks calculated with su3lib since opening.
+    {
+      return computed_.size();
+    }
+
+    u3::CoefCacheStats Stats() const
+    // Return snapshot of statistics for blocks retrieved through
+    // GetBlock.
+    //
+    // Hits are blocks found in memory or in the mapped file, and
+    // misses are blocks calculated with su3lib.  The block tallies
+    // cover the in-memory blocks.
+    {
+      u3::CoefCacheStats stats = blocks_.Stats();
+      stats.hits = hits_;
+      stats.misses = computed_.size();
+      return stats;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // output
+    ////////////////////////////////////////////////////////////////
+
+    void Save(const std::string& filename) const
+    // Write blocks from mapped file together with calculated blocks.
+    //
+    // The file may be the same as that currently mapped, since the
+    // new file is written under a temporary name and then renamed.
+    {
+      CoefStoreRecords records(kNumLabelWords,kNumMultiplicities);
+      for (std::uint64_t i=0; i<num_entries_; ++i)
+        {
+          const std::uint64_t* record = index_+i*kRecordWords;
+          const std::int32_t* multiplicities = reinterpret_cast<const std::int32_t*>(record+kNumLabelWords+2);
+          records.label_words.insert(records.label_words.end(),record,record+kNumLabelWords);
+          records.multiplicities.insert(records.multiplicities.end(),multiplicities,multiplicities+kNumMultiplicities);
+          records.coefs.push_back(payload_+record[kNumLabelWords]);
+          records.sizes.push_back(record[kNumLabelWords+1]);
+        }
+      for (const tLabels& labels : computed_)
+        AddRecord(records,labels,blocks_.at(labels));
+      WriteCoefStoreFile(filename,CoefStoreTraits<tBlock>::kKind,records);
+    }
+
+    static void Write(const std::string& filename, const u3::CoefCache<tLabels,tBlock>& cache)
+    // Write blocks of cache to store file.
+    {
+      CoefStoreRecords records(kNumLabelWords,kNumMultiplicities);
+      for (const auto& labels_block : cache)
+        AddRecord(records,labels_block.first,labels_block.second);
+      WriteCoefStoreFile(filename,CoefStoreTraits<tBlock>::kKind,records);
+    }
+
+    static void Write(const std::string& filename, const u3::ConcurrentCoefCache<tLabels,tBlock>& cache)
+    // Write blocks of concurrent cache to store file.
+    //
+    // Not thread-safe with respect to concurrent insertion.
+    {
+      CoefStoreRecords records(kNumLabelWords,kNumMultiplicities);
+      cache.ForEach(
+          [&records](const tLabels& labels, const tBlock& block) {AddRecord(records,labels,block);}
+        );
+      WriteCoefStoreFile(filename,CoefStoreTraits<tBlock>::kKind,records);
+    }
+
+  private:
+
+    static void AddRecord(CoefStoreRecords& records, const tLabels& labels, const tBlock& block)
+    {
+      std::array<std::uint64_t,kNumLabelWords> words;
+      PackCoefStoreWords(labels.Key(),words.data());
+      records.label_words.insert(records.label_words.end(),words.begin(),words.end());
+      std::array<std::int32_t,kNumMultiplicities> multiplicities;
+      PackCoefStoreMultiplicities(block.Key(),multiplicities.data());
+      records.multiplicities.insert(records.multiplicities.end(),multiplicities.begin(),multiplicities.end());
+      records.coefs.push_back(block.data());
+      records.sizes.push_back(block.size());
+    }
+
+    const std::uint64_t* FindRecord(const tLabels& labels) const
+    // Binary search index for labels.
+    {
+      std::array<std::uint64_t,kNumLabelWords> words;
+      PackCoefStoreWords(labels.Key(),words.data());
+      std::uint64_t low = 0, high = num_entries_;
+      while (low<high)
+        {
+          std::uint64_t mid = low+(high-low)/2;
+          const std::uint64_t* record = index_+mid*kRecordWords;
+          if (std::lexicographical_compare(record,record+kNumLabelWords,words.begin(),words.end()))
+            low = mid+1;
+          else
+            high = mid;
+        }
+      if (low==num_entries_)
+        return nullptr;
+      const std::uint64_t* record = index_+low*kRecordWords;
+      if (!std::equal(words.begin(),words.end(),record))
+        return nullptr;
+      return record;
+    }
+
+    // mapped file
+    MappedFile file_;
+    std::uint64_t num_entries_;
+    const std::uint64_t* index_;
+    const double* payload_;
+
+    // blocks retrieved through GetBlock
+    u3::CoefCache<tLabels,tBlock> blocks_;
+
+    // labels of blocks calculated with su3lib (not in file)
+    std::vector<tLabels> computed_;
+
+    // number of GetBlock calls served from memory or file
+    long hits_;
+  };
+
+  template <typename tLabels, typename tBlock>
+    constexpr int CoefStore<tLabels,tBlock>::kNumLabelWords;
+  template <typename tLabels, typename tBlock>
+    constexpr int CoefStore<tLabels,tBlock>::kNumMultiplicities;
+  template <typename tLabels, typename tBlock>
+    constexpr int CoefStore<tLabels,tBlock>::kRecordWords;
+
+  typedef CoefStore<u3::UCoefLabels,u3::UCoefBlock> UCoefStore;
+  typedef CoefStore<u3::ZCoefLabels,u3::ZCoefBlock> ZCoefStore;
+  typedef CoefStore<u3::WCoefLabels,u3::WCoefBlock> WCoefStore;
+  typedef CoefStore<u3::PhiCoefLabels,u3::PhiCoefBlock> PhiCoefStore;
+  typedef CoefStore<u3::NineLMCoefLabels,u3::NineLMCoefBlock> NineLMCoefStore;
+
+}  // namespace
+
+#endif
@@ -0,0 +1,175 @@
+/****************************************************************
+  u3coef_store_test.cpp
+
+  Test persistent coefficient store.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+
+****************************************************************/
+
+#include "sp3rlib/u3coef_store.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// label generation
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::UCoefLabels> GenerateULabels(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+// Generate allowed U coefficient labels for given x1, x2, x3.
+{
+  std::vector<u3::UCoefLabels> label_set;
+  for (const MultiplicityTagged<u3::SU3>& x12_tagged : u3::KroneckerProduct(x1,x2))
+    for (const MultiplicityTagged<u3::SU3>& x23_tagged : u3::KroneckerProduct(x2,x3))
+      for (const MultiplicityTagged<u3::SU3>& x_tagged : u3::KroneckerProduct(x12_tagged.irrep,x3))
+        {
+          u3::UCoefLabels labels(x1,x2,x_tagged.irrep,x3,x12_tagged.irrep,x23_tagged.irrep);
+          if (labels.Allowed())
+            label_set.push_back(labels);
+        }
+  return label_set;
+}
+
+std::vector<u3::WCoefLabels> GenerateWLabels(const u3::SU3& x1, const u3::SU3& x2)
+// Generate allowed W coefficient labels for given x1, x2.
+{
+  std::vector<u3::WCoefLabels> label_set;
+  for (const MultiplicityTagged<u3::SU3>& x3_tagged : u3::KroneckerProduct(x1,x2))
+    for (int L1=0; L1<=x1.lambda()+x1.mu(); ++L1)
+      for (int L2=0; L2<=x2.lambda()+x2.mu(); ++L2)
+        for (int L3=std::abs(L1-L2); L3<=L1+L2; ++L3)
+          {
+            if ((u3::BranchingMultiplicitySO3(x1,L1)==0)
+                || (u3::BranchingMultiplicitySO3(x2,L2)==0)
+                || (u3::BranchingMultiplicitySO3(x3_tagged.irrep,L3)==0))
+              continue;
+            label_set.push_back(u3::WCoefLabels(x1,L1,x2,L2,x3_tagged.irrep,L3));
+          }
+  return label_set;
+}
+
+////////////////////////////////////////////////////////////////
+// round trip tests
+////////////////////////////////////////////////////////////////
+
+template <typename tLabels, typename tBlock>
+bool CompareBlocks(const tBlock& block1, const tBlock& block2)
+{
+  if ((block1.Key()!=block2.Key())||(block1.size()!=block2.size()))
+    return false;
+  return std::equal(block1.data(),block1.data()+block1.size(),block2.data());
+}
+
+template <typename tLabels, typename tBlock>
+bool RoundTripTest(
+    const std::string& name, const std::string& filename,
+    const std::vector<tLabels>& label_set
+  )
+// Write first half of label set to store, then retrieve full label
+// set through store (so second half falls back to su3lib), save
+// extended store, and check that all blocks are then found in file.
+{
+  std::cout << fmt::format("{} store: labels {}",name,label_set.size()) << std::endl;
+  std::size_t num_initial = label_set.size()/2;
+
+  // write initial store from cache
+  u3::CoefCache<tLabels,tBlock> cache;
+  for (std::size_t i=0; i<num_initial; ++i)
+    cache.GetBlock(label_set[i]);
+  u3::CoefStore<tLabels,tBlock>::Write(filename,cache);
+
+  // retrieve through store
+  int num_mismatches = 0;
+  std::size_t num_stored, num_computed;
+  {
+    u3::CoefStore<tLabels,tBlock> store(filename);
+    num_stored = store.num_stored();
+    for (std::size_t i=0; i<label_set.size(); ++i)
+      {
+        const tLabels& labels = label_set[i];
+        const tBlock& block = store.GetBlock(labels);
+        const tBlock& reference_block = cache.GetBlock(labels);
+        if (!CompareBlocks<tLabels,tBlock>(block,reference_block))
+          ++num_mismatches;
+      }
+    num_computed = store.num_computed();
+    store.Save(filename);
+  }
+  std::cout << fmt::format("  initial: stored {} computed {} mismatches {}",
+                           num_stored,num_computed,num_mismatches)
+            << std::endl;
+  bool pass = (num_mismatches==0) && (num_stored==num_initial) && (num_computed==label_set.size()-num_initial);
+
+  // reopen extended store and check zero-copy lookups
+  num_mismatches = 0;
+  std::size_t num_missing = 0;
+  {
+    u3::CoefStore<tLabels,tBlock> store(filename);
+    num_stored = store.num_stored();
+    for (const tLabels& labels : label_set)
+      {
+        typename tBlock::KeyType multiplicities;
+        const double* coefs = store.Find(labels,multiplicities);
+        if (!coefs)
+          {
+            ++num_missing;
+            continue;
+          }
+        const tBlock& reference_block = cache.GetBlock(labels);
+        if ((multiplicities!=reference_block.Key())
+            || !std::equal(reference_block.data(),reference_block.data()+reference_block.size(),coefs))
+          ++num_mismatches;
+      }
+    num_computed = store.num_computed();
+  }
+  std::cout << fmt::format("  extended: stored {} missing {} mismatches {}",
+                           num_stored,num_missing,num_mismatches)
+            << std::endl;
+  pass &= (num_mismatches==0) && (num_missing==0) && (num_stored==label_set.size());
+
+  std::remove(filename.c_str());
+  return pass;
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  u3::U3CoefInit();
+
+  bool pass = true;
+
+  // U and Z coefficients
+  std::vector<u3::UCoefLabels> u_label_set = GenerateULabels(u3::SU3(4,0),u3::SU3(3,2),u3::SU3(2,3));
+  pass &= RoundTripTest<u3::UCoefLabels,u3::UCoefBlock>("U","u3coef_store_test_u.bin",u_label_set);
+  pass &= RoundTripTest<u3::ZCoefLabels,u3::ZCoefBlock>("Z","u3coef_store_test_z.bin",u_label_set);
+
+  // W coefficients
+  std::vector<u3::WCoefLabels> w_label_set = GenerateWLabels(u3::SU3(4,2),u3::SU3(2,2));
+  pass &= RoundTripTest<u3::WCoefLabels,u3::WCoefBlock>("W","u3coef_store_test_w.bin",w_label_set);
+
+  // Phi coefficients
+  std::vector<u3::PhiCoefLabels> phi_label_set;
+  for (const MultiplicityTagged<u3::SU3>& x3_tagged : u3::KroneckerProduct(u3::SU3(4,2),u3::SU3(3,3)))
+    phi_label_set.push_back(u3::PhiCoefLabels(u3::SU3(4,2),u3::SU3(3,3),x3_tagged.irrep));
+  pass &= RoundTripTest<u3::PhiCoefLabels,u3::PhiCoefBlock>("Phi","u3coef_store_test_phi.bin",phi_label_set);
+
+  // missing file gives empty store
+  u3::UCoefStore empty_store("u3coef_store_test_missing.bin");
+  pass &= (empty_store.num_stored()==0) && !empty_store.Contains(u_label_set[0]);
+
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
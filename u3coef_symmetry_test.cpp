@@ -0,0 +1,301 @@
+/****************************************************************
+  u3coef_symmetry_test.cpp
+
+  Validate symmetries used in canonicalized coefficient caching,
+  against su3lib.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created.
+  10/16/26 (mac): Add W exchange symmetry.
+  10/16/26 (mac): Require blocks with outer multiplicity and check EnableUSymmetry.
+  10/16/26 (mac): Likewise for W exchange.
+
+****************************************************************/
+
+#include "sp3rlib/u3coef.h"
+#include "sp3rlib/u3coef_prefill.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "fmt/format.h"
+
+////////////////////////////////////////////////////////////////
+// label generation
+////////////////////////////////////////////////////////////////
+
+std::vector<u3::UCoefLabels> GenerateULabels(int lm_max)
+// Generate distinct allowed U coefficient labels (x1,x2,x,x3,x12,x23),
+// for x1,x2,x3 with lambda,mu<=lm_max.
+{
+  std::vector<u3::SU3> irreps;
+  for (int lambda=0; lambda<=lm_max; ++lambda)
+    for (int mu=0; mu<=lm_max; ++mu)
+      irreps.push_back(u3::SU3(lambda,mu));
+
+  std::vector<u3::UCoefLabels> label_set;
+  for (const u3::SU3& x1 : irreps)
+    for (const u3::SU3& x2 : irreps)
+      for (const u3::SU3& x3 : irreps)
+        for (const MultiplicityTagged<u3::SU3>& x12_rho : u3::KroneckerProduct(x1,x2))
+          for (const MultiplicityTagged<u3::SU3>& x_rho : u3::KroneckerProduct(x12_rho.irrep,x3))
+            for (const MultiplicityTagged<u3::SU3>& x23_rho : u3::KroneckerProduct(x2,x3))
+              {
+                u3::UCoefLabels labels(x1,x2,x_rho.irrep,x3,x12_rho.irrep,x23_rho.irrep);
+                if (labels.Allowed())
+                  label_set.push_back(labels);
+              }
+  std::sort(label_set.begin(),label_set.end());
+  label_set.erase(std::unique(label_set.begin(),label_set.end()),label_set.end());
+  return label_set;
+}
+
+std::vector<u3::WCoefLabels> GenerateWLabels(int lm_max)
+// Generate distinct allowed W coefficient labels (x1,L1,x2,L2,x3,L3),
+// for x1,x2 with lambda,mu<=lm_max.
+{
+  std::vector<u3::WCoefLabels> label_set;
+  for (int lambda1=0; lambda1<=lm_max; ++lambda1)
+    for (int mu1=0; mu1<=lm_max; ++mu1)
+      for (int lambda2=0; lambda2<=lm_max; ++lambda2)
+        for (int mu2=0; mu2<=lm_max; ++mu2)
+          {
+            u3::SU3 x1(lambda1,mu1), x2(lambda2,mu2);
+            for (const MultiplicityTagged<u3::SU3>& x3_rho : u3::KroneckerProduct(x1,x2))
+              for (const MultiplicityTagged<int>& L1_kappa : u3::BranchingSO3(x1))
+                for (const MultiplicityTagged<int>& L2_kappa : u3::BranchingSO3(x2))
+                  for (const MultiplicityTagged<int>& L3_kappa : u3::BranchingSO3(x3_rho.irrep))
+                    {
+                      int L1 = L1_kappa.irrep, L2 = L2_kappa.irrep, L3 = L3_kappa.irrep;
+                      if ((L3<std::abs(L1-L2))||(L3>L1+L2))
+                        continue;
+                      label_set.push_back(u3::WCoefLabels(x1,L1,x2,L2,x3_rho.irrep,L3));
+                    }
+          }
+  return label_set;
+}
+
+////////////////////////////////////////////////////////////////
+// U and Z conjugation symmetry
+////////////////////////////////////////////////////////////////
+
+bool UZConjugationTest(const std::vector<u3::UCoefLabels>& label_set, u3::UZMode mode)
+// Compare blocks for labels and conjugate labels, as calculated by
+// su3lib, under the conjugation phase (UConjugationPhase).
+//
+// Mismatches are tallied separately for multiplicity-free blocks
+// (which only test the cancellation of grade phases) and blocks with
+// outer multiplicity (which also test the multiplicity phase
+// convention).  The test fails if the label set includes no blocks
+// with outer multiplicity.
+{
+  const double kTolerance = 1e-12;
+  int num_mismatches_free = 0, num_mismatches_multiplicity = 0;
+  std::size_t num_blocks_free = 0, num_blocks_multiplicity = 0;
+  for (const u3::UCoefLabels& labels : label_set)
+    {
+      u3::SU3 x1,x2,x,x3,x12,x23;
+      std::vector<double> block, conjugate_block;
+      std::tie(x1,x2,x,x3,x12,x23) = labels.Key();
+      u3::UMultiplicityTuple multiplicities = u3::UZBlock(x1,x2,x,x3,x12,x23,mode,block);
+      std::tie(x1,x2,x,x3,x12,x23) = labels.Conjugate().Key();
+      u3::UZBlock(x1,x2,x,x3,x12,x23,mode,conjugate_block);
+
+      int r12_max, r12_3_max, r23_max, r1_23_max;
+      std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = multiplicities;
+      bool multiplicity_free = (block.size()==1);
+      (multiplicity_free ? num_blocks_free : num_blocks_multiplicity)++;
+      bool mismatch = false;
+      for (int r12=1; r12<=r12_max; ++r12)
+        for (int r12_3=1; r12_3<=r12_3_max; ++r12_3)
+          for (int r23=1; r23<=r23_max; ++r23)
+            for (int r1_23=1; r1_23<=r1_23_max; ++r1_23)
+              {
+                int index = u3::UZBlockIndex(multiplicities,r12,r12_3,r23,r1_23);
+                int phase = u3::UConjugationPhase(multiplicities,r12,r12_3,r23,r1_23);
+                if (std::fabs(conjugate_block[index]-phase*block[index])>kTolerance)
+                  mismatch = true;
+              }
+      if (mismatch)
+        {
+          (multiplicity_free ? num_mismatches_free : num_mismatches_multiplicity)++;
+          if (num_mismatches_free+num_mismatches_multiplicity<=10)
+            std::cout << "  mismatch " << labels.Str() << std::endl;
+        }
+    }
+
+  std::cout << fmt::format(
+      "  {} conjugation: multiplicity-free blocks {} mismatches {}, other blocks {} mismatches {}",
+      (mode==u3::UZMode::kU ? "U" : "Z"),
+      num_blocks_free,num_mismatches_free,num_blocks_multiplicity,num_mismatches_multiplicity
+    ) << std::endl;
+  return (num_mismatches_free+num_mismatches_multiplicity==0)&&(num_blocks_multiplicity>0);
+}
+
+bool UCachedSymmetryTest(const std::vector<u3::UCoefLabels>& label_set)
+// Compare coefficients retrieved through canonicalized cache with
+// direct calculation.
+{
+  bool saved_symmetry_enabled = u3::g_u_symmetry_enabled;
+  u3::EnableUSymmetry();
+
+  u3::UCoefCache cache;
+  int num_mismatches = 0;
+  for (const u3::UCoefLabels& labels : label_set)
+    {
+      u3::SU3 x1,x2,x,x3,x12,x23;
+      std::tie(x1,x2,x,x3,x12,x23) = labels.Key();
+      int r12_max, r12_3_max, r23_max, r1_23_max;
+      std::tie(r12_max,r12_3_max,r23_max,r1_23_max) = u3::UMultiplicity(x1,x2,x,x3,x12,x23);
+      for (int r12=1; r12<=r12_max; ++r12)
+        for (int r12_3=1; r12_3<=r12_3_max; ++r12_3)
+          for (int r23=1; r23<=r23_max; ++r23)
+            for (int r1_23=1; r1_23<=r1_23_max; ++r1_23)
+              {
+                double coef_cached = u3::UCached(cache,x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+                double coef_direct = u3::U(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+                if (std::fabs(coef_cached-coef_direct)>1e-12)
+                  ++num_mismatches;
+              }
+    }
+
+  // prefill gives same canonical blocks
+  u3::UCoefCache prefilled_cache;
+  u3::PrefillUCache(prefilled_cache,label_set,1);
+  bool prefill_match = (prefilled_cache.size()==cache.size());
+
+  std::cout << fmt::format(
+      "  U cached: labels {} canonical blocks {} prefilled blocks {} mismatches {}",
+      label_set.size(),cache.size(),prefilled_cache.size(),num_mismatches
+    ) << std::endl;
+
+  u3::g_u_symmetry_enabled = saved_symmetry_enabled;
+  return (num_mismatches==0)&&prefill_match;
+}
+
+////////////////////////////////////////////////////////////////
+// W exchange symmetry
+////////////////////////////////////////////////////////////////
+
+bool WExchangeTest(const std::vector<u3::WCoefLabels>& label_set)
+// Compare W blocks, as calculated by su3lib, with those recovered
+// from the exchanged labels.
+//
+// Mismatches are tallied separately for blocks with rho_max=1 (which
+// test only the exchange phase) and with outer multiplicity (which
+// also test the orientation of the Phi matrix).  The test fails if the
+// label set includes no blocks with outer multiplicity.
+{
+  const double kTolerance = 1e-12;
+  int num_mismatches_free = 0, num_mismatches_multiplicity = 0;
+  std::size_t num_blocks_free = 0, num_blocks_multiplicity = 0;
+  for (const u3::WCoefLabels& labels : label_set)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+      std::vector<double> block, exchanged_block;
+      u3::WMultiplicityTuple multiplicities = u3::WBlock(x1,L1,x2,L2,x3,L3,block);
+      u3::WMultiplicityTuple exchanged_multiplicities = u3::WBlock(x2,L2,x1,L1,x3,L3,exchanged_block);
+
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = multiplicities;
+      bool multiplicity_free = (rho_max==1);
+      (multiplicity_free ? num_blocks_free : num_blocks_multiplicity)++;
+      bool mismatch = false;
+      for (int rho=1; rho<=rho_max; ++rho)
+        for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+          for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+            for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+              {
+                double value = 0.;
+                for (int rhop=1; rhop<=rho_max; ++rhop)
+                  value += u3::Phi(x1,x2,x3,rho,rhop)
+                    *exchanged_block[u3::WBlockIndex(exchanged_multiplicities,kappa2,kappa1,kappa3,rhop)];
+                value *= ParitySign(L1+L2-L3);
+                if (std::fabs(block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)]-value)>kTolerance)
+                  mismatch = true;
+              }
+      if (mismatch)
+        {
+          (multiplicity_free ? num_mismatches_free : num_mismatches_multiplicity)++;
+          if (num_mismatches_free+num_mismatches_multiplicity<=10)
+            std::cout << "  mismatch " << labels.Str() << std::endl;
+        }
+    }
+
+  std::cout << fmt::format(
+      "  W exchange: rho_max=1 blocks {} mismatches {}, other blocks {} mismatches {}",
+      num_blocks_free,num_mismatches_free,num_blocks_multiplicity,num_mismatches_multiplicity
+    ) << std::endl;
+  return (num_mismatches_free+num_mismatches_multiplicity==0)&&(num_blocks_multiplicity>0);
+}
+
+bool WCachedSymmetryTest(const std::vector<u3::WCoefLabels>& label_set)
+// Compare coefficients retrieved through exchange-symmetric cache with
+// direct calculation.
+{
+  u3::SymmetricWCoefCache cache;
+  int num_mismatches = 0;
+  for (const u3::WCoefLabels& labels : label_set)
+    {
+      u3::SU3 x1,x2,x3;
+      int L1,L2,L3;
+      std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
+      int kappa1_max, kappa2_max, kappa3_max, rho_max;
+      std::tie(kappa1_max,kappa2_max,kappa3_max,rho_max) = u3::WMultiplicity(x1,L1,x2,L2,x3,L3);
+      for (int rho=1; rho<=rho_max; ++rho)
+        for (int kappa1=1; kappa1<=kappa1_max; ++kappa1)
+          for (int kappa2=1; kappa2<=kappa2_max; ++kappa2)
+            for (int kappa3=1; kappa3<=kappa3_max; ++kappa3)
+              {
+                double coef_cached = u3::WCached(cache,x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+                double coef_direct = u3::W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+                if (std::fabs(coef_cached-coef_direct)>1e-12)
+                  ++num_mismatches;
+              }
+    }
+
+  std::cout << fmt::format(
+      "  W cached: labels {} canonical blocks {} Phi blocks {} mismatches {}",
+      label_set.size(),cache.size(),cache.phi_cache().size(),num_mismatches
+    ) << std::endl;
+  return (num_mismatches==0);
+}
+
+////////////////////////////////////////////////////////////////
+// main
+////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  // usage: u3coef_symmetry_test [lm_max]
+  int lm_max = (argc>1) ? std::atoi(argv[1]) : 2;
+
+  u3::U3CoefInit();
+
+  std::vector<u3::UCoefLabels> label_set = GenerateULabels(lm_max);
+  std::cout << fmt::format("U/Z labels: lm_max {} distinct {}",lm_max,label_set.size()) << std::endl;
+
+  bool pass = true;
+  pass &= UZConjugationTest(label_set,u3::UZMode::kU);
+  pass &= UZConjugationTest(label_set,u3::UZMode::kZ);
+  pass &= u3::CheckUConjugationSymmetry(lm_max,&std::cout);
+  pass &= UCachedSymmetryTest(label_set);
+
+  std::vector<u3::WCoefLabels> w_label_set = GenerateWLabels(lm_max);
+  std::cout << fmt::format("W labels: lm_max {} distinct {}",lm_max,w_label_set.size()) << std::endl;
+  pass &= WExchangeTest(w_label_set);
+  pass &= u3::CheckWExchangeSymmetry(lm_max,&std::cout);
+  pass &= WCachedSymmetryTest(w_label_set);
+
+  std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+  return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -18,7 +18,10 @@
 // #include "utilities/utilities.h"
 #include "sp3rlib/u3.h"
 #include "sp3rlib/u3coef.h"
+#include <algorithm>
 #include <map>
+#include <string>
+#include <type_traits>
 
 void basic_test()
 {
@@ -72,7 +75,72 @@ void block_test()
   std::cout << "multiplicities " << r12_max << " " << r12_3_max << " " << r23_max << " " << r1_23_max << std::endl;
   std::cout << block.GetCoef(1,1,1,1) << std::endl;
   std::cout << std::endl;
-  
+
+  // block wrappers
+  //
+  // Compare each block entry with single-coefficient wrapper.
+  std::cout << "Block wrapper test" << std::endl;
+  std::vector<double> coef_block;
+  {
+    u3::SU3 x1(4,2), x2(2,2), x3(2,2), x12(4,2), x23(2,2), x(4,2);
+    u3::UMultiplicityTuple multiplicities = u3::ZBlock(x1,x2,x,x3,x12,x23,coef_block);
+    std::tie(r12_max, r12_3_max, r23_max, r1_23_max) = multiplicities;
+    std::cout << "Z multiplicities " << r12_max << " " << r12_3_max << " " << r23_max << " " << r1_23_max << std::endl;
+    for (int r12 = 1; r12 <= r12_max; ++r12)
+      for (int r12_3 = 1; r12_3 <= r12_3_max; ++r12_3)
+        for (int r23 = 1; r23 <= r23_max; ++r23)
+          for (int r1_23 = 1; r1_23 <= r1_23_max; ++r1_23)
+            {
+              double coef_block_value = coef_block[u3::UZBlockIndex(multiplicities,r12,r12_3,r23,r1_23)];
+              double coef_direct = u3::Z(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
+              if (coef_block_value != coef_direct)
+                std::cout << "  Z mismatch " << coef_block_value << " " << coef_direct << std::endl;
+            }
+  }
+  {
+    u3::SU3 x1(4,2), x2(2,2), x3(4,2);
+    int L1=2, L2=2, L3=2;
+    int kappa1_max, kappa2_max, kappa3_max, rho_max;
+    u3::WMultiplicityTuple multiplicities = u3::WBlock(x1,L1,x2,L2,x3,L3,coef_block);
+    std::tie(kappa1_max, kappa2_max, kappa3_max, rho_max) = multiplicities;
+    std::cout << "W multiplicities " << kappa1_max << " " << kappa2_max << " " << kappa3_max << " " << rho_max << std::endl;
+    for (int kappa1 = 1; kappa1 <= kappa1_max; ++kappa1)
+      for (int kappa2 = 1; kappa2 <= kappa2_max; ++kappa2)
+        for (int kappa3 = 1; kappa3 <= kappa3_max; ++kappa3)
+          for (int rho = 1; rho <= rho_max; ++rho)
+            {
+              double coef_block_value = coef_block[u3::WBlockIndex(multiplicities,kappa1,kappa2,kappa3,rho)];
+              double coef_direct = u3::W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
+              if (coef_block_value != coef_direct)
+                std::cout << "  W mismatch " << coef_block_value << " " << coef_direct << std::endl;
+            }
+  }
+  {
+    u3::SU3 x1(2,2), x2(2,2), x12(2,2), x3(1,1), x4(1,1), x34(1,1), x13(2,2), x24(1,1), x(2,2);
+    int r12_max, r34_max, r12_34_max, r13_max, r24_max, r13_24_max;
+    u3::NineLMMultiplicityTuple multiplicities
+      = u3::Unitary9LambdaMuBlock(x1,x2,x12,x3,x4,x34,x13,x24,x,coef_block);
+    std::tie(r12_max, r34_max, r12_34_max, r13_max, r24_max, r13_24_max) = multiplicities;
+    std::cout << "9-lm multiplicities " << r12_max << " " << r34_max << " " << r12_34_max
+              << " " << r13_max << " " << r24_max << " " << r13_24_max << std::endl;
+    for (int r12 = 1; r12 <= r12_max; ++r12)
+      for (int r34 = 1; r34 <= r34_max; ++r34)
+        for (int r12_34 = 1; r12_34 <= r12_34_max; ++r12_34)
+          for (int r13 = 1; r13 <= r13_max; ++r13)
+            for (int r24 = 1; r24 <= r24_max; ++r24)
+              for (int r13_24 = 1; r13_24 <= r13_24_max; ++r13_24)
+                {
+                  double coef_block_value
+                    = coef_block[u3::Unitary9LambdaMuBlockIndex(multiplicities,r12,r34,r12_34,r13,r24,r13_24)];
+                  double coef_direct = u3::Unitary9LambdaMu(
+                      x1,x2,x12,r12,x3,x4,x34,r34,x13,x24,x,r13_24,r13,r24,r12_34
+                    );
+                  if (coef_block_value != coef_direct)
+                    std::cout << "  9-lm mismatch " << coef_block_value << " " << coef_direct << std::endl;
+                }
+  }
+  std::cout << std::endl;
+
 }
 
 void iteration_test()
@@ -167,7 +235,7 @@ void caching_test()
       //  std::cout << "  duplicate " << labels.Str() << std::endl;
       if ((u_coef_cache.size()%100)==0)
         std::cout << "  cache size " << u_coef_cache.size() << "..." << std::endl;
-      u_coef_cache[labels] = u3::UCoefBlock(labels);
+      u_coef_cache.GetBlock(labels);
     }
   std::cout << "  cached " << u_coef_cache.size() << std::endl;
 
@@ -180,7 +248,7 @@ void caching_test()
       std::tie(x1,x2,x,x3,x12,x23) = labels.Key();
 
       // retrieve coefficient block
-      const u3::UCoefBlock& block = u_coef_cache[labels];
+      const u3::UCoefBlock& block = u_coef_cache.GetBlock(labels);
 
       // retrieve multiplicities
       int r12_max, r12_3_max, r23_max, r1_23_max;
@@ -195,7 +263,8 @@ void caching_test()
               {
                 double coef_direct = u3::U(x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
                 double coef_cached = u3::UCached(u_coef_cache,x1,x2,x,x3,x12,r12,r12_3,x23,r23,r1_23);
-                bool compare_ok = (coef_direct == coef_cached);
+                double coef_view = block.data()[block.Index(r12,r12_3,r23,r1_23)];
+                bool compare_ok = (coef_direct == coef_cached) && (coef_direct == coef_view);
                 if (!compare_ok)
                   std::cout << " " << coef_direct << " " << coef_cached << " " << compare_ok << std::endl;
               }
@@ -204,6 +273,178 @@ void caching_test()
 
 }
 
+template <typename tLabels>
+std::vector<tLabels> RecouplingLabelSet(const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3)
+// Generate allowed U or Z coefficient labels for given x1, x2, x3.
+{
+  std::vector<tLabels> label_set;
+  for (const MultiplicityTagged<u3::SU3>& x12_tagged : KroneckerProduct(x1,x2))
+    for (const MultiplicityTagged<u3::SU3>& x23_tagged : KroneckerProduct(x2,x3))
+      for (const MultiplicityTagged<u3::SU3>& x_tagged : KroneckerProduct(x12_tagged.irrep,x3))
+        {
+          tLabels labels(x1,x2,x_tagged.irrep,x3,x12_tagged.irrep,x23_tagged.irrep);
+          if (labels.Allowed())
+            label_set.push_back(labels);
+        }
+  return label_set;
+}
+
+std::vector<u3::NineLMCoefLabels> NineLMLabelSet(
+    const u3::SU3& x1, const u3::SU3& x2, const u3::SU3& x3, const u3::SU3& x4
+  )
+// Generate allowed 9-(lambda,mu) labels for given x1, x2, x3, x4.
+{
+  std::vector<u3::NineLMCoefLabels> label_set;
+  for (const MultiplicityTagged<u3::SU3>& x12_tagged : KroneckerProduct(x1,x2))
+    for (const MultiplicityTagged<u3::SU3>& x34_tagged : KroneckerProduct(x3,x4))
+      for (const MultiplicityTagged<u3::SU3>& x13_tagged : KroneckerProduct(x1,x3))
+        for (const MultiplicityTagged<u3::SU3>& x24_tagged : KroneckerProduct(x2,x4))
+          for (const MultiplicityTagged<u3::SU3>& x_tagged : KroneckerProduct(x12_tagged.irrep,x34_tagged.irrep))
+            {
+              u3::NineLMCoefLabels labels(
+                  x1,x2,x12_tagged.irrep,x3,x4,x34_tagged.irrep,
+                  x13_tagged.irrep,x24_tagged.irrep,x_tagged.irrep
+                );
+              if (labels.Allowed())
+                label_set.push_back(labels);
+            }
+  return label_set;
+}
+
+template <typename tLabels, typename tCache>
+int block_caching_test(const std::string& name, tCache& cache, const std::vector<tLabels>& label_set, int num_passes=1)
+// Compare blocks retrieved from cache with blocks calculated directly.
+//
+// Each block is constructed afresh from its labels before retrieval
+// from the cache, since a bounded cache may invalidate the reference
+// returned by GetBlock on the next retrieval.
+//
+// Returns number of mismatched blocks.
+{
+  typedef typename std::decay<decltype(cache.GetBlock(label_set.front()))>::type BlockType;
+  std::cout << "Checking cached " << name << " blocks" << std::endl;
+  int num_mismatches = 0;
+  for (int pass=0; pass<num_passes; ++pass)
+    for (const tLabels& labels : label_set)
+      {
+        const BlockType direct_block(labels);
+        const BlockType& block = cache.GetBlock(labels);
+        if ((block.Key()!=direct_block.Key())
+            ||!std::equal(block.data(),block.data()+block.size(),direct_block.data()))
+          {
+            ++num_mismatches;
+            std::cout << "  mismatch " << labels.Str() << std::endl;
+          }
+      }
+  std::cout << "  blocks " << label_set.size() << " passes " << num_passes
+            << " mismatches " << num_mismatches << std::endl;
+  return num_mismatches;
+}
+
+int z_caching_test()
+// Test serial and concurrent caches for Z coefficients
+{
+  std::vector<u3::ZCoefLabels> label_set
+    = RecouplingLabelSet<u3::ZCoefLabels>(u3::SU3(4,0),u3::SU3(3,2),u3::SU3(2,3));
+  u3::ZCoefCache z_coef_cache;
+  u3::ConcurrentZCoefCache concurrent_z_coef_cache;
+  return block_caching_test("Z",z_coef_cache,label_set)
+    + block_caching_test("concurrent Z",concurrent_z_coef_cache,label_set);
+}
+
+int nine_lm_caching_test()
+// Test cache for 9-(lambda,mu) symbols
+{
+  std::vector<u3::NineLMCoefLabels> label_set
+    = NineLMLabelSet(u3::SU3(2,1),u3::SU3(1,2),u3::SU3(1,1),u3::SU3(2,0));
+  u3::NineLMCoefCache nine_lm_cache;
+  return block_caching_test("9-lm",nine_lm_cache,label_set);
+}
+
+int bounded_caching_test()
+// Test memory-bounded cache for U coefficients
+{
+  std::vector<u3::UCoefLabels> label_set
+    = RecouplingLabelSet<u3::UCoefLabels>(u3::SU3(4,0),u3::SU3(3,2),u3::SU3(2,3));
+  std::size_t total_bytes = 0;
+  for (const u3::UCoefLabels& labels : label_set)
+    total_bytes += u3::BoundedUCoefCache::EntryBytes(u3::UCoefBlock(labels));
+
+  // bounded to a quarter of the full footprint, two passes over labels
+  u3::BoundedUCoefCache bounded_cache(total_bytes/4);
+  int num_mismatches = block_caching_test("bounded U",bounded_cache,label_set,2);
+  std::cout << fmt::format(
+      "  total bytes {} budget {} bytes {} blocks {} hits {} misses {} evictions {} recomputes {}",
+      total_bytes,bounded_cache.byte_budget(),bounded_cache.bytes(),bounded_cache.size(),
+      bounded_cache.hits(),bounded_cache.misses(),bounded_cache.evictions(),bounded_cache.recomputes()
+    ) << std::endl;
+  if (bounded_cache.bytes()>bounded_cache.byte_budget())
+    ++num_mismatches;
+  u3::CoefCacheStats stats = bounded_cache.Stats();
+  // every second-pass miss is a recomputation (false positives may
+  // add a few more)
+  if ((stats.recomputes!=bounded_cache.recomputes())
+      ||(stats.recomputes<long(label_set.size()))||(stats.recomputes>stats.misses))
+    ++num_mismatches;
+
+  // shrinking budget evicts down to new budget
+  bounded_cache.set_byte_budget(total_bytes/16);
+  std::cout << fmt::format("  after shrinking budget to {}: bytes {} blocks {}",
+                           bounded_cache.byte_budget(),bounded_cache.bytes(),bounded_cache.size())
+            << std::endl;
+  if (bounded_cache.bytes()>bounded_cache.byte_budget())
+    ++num_mismatches;
+  return num_mismatches;
+}
+
+int stats_test()
+// Test cache statistics and su3lib timing report
+{
+  std::vector<u3::UCoefLabels> label_set
+    = RecouplingLabelSet<u3::UCoefLabels>(u3::SU3(4,0),u3::SU3(3,2),u3::SU3(2,3));
+
+  // two passes over labels, so second pass gives only hits
+  u3::ResetSu3libStats();
+  u3::UCoefCache u_coef_cache;
+  u3::ConcurrentUCoefCache concurrent_cache;
+  for (int pass=0; pass<2; ++pass)
+    for (const u3::UCoefLabels& labels : label_set)
+      {
+        u_coef_cache.GetBlock(labels);
+        concurrent_cache.GetBlock(labels);
+      }
+
+  // check counters
+  u3::CoefCacheStats stats = u_coef_cache.Stats();
+  u3::CoefCacheStats concurrent_stats = concurrent_cache.Stats();
+  bool pass
+    = (stats.hits==long(label_set.size()))&&(stats.misses==long(label_set.size()))
+    && (stats.blocks==label_set.size())
+    && (concurrent_stats.hits==stats.hits)&&(concurrent_stats.misses==stats.misses)
+    && (concurrent_stats.coefs==stats.coefs)
+    && (u3::GetSu3libStats(u3::Su3libRoutine::kWRU3).calls==2*long(label_set.size()));
+
+  // hits counted from several threads
+  u3::ConcurrentUCoefCache parallel_cache;
+  for (int repetition=0; repetition<2; ++repetition)
+    {
+      #pragma omp parallel for schedule(dynamic,16)
+      for (std::size_t i=0; i<label_set.size(); ++i)
+        parallel_cache.GetBlock(label_set[i]);
+    }
+  pass = pass && (parallel_cache.hits()+parallel_cache.misses()==2*long(label_set.size()))
+    && (parallel_cache.misses()==long(label_set.size()));
+  std::cout << "Checking cache statistics " << (pass ? "ok" : "MISMATCH") << std::endl;
+  stats.Report(std::cout,"U");
+  concurrent_stats.Report(std::cout,"ConcurrentU");
+  u3::Su3libReport(std::cout);
+
+  // copy survives release of original cache's arena
+  u3::UCoefCache copy_cache(u_coef_cache);
+  u_coef_cache.clear();
+  return (pass ? 0 : 1) + block_caching_test("copied U",copy_cache,label_set);
+}
+
 void OrthogonalitySum1(const u3::SU3& x1, const u3::SU3& x2)
 {
   MultiplicityTagged<u3::SU3>::vector product=KroneckerProduct(x1,x2);
@@ -415,7 +656,7 @@ void caching_W_test()
       //  std::cout << "  duplicate " << labels.Str() << std::endl;
       // if ((w_coef_cache.size()%1000)==0)
       //   std::cout << "  cache size " << w_coef_cache.size() << "..." << std::endl;
-      w_coef_cache[labels] = u3::WCoefBlock(labels);
+      w_coef_cache.GetBlock(labels);
     }
   std::cout << "  cached " << w_coef_cache.size() << std::endl;
 
@@ -429,7 +670,7 @@ void caching_W_test()
       std::tie(x1,L1,x2,L2,x3,L3) = labels.Key();
 
       // retrieve coefficient block
-      const u3::WCoefBlock& block = w_coef_cache[labels];
+      const u3::WCoefBlock& block = w_coef_cache.GetBlock(labels);
 
       // retrieve multiplicities
       int rho_max, kappa1_max, kappa2_max, kappa3_max;
@@ -443,7 +684,8 @@ void caching_W_test()
                 
                 double coef_direct = u3::W(x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
                 double coef_cached = u3::WCached(w_coef_cache,x1,kappa1,L1,x2,kappa2,L2,x3,kappa3,L3,rho);
-                bool compare_ok = (coef_direct == coef_cached);
+                double coef_view = block.data()[block.Index(kappa1,kappa2,kappa3,rho)];
+                bool compare_ok = (coef_direct == coef_cached) && (coef_direct == coef_view);
                 if (!compare_ok)
                   std::cout << " " << coef_direct << " " << coef_cached << " " << compare_ok << std::endl;
               }
@@ -531,7 +773,7 @@ void phi_caching_test()
     {
       if ((phi_coef_cache.size()%100)==0)
         std::cout << "  cache size " << phi_coef_cache.size() << "..." << std::endl;
-      phi_coef_cache[labels] = u3::PhiCoefBlock(labels);
+      phi_coef_cache.GetBlock(labels);
     }
   std::cout << "  cached " << phi_coef_cache.size() << std::endl;
 
@@ -603,6 +845,11 @@ int main(int argc, char **argv)
 
   // // test cache storage and retrieval
   // caching_test();  
+  int num_failures = 0;
+  num_failures += z_caching_test();
+  num_failures += nine_lm_caching_test();
+  num_failures += bounded_caching_test();
+  num_failures += stats_test();
 
   //test symmetries of W coefficients 
   int lm_max=4;
@@ -742,4 +989,5 @@ int main(int argc, char **argv)
   //         std::cout << std::endl;
 
 
+  return (num_failures>0) ? EXIT_FAILURE : EXIT_SUCCESS;
 }
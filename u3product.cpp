@@ -0,0 +1,192 @@
+/****************************************************************
+  u3product.cpp
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+****************************************************************/
+
+#include "sp3rlib/u3product.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  // multi-fold Kronecker product
+  ////////////////////////////////////////////////////////////////
+
+  static void AccumulateMultiplicity(std::int64_t& total, std::int64_t multiplicity, int rho_max)
+  // Add multiplicity*rho_max to total, checking for 64-bit overflow.
+  {
+    if (
+        (multiplicity>(INT64_MAX/rho_max))
+        || (total>INT64_MAX-multiplicity*rho_max)
+      )
+      {
+        std::cerr << "ERROR: multi-fold Kronecker product multiplicity exceeds 64-bit range" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    total += multiplicity*rho_max;
+  }
+
+  static int NarrowMultiplicity(std::int64_t multiplicity, const u3::SU3& x)
+  // Convert multiplicity to int, for MultiplicityTagged, checking for
+  // overflow.
+  {
+    if (multiplicity>INT_MAX)
+      {
+        std::cerr << "ERROR: multiplicity " << multiplicity << " of " << x.Str()
+                  << " in multi-fold Kronecker product exceeds int range"
+                  << " (use MultiKroneckerDAG node multiplicities)" << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+    return int(multiplicity);
+  }
+
+  MultiplicityTagged<u3::SU3>::vector MultiKroneckerProduct(
+      const std::vector<u3::SU3>& factors,
+      u3::KroneckerProductCache& cache
+    )
+  {
+    // start from trivial irrep
+    std::map<u3::SU3,std::int64_t> current, next;
+    current[u3::SU3(0,0)] = 1;
+
+    // couple successive factors
+    for (const u3::SU3& factor : factors)
+      {
+        next.clear();
+        for (const auto& x_multiplicity : current)
+          {
+            const KroneckerProductCache::ProductType& product = cache.Get(x_multiplicity.first,factor);
+            for (const MultiplicityTagged<u3::SU3>& x_rho : product)
+              AccumulateMultiplicity(next[x_rho.irrep],x_multiplicity.second,x_rho.tag);
+          }
+        current.swap(next);
+      }
+
+    // convert to tagged vector
+    MultiplicityTagged<u3::SU3>::vector decomposition;
+    decomposition.reserve(current.size());
+    for (const auto& x_multiplicity : current)
+      decomposition.push_back(
+          MultiplicityTagged<u3::SU3>(
+              x_multiplicity.first,
+              NarrowMultiplicity(x_multiplicity.second,x_multiplicity.first)
+            )
+        );
+    return decomposition;
+  }
+
+  MultiplicityTagged<u3::SU3>::vector MultiKroneckerProduct(const std::vector<u3::SU3>& factors)
+  {
+    u3::KroneckerProductCache cache;
+    return MultiKroneckerProduct(factors,cache);
+  }
+
+  MultiKroneckerDAG::MultiKroneckerDAG(const std::vector<u3::SU3>& factors, u3::KroneckerProductCache& cache)
+    : factors_(factors)
+  {
+    Build(cache);
+  }
+
+  MultiKroneckerDAG::MultiKroneckerDAG(const std::vector<u3::SU3>& factors)
+    : factors_(factors)
+  {
+    u3::KroneckerProductCache cache;
+    Build(cache);
+  }
+
+  void MultiKroneckerDAG::Build(u3::KroneckerProductCache& cache)
+  {
+    levels_.resize(factors_.size());
+    edges_.resize(factors_.size());
+    if (factors_.empty())
+      return;
+
+    // level 0: first factor
+    levels_[0].push_back(Node{factors_[0],1,0,0});
+
+    // subsequent levels
+    std::map<u3::SU3,std::vector<Edge>> incoming;
+    for (int k=1; k<int(factors_.size()); ++k)
+      {
+        // collect incoming edges for each product irrep
+        incoming.clear();
+        const std::vector<Node>& parents = levels_[k-1];
+        for (int parent=0; parent<int(parents.size()); ++parent)
+          {
+            const KroneckerProductCache::ProductType& product = cache.Get(parents[parent].irrep,factors_[k]);
+            for (const MultiplicityTagged<u3::SU3>& x_rho : product)
+              incoming[x_rho.irrep].push_back(Edge{parent,x_rho.tag});
+          }
+
+        // store nodes and edges (in lexicographic order by irrep)
+        std::vector<Node>& nodes = levels_[k];
+        std::vector<Edge>& edges = edges_[k];
+        nodes.reserve(incoming.size());
+        for (const auto& x_edges : incoming)
+          {
+            Node node{x_edges.first,0,int(edges.size()),0};
+            for (const Edge& edge : x_edges.second)
+              {
+                AccumulateMultiplicity(node.multiplicity,parents[edge.parent].multiplicity,edge.rho_max);
+                edges.push_back(edge);
+              }
+            node.edge_end = int(edges.size());
+            nodes.push_back(node);
+          }
+        edges.shrink_to_fit();
+      }
+  }
+
+  int MultiKroneckerDAG::LookUpNode(int k, const u3::SU3& x) const
+  {
+    const std::vector<Node>& nodes = levels_[k];
+    auto it = std::lower_bound(
+        nodes.begin(),nodes.end(),x,
+        [](const Node& node, const u3::SU3& x) {return node.irrep<x;}
+      );
+    if ((it==nodes.end())||!(it->irrep==x))
+      return -1;
+    return int(it-nodes.begin());
+  }
+
+  MultiplicityTagged<u3::SU3>::vector MultiKroneckerDAG::Decomposition() const
+  {
+    MultiplicityTagged<u3::SU3>::vector decomposition;
+    if (levels_.empty())
+      {
+        decomposition.push_back(MultiplicityTagged<u3::SU3>(u3::SU3(0,0),1));
+        return decomposition;
+      }
+    for (const Node& node : levels_.back())
+      decomposition.push_back(MultiplicityTagged<u3::SU3>(node.irrep,NarrowMultiplicity(node.multiplicity,node.irrep)));
+    return decomposition;
+  }
+
+  std::size_t MultiKroneckerDAG::num_nodes() const
+  {
+    std::size_t count = 0;
+    for (const std::vector<Node>& nodes : levels_)
+      count += nodes.size();
+    return count;
+  }
+
+  std::size_t MultiKroneckerDAG::num_edges() const
+  {
+    std::size_t count = 0;
+    for (const std::vector<Edge>& edges : edges_)
+      count += edges.size();
+    return count;
+  }
+
+}  // namespace
@@ -0,0 +1,332 @@
+/****************************************************************
+  u3product.h
+
+  Memoized SU(3) Kronecker products.
+
+  Mark A. Caprio
+  University of Notre Dame
+
+  SPDX-License-Identifier: MIT
+
+  10/16/26 (mac): Created, with KroneckerProductCache.
+  10/16/26 (mac): Add MultiKroneckerProduct and MultiKroneckerDAG.
+  10/16/26 (mac): Store KroneckerProductCache in ConcurrentCoefCache, for
+    lock-free hits.
+
+****************************************************************/
+
+#ifndef U3PRODUCT_H_
+#define U3PRODUCT_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "boost/functional/hash.hpp"
+
+#include "sp3rlib/concurrent_cache.h"
+#include "sp3rlib/u3.h"
+
+namespace u3
+{
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // Kronecker product cache
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  class KroneckerProductCache
+  // Memoizing cache of SU(3) Kronecker products.
+  //
+  // Products are stored as immutable vectors, keyed by the unordered
+  // pair (x1,x2).  Since x1 x x2 = x2 x x1 (as a list of irreps with
+  // multiplicities), the pair is canonicalized so that both orders
+  // share an entry.
+  //
+  // The table is a ConcurrentCoefCache, so Get is thread-safe, and
+  // hits are lock-free: a thread retrieving an already-cached product
+  // neither takes a lock nor writes to shared memory.  If several
+  // threads miss on the same pair simultaneously, the product is
+  // calculated once, and the others wait for it.  Returned references
+  // remain valid until the cache is cleared or destroyed.
+  //
+  // Hit and miss counts are accumulated for diagnostic purposes.
+  //
+  // EX:
+  //   u3::KroneckerProductCache cache;
+  //   const u3::KroneckerProductCache::ProductType& product
+  //     = cache.Get(u3::SU3(4,2),u3::SU3(2,0));
+  //   for (const MultiplicityTagged<u3::SU3>& x_rho : product)
+  //     ...
+  //   std::cout << cache.HitRate() << std::endl;
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // typedefs
+    ////////////////////////////////////////////////////////////////
+
+    typedef MultiplicityTagged<u3::SU3>::vector ProductType;
+
+    ////////////////////////////////////////////////////////////////
+    // retrieval
+    ////////////////////////////////////////////////////////////////
+
+    const ProductType& Get(const u3::SU3& x1, const u3::SU3& x2)
+    // Retrieve SU(3) Kronecker product, calculating it if not
+    // already cached.
+    //
+    // Irreps are in the same (lexicographic) order as returned by
+    // u3::KroneckerProduct.
+    //
+    // Arguments:
+    //   x1, x2 (u3::SU3) : irreps
+    //
+    // Returns:
+    //   (const ProductType&) : product, valid until the cache is
+    //   cleared or destroyed
+    {
+      const KeyType key = (x2<x1) ? KeyType(x2,x1) : KeyType(x1,x2);
+      return cache_.GetBlock(key).product;
+    }
+
+    template <typename tBuffer>
+      void Get(const u3::U3& omega1, const u3::U3& omega2, tBuffer& product)
+    // Retrieve U(3) Kronecker product into caller-provided buffer.
+    //
+    // The SU(3) product is retrieved from the cache and augmented
+    // with the U(1) label, retaining only valid U(3) irreps, as in
+    // u3::KroneckerProduct.
+    //
+    // Arguments:
+    //   omega1, omega2 (u3::U3) : irreps
+    //   product (tBuffer) : output buffer (e.g.,
+    //     MultiplicityTagged<u3::U3>::vector or u3::U3ProductBuffer),
+    //     cleared and refilled
+    {
+      const ProductType& su3_product = Get(omega1.SU3(),omega2.SU3());
+      const HalfInt N = omega1.N()+omega2.N();
+      product.clear();
+      for (const MultiplicityTagged<u3::SU3>& x_tagged : su3_product)
+        {
+          u3::U3 omega3(N,x_tagged.irrep);
+          if (omega3.Valid())
+            product.push_back(MultiplicityTagged<u3::U3>(omega3,x_tagged.tag));
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // statistics
+    ////////////////////////////////////////////////////////////////
+
+    std::size_t size() const
+    // Return number of cached products.
+    {
+      return cache_.size();
+    }
+
+    long hits() const
+    {
+      return cache_.hits();
+    }
+
+    long misses() const
+    {
+      return cache_.misses();
+    }
+
+    double HitRate() const
+    // Return fraction of lookups which were hits (or 0, if no
+    // lookups have been made).
+    {
+      long hits = cache_.hits(), misses = cache_.misses();
+      return (hits+misses) ? double(hits)/(hits+misses) : 0.;
+    }
+
+    void clear()
+    // Release all cached products and reset counters.
+    //
+    // Not thread-safe.  Invalidates all references to products.
+    {
+      cache_.clear();
+      cache_.ResetStats();
+    }
+
+  private:
+
+    typedef std::pair<u3::SU3,u3::SU3> KeyType;
+
+    struct ProductBlock
+    // Cache entry holding the product for a canonicalized pair.
+    {
+      ProductBlock() = default;
+
+      explicit ProductBlock(const KeyType& key)
+        : product(u3::KroneckerProduct(key.first,key.second))
+      {}
+
+      std::size_t size() const
+      {
+        return product.size();
+      }
+
+      ProductType product;
+    };
+
+    // products by canonicalized (x1,x2)
+    u3::ConcurrentCoefCache<KeyType,ProductBlock> cache_;
+  };
+
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+  // multi-fold Kronecker product
+  ////////////////////////////////////////////////////////////////
+  ////////////////////////////////////////////////////////////////
+
+  MultiplicityTagged<u3::SU3>::vector MultiKroneckerProduct(
+      const std::vector<u3::SU3>& factors,
+      u3::KroneckerProductCache& cache
+    );
+  // Generate decomposition of multi-fold Kronecker product
+  // x1 x x2 x ... x xk.
+  //
+  // The factors are coupled successively, ((x1 x x2) x x3) x ...,
+  // with multiplicities accumulated at each step, so each distinct
+  // intermediate irrep is coupled to the next factor only once.  The
+  // two-fold products are retrieved from the given cache.
+  //
+  // Arguments:
+  //   factors (std::vector<u3::SU3>) : irreps to couple (an empty
+  //     list gives the trivial product (0,0))
+  //   cache (u3::KroneckerProductCache) : cache for two-fold products
+  //
+  // Multiplicities are accumulated in 64-bit integers, and the run is
+  // aborted if a total multiplicity does not fit in the int tag of the
+  // result.  (For longer chains, the 64-bit multiplicities are
+  // available from the nodes of MultiKroneckerDAG.)
+  //
+  // Returns:
+  //   (MultiplicityTagged<u3::SU3>::vector) : vector with each irrep
+  //   tagged by its total multiplicity, in lexicographic order
+
+  MultiplicityTagged<u3::SU3>::vector MultiKroneckerProduct(const std::vector<u3::SU3>& factors);
+  // Overloaded to use a local cache.
+
+  class MultiKroneckerDAG
+  // Coupling tree for multi-fold Kronecker product, stored as a
+  // directed acyclic graph.
+  //
+  // Level k (k=0,...,num_factors-1) holds one node for each distinct
+  // irrep in x1 x ... x x(k+1), in lexicographic order.  Each node
+  // records its incoming edges, i.e., the nodes at level k-1 which
+  // couple with x(k+1) to this irrep, together with the outer
+  // multiplicity rho_max of that coupling.  A coupling path (the
+  // intermediate irreps and rho labels of a basis state) is thus a
+  // path through the graph, with a choice of rho=1..rho_max on each
+  // edge.  The number of such paths ending on each node (its total
+  // multiplicity) is also stored.
+  //
+  // Identical intermediate irreps arising along different branches
+  // share a single node, so storage is proportional to the number of
+  // distinct intermediate irreps and couplings, rather than to the
+  // number of coupling paths.
+  //
+  // EX:
+  //   u3::MultiKroneckerDAG dag({u3::SU3(2,0),u3::SU3(2,0),u3::SU3(2,0)});
+  //   for (const u3::MultiKroneckerDAG::Node& node : dag.level(2))
+  //     std::cout << node.irrep.Str() << " " << node.multiplicity << std::endl;
+  {
+  public:
+
+    ////////////////////////////////////////////////////////////////
+    // graph elements
+    ////////////////////////////////////////////////////////////////
+
+    struct Edge
+    // Coupling of node at previous level with next factor.
+    {
+      int parent;  // index of node at previous level
+      int rho_max;  // outer multiplicity
+    };
+
+    struct Node
+    // Intermediate irrep.
+    {
+      u3::SU3 irrep;
+      std::int64_t multiplicity;  // number of coupling paths ending on node
+      int edge_begin, edge_end;  // range of incoming edges in level's edge list
+    };
+
+    ////////////////////////////////////////////////////////////////
+    // construction
+    ////////////////////////////////////////////////////////////////
+
+    MultiKroneckerDAG(const std::vector<u3::SU3>& factors, u3::KroneckerProductCache& cache);
+    // Construct coupling graph, retrieving two-fold products from the
+    // given cache.
+
+    explicit MultiKroneckerDAG(const std::vector<u3::SU3>& factors);
+    // Construct coupling graph, using a local cache.
+
+    ////////////////////////////////////////////////////////////////
+    // accessors
+    ////////////////////////////////////////////////////////////////
+
+    int num_levels() const
+    {
+      return int(levels_.size());
+    }
+
+    const u3::SU3& factor(int k) const
+    {
+      return factors_[k];
+    }
+
+    const std::vector<Node>& level(int k) const
+    // Return nodes at level k.
+    {
+      return levels_[k];
+    }
+
+    const Edge* edges_begin(int k, const Node& node) const
+    // Return pointer to first incoming edge of node at level k.
+    {
+      return edges_[k].data()+node.edge_begin;
+    }
+
+    const Edge* edges_end(int k, const Node& node) const
+    // Return pointer past last incoming edge of node at level k.
+    {
+      return edges_[k].data()+node.edge_end;
+    }
+
+    int LookUpNode(int k, const u3::SU3& x) const;
+    // Return index of node for irrep x at level k, or -1 if absent.
+
+    MultiplicityTagged<u3::SU3>::vector Decomposition() const;
+    // Return final level as multiplicity-tagged vector (as given by
+    // MultiKroneckerProduct).
+    //
+    // Aborts if a node multiplicity does not fit in the int tag.
+
+    std::size_t num_nodes() const;
+    std::size_t num_edges() const;
+
+  private:
+
+    void Build(u3::KroneckerProductCache& cache);
+
+    // factors
+    std::vector<u3::SU3> factors_;
+
+    // nodes by level
+    std::vector<std::vector<Node>> levels_;
+
+    // incoming edges by level (contiguous for each node)
+    std::vector<std::vector<Edge>> edges_;
+  };
+
+}  // namespace
+
+#endif
@@ -48,8 +48,8 @@ namespace vcs{
           const u3::U3& sigma, const MultiplicityTagged<u3::U3> n_rho, const u3::U3& omega
           )
   {
-    int rho0_max=u3::OuterMultiplicity(omega.SU3(),u3::SU3(2,0),omegap.SU3());
-    int rhon_max=u3::OuterMultiplicity(n_rho.irrep.SU3(),u3::SU3(2,0),np_rhop.irrep.SU3());
+    int rho0_max=u3::OuterMultiplicity<2,0>(omega.SU3(),omegap.SU3());
+    int rhon_max=u3::OuterMultiplicity<2,0>(n_rho.irrep.SU3(),np_rhop.irrep.SU3());
     if ((sigmap==sigma)&&(rho0_max>0)&&(rhon_max>0))
       {  
         
@@ -67,6 +67,7 @@ namespace vcs{
   void GenerateSMatrices(const sp3r::Sp3RSpace& irrep, vcs::SMatrixCache& S_matrix_map, bool sp3r_u3_branch_restricted)
   {
     u3::U3 sigma=irrep.sigma();
+    u3::U3ProductBuffer omega_set;  // reused across subspaces
   
     for(int i=0; i<irrep.size(); i++)
       {
@@ -86,7 +87,7 @@ namespace vcs{
         // general case 
         else 
           {
-            MultiplicityTagged<u3::U3>::vector omega_set=KroneckerProduct(omega_p, u3::U3(0,0,-2));
+            omega_set = u3::KroneckerPreimage<2,0>(u3::U3(2,0,0), omega_p);
             // sum over omega 
             for (int w=0; w<omega_set.size(); w++)
               {
@@ -121,7 +122,7 @@ namespace vcs{
                             MultiplicityTagged<u3::U3> n1_rho1=u3_subspace.GetStateLabels(j1);
                             u3::U3 n1(n1_rho1.irrep);
                             double long coef1;
-                            if (u3::OuterMultiplicity(n1.SU3(), u3::SU3(2,0), n1p.SU3())>0)
+                            if (u3::OuterMultiplicity<2,0>(n1.SU3(),n1p.SU3())>0)
                               
                               coef1=(
                                      2./int(n1p.N())
@@ -140,7 +141,7 @@ namespace vcs{
                           {
                             MultiplicityTagged<u3::U3> n2_rho2=u3_subspace.GetStateLabels(j2);
                             u3::U3 n2(n2_rho2.irrep);
-                            if (u3::OuterMultiplicity(n2.SU3(),u3::SU3(2,0), n2p.SU3())>0)
+                            if (u3::OuterMultiplicity<2,0>(n2.SU3(),n2p.SU3())>0)
                               coef2_matrix(j2,i2)=U3BosonCreationRME(sigma, n2p_rho2p, omega_p, sigma, n2_rho2, omega);
                             else
                               coef2_matrix(j2,i2)=0.0;